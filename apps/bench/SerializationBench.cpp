@@ -0,0 +1,828 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+// Serialization benchmark for the /api/players document.
+//
+//   gamestate-bench --sizes=100,1000,5000,10000 --equipment=0,1 --min-time=0.5 --json=bench.json
+//   gamestate-bench --snapshot=realm.cbor --json=bench.json
+//
+// Every variant turns the same synthetic realm into bytes that could go on
+// the wire, starting from the game objects, so DOM construction is included
+// wherever the variant needs a DOM. CPU time is the benchmark thread's CPU
+// clock; allocations are counted by the replaced global operator new below.
+//
+// Snapshots captured from a live server with /api/debug/snapshot replace the
+// synthetic realm. Their players run through the same variants, and every
+// other endpoint document is replayed through the DOM serializers; without
+// game objects, copying the captured DOM stands in for building it.
+
+#include "MachineInfo.h"
+#include "SyntheticRealm.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef GAMESTATE_BENCH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef GAMESTATE_BENCH_ZSTD
+#include <zstd.h>
+#endif
+
+#include <time.h>
+
+using json = nlohmann::json;
+
+// Allocation accounting for the whole binary
+namespace
+{
+    std::atomic<uint64_t> AllocationCount{ 0 };
+    std::atomic<uint64_t> AllocationBytes{ 0 };
+
+    void* CountedAlloc(std::size_t size)
+    {
+        AllocationCount.fetch_add(1, std::memory_order_relaxed);
+        AllocationBytes.fetch_add(size, std::memory_order_relaxed);
+        if (void* ptr = std::malloc(size ? size : 1))
+            return ptr;
+
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(std::size_t size) { return CountedAlloc(size); }
+void* operator new[](std::size_t size) { return CountedAlloc(size); }
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept
+{
+    try { return CountedAlloc(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept
+{
+    try { return CountedAlloc(size); } catch (...) { return nullptr; }
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace
+{
+    uint64_t ThreadCpuNs()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+    }
+
+    // Writes compact JSON straight into a string, no intermediate DOM
+    class JsonWriter
+    {
+    public:
+        explicit JsonWriter(std::string& out) : _out(out) { }
+
+        void BeginObject() { Separator(); _out += '{'; _needComma = false; }
+        void EndObject() { _out += '}'; _needComma = true; }
+        void BeginArray() { Separator(); _out += '['; _needComma = false; }
+        void EndArray() { _out += ']'; _needComma = true; }
+
+        JsonWriter& Key(char const* key)
+        {
+            Separator();
+            _out += '"';
+            _out += key;
+            _out += "\":";
+            _needComma = false;
+            return *this;
+        }
+
+        void Null() { Separator(); _out += "null"; _needComma = true; }
+        void Bool(bool value) { Separator(); _out += value ? "true" : "false"; _needComma = true; }
+
+        template <class T>
+        void Int(T value)
+        {
+            Separator();
+            char buffer[24];
+            char* end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+            _out.append(buffer, end);
+            _needComma = true;
+        }
+
+        void Float(double value)
+        {
+            Separator();
+            _needComma = true;
+            if (!std::isfinite(value))
+            {
+                _out += "null";
+                return;
+            }
+
+            char buffer[32];
+            char* end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+            _out.append(buffer, end);
+            // Keep floats recognizable as such, like nlohmann's "12.0"
+            if (std::find_if(buffer, end, [](char c) { return c == '.' || c == 'e' || c == 'n'; }) == end)
+                _out += ".0";
+        }
+
+        void String(std::string const& value)
+        {
+            Separator();
+            _out += '"';
+            for (char c : value)
+            {
+                switch (c)
+                {
+                    case '"': _out += "\\\""; break;
+                    case '\\': _out += "\\\\"; break;
+                    case '\n': _out += "\\n"; break;
+                    case '\r': _out += "\\r"; break;
+                    case '\t': _out += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20)
+                        {
+                            char escaped[8];
+                            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                            _out += escaped;
+                        }
+                        else
+                            _out += c;
+                }
+            }
+            _out += '"';
+            _needComma = true;
+        }
+
+    private:
+        void Separator()
+        {
+            if (_needComma)
+                _out += ',';
+        }
+
+        std::string& _out;
+        bool _needComma = false;
+    };
+
+    void WriteItem(JsonWriter& w, SyntheticRealm::Item const& item)
+    {
+        w.BeginObject();
+        w.Key("entry").Int(item.Entry);
+        w.Key("count").Int(item.Count);
+        w.Key("name").String(item.Name);
+        w.Key("quality").Int(item.Quality);
+        w.Key("item_level").Int(item.ItemLevel);
+        w.Key("required_level").Int(item.RequiredLevel);
+        w.Key("class").Int(item.Class);
+        w.Key("subclass").Int(item.SubClass);
+        w.Key("inventory_type").Int(item.InventoryType);
+        w.Key("durability").Int(item.Durability);
+        w.Key("max_durability").Int(item.MaxDurability);
+
+        w.Key("stats").BeginArray();
+        for (SyntheticRealm::ItemStat const& stat : item.Stats)
+        {
+            w.BeginObject();
+            w.Key("type").Int(stat.Type);
+            w.Key("value").Int(stat.Value);
+            w.EndObject();
+        }
+        w.EndArray();
+
+        static char const* const resistances[] = { "armor", "holy", "fire", "nature", "frost", "shadow", "arcane" };
+        w.Key("resistances").BeginObject();
+        for (uint32_t i = 0; i < 7; ++i)
+            w.Key(resistances[i]).Int(item.Resistances[i]);
+        w.EndObject();
+
+        if (item.IsWeapon)
+        {
+            w.Key("weapon_data").BeginObject();
+            w.Key("delay").Int(item.Delay);
+            w.Key("dps").Float(item.Dps);
+            w.Key("damages").BeginArray();
+            for (SyntheticRealm::ItemDamage const& damage : item.Damages)
+            {
+                w.BeginObject();
+                w.Key("min").Float(damage.Min);
+                w.Key("max").Float(damage.Max);
+                w.Key("type").Int(damage.Type);
+                w.EndObject();
+            }
+            w.EndArray();
+            w.EndObject();
+        }
+
+        if (!item.Sockets.empty())
+        {
+            w.Key("sockets").BeginArray();
+            for (SyntheticRealm::ItemSocket const& socket : item.Sockets)
+            {
+                w.BeginObject();
+                w.Key("color").Int(socket.Color);
+                w.Key("content").Int(socket.Content);
+                w.EndObject();
+            }
+            w.EndArray();
+            if (item.SocketBonus)
+                w.Key("socket_bonus").Int(item.SocketBonus);
+        }
+
+        if (!item.Spells.empty())
+        {
+            w.Key("spells").BeginArray();
+            for (SyntheticRealm::ItemSpell const& spell : item.Spells)
+            {
+                w.BeginObject();
+                w.Key("spell_id").Int(spell.SpellId);
+                w.Key("trigger").Int(spell.Trigger);
+                w.Key("charges").Int(spell.Charges);
+                w.Key("cooldown").Int(spell.Cooldown);
+                w.EndObject();
+            }
+            w.EndArray();
+        }
+
+        w.Key("item_set").Int(item.ItemSet);
+        w.Key("bonding").Int(item.Bonding);
+        w.Key("stack_size").Int(item.StackSize);
+        w.Key("sell_price").Int(item.SellPrice);
+        w.Key("buy_price").Int(item.BuyPrice);
+        w.EndObject();
+    }
+
+    void WritePlayer(JsonWriter& w, SyntheticRealm::Player const& player, bool includeEquipment)
+    {
+        w.BeginObject();
+        w.Key("name").String(player.Name);
+        w.Key("level").Int(player.Level);
+        w.Key("class").Int(player.Class);
+        w.Key("race").Int(player.Race);
+        w.Key("gender").Int(player.Gender);
+        w.Key("guid").Int(player.Guid);
+        w.Key("zone_id").Int(player.ZoneId);
+        w.Key("area_id").Int(player.AreaId);
+        w.Key("map_id").Int(player.MapId);
+        w.Key("online").Bool(true);
+        w.Key("account_id").Int(player.AccountId);
+        w.Key("account_name").String(player.AccountName);
+        w.Key("latency").Int(player.Latency);
+        w.Key("security_level").Int(player.SecurityLevel);
+
+        if (player.PlayerGuild)
+        {
+            w.Key("guild").BeginObject();
+            w.Key("id").Int(player.PlayerGuild->Id);
+            w.Key("name").String(player.PlayerGuild->Name);
+            w.Key("rank").Int(player.PlayerGuild->Rank);
+            w.EndObject();
+        }
+        else
+            w.Key("guild").Null();
+
+        w.Key("money").Int(player.Money);
+        w.Key("played_time").BeginObject();
+        w.Key("total").Int(player.TotalPlayedTime);
+        w.Key("level").Int(player.LevelPlayedTime);
+        w.EndObject();
+        w.Key("honor_points").Int(player.HonorPoints);
+        w.Key("arena_points").Int(player.ArenaPoints);
+
+        w.Key("position").BeginObject();
+        w.Key("x").Float(player.X);
+        w.Key("y").Float(player.Y);
+        w.Key("z").Float(player.Z);
+        w.Key("orientation").Float(player.Orientation);
+        w.EndObject();
+
+        w.Key("health").BeginObject();
+        w.Key("current").Int(player.Health);
+        w.Key("max").Int(player.MaxHealth);
+        w.EndObject();
+
+        w.Key("power").BeginObject();
+        w.Key("type").Int(player.PowerType);
+        w.Key("current").Int(player.Power);
+        w.Key("max").Int(player.MaxPower);
+        w.EndObject();
+
+        if (player.PlayerGroup)
+        {
+            SyntheticRealm::Group const& group = *player.PlayerGroup;
+            w.Key("group").BeginObject();
+            w.Key("id").Int(group.Id);
+            w.Key("leader_guid").Int(group.LeaderGuid);
+            w.Key("members_count").Int(group.MembersCount);
+            w.Key("is_leader").Bool(group.IsLeader);
+            w.Key("is_assistant").Bool(group.IsAssistant);
+            w.Key("loot_method").Int(group.LootMethod);
+            w.Key("is_raid").Bool(group.IsRaid);
+            w.Key("is_bg_group").Bool(false);
+            w.Key("is_lfg_group").Bool(false);
+            w.EndObject();
+        }
+        else
+            w.Key("group").Null();
+
+        static char const* const attributes[] = { "strength", "agility", "stamina", "intellect", "spirit" };
+        w.Key("stats").BeginObject();
+        for (uint32_t i = 0; i < 5; ++i)
+            w.Key(attributes[i]).Float(player.Attributes[i]);
+        w.Key("average_item_level").Float(player.AverageItemLevel);
+        w.EndObject();
+
+        w.Key("status").BeginObject();
+        w.Key("alive").Bool(player.Alive);
+        w.Key("in_combat").Bool(player.InCombat);
+        w.Key("ghost").Bool(player.Ghost);
+        w.Key("resting").Bool(player.Resting);
+        w.Key("away").Bool(player.Away);
+        w.Key("dnd").Bool(player.Dnd);
+        w.Key("gm").Bool(player.Gm);
+        w.EndObject();
+
+        if (includeEquipment)
+        {
+            w.Key("equipment").BeginObject();
+            for (uint32_t slot = 0; slot < SyntheticRealm::EQUIPMENT_SLOTS; ++slot)
+            {
+                w.Key(SyntheticRealm::SlotNames[slot]);
+                if (player.Equipment[slot])
+                    WriteItem(w, *player.Equipment[slot]);
+                else
+                    w.Null();
+            }
+            w.EndObject();
+        }
+
+        w.EndObject();
+    }
+
+    std::string DirectPlayersResponse(std::vector<SyntheticRealm::Player> const& players, bool includeEquipment)
+    {
+        std::string out;
+        out.reserve(players.size() * (includeEquipment ? 12000 : 900));
+        JsonWriter w(out);
+        w.BeginObject();
+        w.Key("count").Int(players.size());
+        w.Key("players").BeginArray();
+        for (SyntheticRealm::Player const& player : players)
+            WritePlayer(w, player, includeEquipment);
+        w.EndArray();
+        w.EndObject();
+        return out;
+    }
+
+#ifdef GAMESTATE_BENCH_ZLIB
+    // Same settings as httplib's gzip compressor
+    std::string Gzip(std::string const& input)
+    {
+        z_stream stream{};
+        deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY);
+
+        std::string out(deflateBound(&stream, uLong(input.size())), '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        stream.avail_in = uInt(input.size());
+        stream.next_out = reinterpret_cast<Bytef*>(out.data());
+        stream.avail_out = uInt(out.size());
+        deflate(&stream, Z_FINISH);
+        out.resize(stream.total_out);
+        deflateEnd(&stream);
+        return out;
+    }
+#endif
+
+#ifdef GAMESTATE_BENCH_ZSTD
+    std::string Zstd(std::string const& input)
+    {
+        std::string out(ZSTD_compressBound(input.size()), '\0');
+        out.resize(ZSTD_compress(out.data(), out.size(), input.data(), input.size(), 3));
+        return out;
+    }
+#endif
+
+    using Players = std::vector<SyntheticRealm::Player>;
+
+    struct Variant
+    {
+        char const* Name;
+        std::function<size_t(Players const&, bool)> Run;   // returns output bytes
+    };
+
+    std::vector<Variant> Variants()
+    {
+        std::vector<Variant> variants = {
+            { "dom_dump2", [](Players const& p, bool eq) { return SyntheticRealm::PlayersResponse(p, eq).dump(2).size(); } },
+            { "dom_dump", [](Players const& p, bool eq) { return SyntheticRealm::PlayersResponse(p, eq).dump().size(); } },
+            { "direct", [](Players const& p, bool eq) { return DirectPlayersResponse(p, eq).size(); } },
+            { "dom_cbor", [](Players const& p, bool eq) { return json::to_cbor(SyntheticRealm::PlayersResponse(p, eq)).size(); } },
+            { "dom_msgpack", [](Players const& p, bool eq) { return json::to_msgpack(SyntheticRealm::PlayersResponse(p, eq)).size(); } },
+#ifdef GAMESTATE_BENCH_ZLIB
+            { "dom_dump2_gzip", [](Players const& p, bool eq) { return Gzip(SyntheticRealm::PlayersResponse(p, eq).dump(2)).size(); } },
+            { "direct_gzip", [](Players const& p, bool eq) { return Gzip(DirectPlayersResponse(p, eq)).size(); } },
+#endif
+#ifdef GAMESTATE_BENCH_ZSTD
+            { "direct_zstd", [](Players const& p, bool eq) { return Zstd(DirectPlayersResponse(p, eq)).size(); } },
+#endif
+        };
+
+        return variants;
+    }
+
+    using Documents = std::vector<json>;
+
+    struct EndpointVariant
+    {
+        char const* Name;
+        std::function<size_t(json const&)> Run;   // returns output bytes
+    };
+
+    std::vector<EndpointVariant> EndpointVariants()
+    {
+        std::vector<EndpointVariant> variants = {
+            { "dom_dump2", [](json const& doc) { return json(doc).dump(2).size(); } },
+            { "dom_dump", [](json const& doc) { return json(doc).dump().size(); } },
+            { "dom_cbor", [](json const& doc) { return json::to_cbor(json(doc)).size(); } },
+            { "dom_msgpack", [](json const& doc) { return json::to_msgpack(json(doc)).size(); } },
+#ifdef GAMESTATE_BENCH_ZLIB
+            { "dom_dump_gzip", [](json const& doc) { return Gzip(json(doc).dump()).size(); } },
+#endif
+        };
+
+        return variants;
+    }
+
+    struct Snapshot
+    {
+        std::string Label;
+        Players PlayerList;
+        std::vector<std::pair<std::string, Documents>> Endpoints;   // one document per request
+        bool ModelMatches = true;   // PlayerList serializes back to the captured documents
+    };
+
+    std::string FileLabel(std::string const& path)
+    {
+        size_t slash = path.find_last_of("/\\");
+        std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+        size_t dot = name.find('.');
+        return dot == std::string::npos || dot == 0 ? name : name.substr(0, dot);
+    }
+
+    bool LoadSnapshot(std::string const& path, Snapshot& snapshot, std::string& error)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            error = "cannot open " + path;
+            return false;
+        }
+
+        json data = json::from_cbor(file, true, false);
+        if (data.is_discarded() || data.value("format", std::string()) != "gamestate-snapshot")
+        {
+            error = path + " is not a snapshot from /api/debug/snapshot";
+            return false;
+        }
+
+        if (data.value("version", 0) != 1)
+        {
+            error = path + " has unsupported snapshot version " + data.value("version", json()).dump();
+            return false;
+        }
+
+        snapshot.Label = FileLabel(path);
+
+        Documents player, equipment, stats, skills, skillsFull, quests;
+        for (json& entry : data["players"])
+        {
+            json& doc = entry["player"];
+            snapshot.PlayerList.push_back(SyntheticRealm::PlayerFromJson(doc));
+            if (SyntheticRealm::PlayerToJson(snapshot.PlayerList.back(), true) != doc)
+                snapshot.ModelMatches = false;
+
+            equipment.push_back(doc.value("equipment", json::object()));
+            doc.erase("equipment");
+            player.push_back(std::move(doc));
+            stats.push_back(std::move(entry["stats"]));
+            skills.push_back(std::move(entry["skills"]));
+            skillsFull.push_back(std::move(entry["skills_full"]));
+            quests.push_back(std::move(entry["quests"]));
+        }
+
+        snapshot.Endpoints = {
+            { "server", { data["server"] } },
+            { "player", std::move(player) },
+            { "player.stats", std::move(stats) },
+            { "player.equipment", std::move(equipment) },
+            { "player.skills", std::move(skills) },
+            { "player.skills_full", std::move(skillsFull) },
+            { "player.quests", std::move(quests) }
+        };
+
+        return true;
+    }
+
+    struct Options
+    {
+        std::vector<uint32_t> Sizes = { 100, 1000, 5000, 10000 };
+        std::vector<bool> Equipment = { false, true };
+        bool SizesGiven = false;
+        std::vector<std::string> Snapshots;
+        std::vector<std::string> Filter;    // variant names, empty = all
+        double MinTimeSeconds = 0.5;
+        uint32_t MinIterations = 5;
+        uint32_t MaxIterations = 1000;
+        std::string JsonPath;
+    };
+
+    struct Result
+    {
+        std::string Variant;
+        std::string Dataset;    // realm size, or snapshot label plus endpoint
+        uint32_t Players;
+        bool Equipment;
+        std::vector<uint64_t> CpuNs;
+        std::vector<uint64_t> WallNs;
+        uint64_t Allocations = 0;       // per run
+        uint64_t AllocatedBytes = 0;    // per run
+        uint64_t OutputBytes = 0;
+
+        std::string Name() const { return Variant + "/" + Dataset + (Equipment ? "/equipment" : ""); }
+    };
+
+    uint64_t Median(std::vector<uint64_t> values)
+    {
+        if (values.empty())
+            return 0;
+
+        std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+        return values[values.size() / 2];
+    }
+
+    std::vector<std::string> Split(std::string const& value)
+    {
+        std::vector<std::string> result;
+        size_t start = 0;
+        while (start <= value.size())
+        {
+            size_t end = value.find(',', start);
+            if (end == std::string::npos)
+                end = value.size();
+            if (end > start)
+                result.push_back(value.substr(start, end - start));
+            start = end + 1;
+        }
+
+        return result;
+    }
+
+    bool ParseArgs(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+                return false;
+
+            std::string key = arg.substr(2, eq - 2);
+            std::string value = arg.substr(eq + 1);
+
+            try
+            {
+                if (key == "sizes")
+                {
+                    options.SizesGiven = true;
+                    options.Sizes.clear();
+                    for (std::string const& size : Split(value))
+                        options.Sizes.push_back(std::stoul(size));
+                }
+                else if (key == "equipment")
+                {
+                    options.Equipment.clear();
+                    for (std::string const& flag : Split(value))
+                        options.Equipment.push_back(flag != "0");
+                }
+                else if (key == "snapshot") options.Snapshots = Split(value);
+                else if (key == "variants") options.Filter = Split(value);
+                else if (key == "min-time") options.MinTimeSeconds = std::stod(value);
+                else if (key == "min-iterations") options.MinIterations = std::max(1ul, std::stoul(value));
+                else if (key == "max-iterations") options.MaxIterations = std::max(1ul, std::stoul(value));
+                else if (key == "json") options.JsonPath = value;
+                else
+                    return false;
+            }
+            catch (std::exception const&)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // The direct writer must produce the same document as the DOM path
+    bool VerifyDirectWriter(Players const& players)
+    {
+        for (bool equipment : { false, true })
+            if (json::parse(DirectPlayersResponse(players, equipment)) != SyntheticRealm::PlayersResponse(players, equipment))
+                return false;
+
+        return true;
+    }
+
+    bool Selected(Options const& options, char const* variant)
+    {
+        return options.Filter.empty() || std::find(options.Filter.begin(), options.Filter.end(), variant) != options.Filter.end();
+    }
+
+    // Runs one case until both the iteration and time minimums are met
+    void Measure(Result& result, std::function<size_t()> const& run, Options const& options)
+    {
+        // Warm up caches and the allocator
+        result.OutputBytes = run();
+
+        uint64_t totalCpu = 0;
+        uint64_t allocations = 0;
+        uint64_t allocatedBytes = 0;
+        while (result.CpuNs.size() < options.MaxIterations
+            && (result.CpuNs.size() < options.MinIterations || totalCpu < uint64_t(options.MinTimeSeconds * 1e9)))
+        {
+            uint64_t allocBefore = AllocationCount.load(std::memory_order_relaxed);
+            uint64_t bytesBefore = AllocationBytes.load(std::memory_order_relaxed);
+            auto wallStart = std::chrono::steady_clock::now();
+            uint64_t cpuStart = ThreadCpuNs();
+
+            run();
+
+            uint64_t cpu = ThreadCpuNs() - cpuStart;
+            uint64_t wall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wallStart).count();
+            allocations += AllocationCount.load(std::memory_order_relaxed) - allocBefore;
+            allocatedBytes += AllocationBytes.load(std::memory_order_relaxed) - bytesBefore;
+
+            result.CpuNs.push_back(cpu);
+            result.WallNs.push_back(wall);
+            totalCpu += cpu;
+        }
+
+        result.Allocations = allocations / result.CpuNs.size();
+        result.AllocatedBytes = allocatedBytes / result.CpuNs.size();
+
+        std::printf("%-40s %6zu %12.3f %12.3f %12llu %14llu %12llu %10.0f\n", result.Name().c_str(), result.CpuNs.size(),
+            Median(result.CpuNs) / 1e6, Median(result.WallNs) / 1e6, (unsigned long long)result.Allocations,
+            (unsigned long long)result.AllocatedBytes, (unsigned long long)result.OutputBytes,
+            result.Players ? double(result.OutputBytes) / result.Players : 0.0);
+        std::fflush(stdout);
+    }
+
+    void RunPlayers(std::string const& dataset, Players const& players, Options const& options, std::vector<Result>& results)
+    {
+        for (bool equipment : options.Equipment)
+        {
+            for (Variant const& variant : Variants())
+            {
+                if (!Selected(options, variant.Name))
+                    continue;
+
+                Result result{ variant.Name, dataset, uint32_t(players.size()), equipment, {}, {}, 0, 0, 0 };
+                Measure(result, [&]() { return variant.Run(players, equipment); }, options);
+                results.push_back(std::move(result));
+            }
+        }
+    }
+
+    void RunEndpoints(Snapshot const& snapshot, Options const& options, std::vector<Result>& results)
+    {
+        for (auto const& [endpoint, documents] : snapshot.Endpoints)
+        {
+            for (EndpointVariant const& variant : EndpointVariants())
+            {
+                if (!Selected(options, variant.Name))
+                    continue;
+
+                // One run serializes every document once, as if each player had been requested
+                Result result{ variant.Name, snapshot.Label + "/" + endpoint, uint32_t(documents.size()), false, {}, {}, 0, 0, 0 };
+                Measure(result, [&]()
+                {
+                    size_t bytes = 0;
+                    for (json const& document : documents)
+                        bytes += variant.Run(document);
+                    return bytes;
+                }, options);
+                results.push_back(std::move(result));
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseArgs(argc, argv, options))
+    {
+        std::cerr <<
+            "Usage: gamestate-bench [options]\n"
+            "  --sizes=N,...         realm sizes in players (100,1000,5000,10000)\n"
+            "  --equipment=0,1       run without and/or with equipment (0,1)\n"
+            "  --snapshot=PATH,...   replay snapshots from /api/debug/snapshot instead of\n"
+            "                        synthetic realms (unless --sizes is also given)\n"
+            "  --variants=A,...      only run these variants\n"
+            "  --min-time=SECONDS    minimum measured CPU time per case (0.5)\n"
+            "  --min-iterations=N    (5)\n"
+            "  --max-iterations=N    (1000)\n"
+            "  --json=PATH           also write results as JSON, '-' for stdout\n";
+        return 2;
+    }
+
+    if (!VerifyDirectWriter(SyntheticRealm::Generate(50)))
+    {
+        std::cerr << "Direct writer output does not match the DOM output\n";
+        return 1;
+    }
+
+    std::vector<Snapshot> snapshots;
+    for (std::string const& path : options.Snapshots)
+    {
+        Snapshot snapshot;
+        std::string error;
+        if (!LoadSnapshot(path, snapshot, error))
+        {
+            std::cerr << error << "\n";
+            return 1;
+        }
+
+        if (!snapshot.ModelMatches)
+            std::cerr << "Warning: " << path << " has player fields the benchmark model does not know, "
+                "the direct variants serialize a reduced document\n";
+
+        snapshots.push_back(std::move(snapshot));
+    }
+
+    std::vector<Result> results;
+
+    std::printf("%-40s %6s %12s %12s %12s %14s %12s %10s\n", "benchmark", "iters", "cpu ms", "wall ms",
+        "allocs", "alloc bytes", "out bytes", "B/doc");
+
+    // Synthetic realms run unless only snapshots were asked for
+    if (snapshots.empty() || options.SizesGiven)
+        for (uint32_t size : options.Sizes)
+            RunPlayers(std::to_string(size), SyntheticRealm::Generate(size), options, results);
+
+    for (Snapshot const& snapshot : snapshots)
+    {
+        RunPlayers(snapshot.Label, snapshot.PlayerList, options, results);
+        RunEndpoints(snapshot, options, results);
+    }
+
+    if (!options.JsonPath.empty())
+    {
+        json output = { {"machine", MachineInfo()}, {"benchmarks", json::array()} };
+        for (Result const& result : results)
+        {
+            output["benchmarks"].push_back({
+                {"name", result.Name()},
+                {"variant", result.Variant},
+                {"dataset", result.Dataset},
+                {"players", result.Players},
+                {"equipment", result.Equipment},
+                {"iterations", result.CpuNs.size()},
+                {"cpu_ns_median", Median(result.CpuNs)},
+                {"wall_ns_median", Median(result.WallNs)},
+                {"cpu_ns", result.CpuNs},
+                {"wall_ns", result.WallNs},
+                {"allocations", result.Allocations},
+                {"allocated_bytes", result.AllocatedBytes},
+                {"output_bytes", result.OutputBytes}
+            });
+        }
+
+        if (options.JsonPath == "-")
+            std::cout << output.dump(2) << "\n";
+        else
+        {
+            std::ofstream file(options.JsonPath);
+            file << output.dump(2) << "\n";
+            if (!file)
+            {
+                std::cerr << "Failed to write " << options.JsonPath << "\n";
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_TOOLS_HDRHISTOGRAM_H
+#define GAMESTATEAPI_TOOLS_HDRHISTOGRAM_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// Log-linear histogram in the spirit of HdrHistogram: every power of two is
+// split into SUB_BUCKETS linear buckets, so any recorded value is reported
+// with less than 1/SUB_BUCKETS relative error. Values are unsigned integers
+// in whatever unit the caller picks (the tools use microseconds).
+class HdrHistogram
+{
+public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 7;
+    static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr uint32_t HALF = SUB_BUCKETS / 2;
+
+    HdrHistogram() : _counts((64 - SUB_BUCKET_BITS + 2) * HALF, 0) { }
+
+    void Record(uint64_t value, uint64_t count = 1)
+    {
+        _counts[Index(value)] += count;
+        _total += count;
+        _sum += value * count;
+        _min = std::min(_min, value);
+        _max = std::max(_max, value);
+    }
+
+    void Merge(HdrHistogram const& other)
+    {
+        for (size_t i = 0; i < _counts.size(); ++i)
+            _counts[i] += other._counts[i];
+        _total += other._total;
+        _sum += other._sum;
+        _min = std::min(_min, other._min);
+        _max = std::max(_max, other._max);
+    }
+
+    void Reset() { *this = HdrHistogram(); }
+
+    uint64_t Count() const { return _total; }
+    uint64_t Min() const { return _total ? _min : 0; }
+    uint64_t Max() const { return _max; }
+    double Mean() const { return _total ? double(_sum) / double(_total) : 0.0; }
+
+    // Highest value equivalent to the bucket holding the given percentile (0..100)
+    uint64_t Percentile(double percentile) const
+    {
+        if (!_total)
+            return 0;
+
+        uint64_t rank = std::max<uint64_t>(1, uint64_t(percentile / 100.0 * double(_total) + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < _counts.size(); ++i)
+        {
+            seen += _counts[i];
+            if (seen >= rank)
+                return std::min(HighestEquivalent(i), _max);
+        }
+
+        return _max;
+    }
+
+    // Non-empty buckets as (upper bound, count), for exporting the full distribution
+    std::vector<std::pair<uint64_t, uint64_t>> Buckets() const
+    {
+        std::vector<std::pair<uint64_t, uint64_t>> result;
+        for (size_t i = 0; i < _counts.size(); ++i)
+            if (_counts[i])
+                result.emplace_back(std::min(HighestEquivalent(i), _max), _counts[i]);
+
+        return result;
+    }
+
+private:
+    static size_t Index(uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+            return size_t(value);
+
+        // Shift the value so it keeps SUB_BUCKET_BITS significant bits
+        uint32_t magnitude = 63 - uint32_t(std::countl_zero(value)) - (SUB_BUCKET_BITS - 1);
+        uint64_t sub = value >> magnitude;  // in [HALF, SUB_BUCKETS)
+        return size_t(magnitude) * HALF + size_t(sub);
+    }
+
+    static uint64_t HighestEquivalent(size_t index)
+    {
+        if (index < SUB_BUCKETS)
+            return index;
+
+        size_t magnitude = index / HALF - 1;
+        uint64_t sub = index % HALF + HALF;
+        return ((sub + 1) << magnitude) - 1;
+    }
+
+    std::vector<uint64_t> _counts;
+    uint64_t _total = 0;
+    uint64_t _sum = 0;
+    uint64_t _min = UINT64_MAX;
+    uint64_t _max = 0;
+};
+
+#endif // GAMESTATEAPI_TOOLS_HDRHISTOGRAM_H
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_TOOLS_MACHINEINFO_H
+#define GAMESTATEAPI_TOOLS_MACHINEINFO_H
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+
+// Describes the machine and toolchain a result was produced on. Stored in
+// every JSON result so compare_results.py can refuse to trust timings taken
+// on different hardware; allocation counts also depend on the standard
+// library, hence the compiler string.
+inline nlohmann::json MachineInfo()
+{
+#if defined(__clang__)
+    std::string compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    std::string compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    std::string compiler = "msvc " + std::to_string(_MSC_VER);
+#else
+    std::string compiler = "unknown";
+#endif
+
+    return {
+        {"cpus", std::thread::hardware_concurrency()},
+        {"compiler", compiler},
+#ifdef NDEBUG
+        {"optimized", true}
+#else
+        {"optimized", false}
+#endif
+    };
+}
+
+#endif
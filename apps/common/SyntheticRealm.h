@@ -0,0 +1,544 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_TOOLS_SYNTHETICREALM_H
+#define GAMESTATEAPI_TOOLS_SYNTHETICREALM_H
+
+#include <nlohmann/json.hpp>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+// Deterministic stand-in for a populated realm, for tools that run without a
+// worldserver. Players and items carry the same fields, with the same JSON
+// keys, as GameStateUtilities::GetPlayerData and GetItemData.
+namespace SyntheticRealm
+{
+    constexpr uint32_t EQUIPMENT_SLOTS = 19;
+
+    inline char const* const SlotNames[EQUIPMENT_SLOTS] = {
+        "head", "neck", "shoulders", "body", "chest", "waist", "legs", "feet", "wrists", "hands",
+        "finger1", "finger2", "trinket1", "trinket2", "back", "mainhand", "offhand", "ranged", "tabard"
+    };
+
+    struct ItemStat { uint32_t Type; int32_t Value; };
+    struct ItemDamage { float Min; float Max; uint32_t Type; };
+    struct ItemSocket { uint32_t Color; uint32_t Content; };
+    struct ItemSpell { int32_t SpellId; uint32_t Trigger; int32_t Charges; int32_t Cooldown; };
+
+    struct Item
+    {
+        uint32_t Entry = 0;
+        uint32_t Count = 1;
+        std::string Name;
+        uint32_t Quality = 0;
+        uint32_t ItemLevel = 0;
+        uint32_t RequiredLevel = 0;
+        uint32_t Class = 0;
+        uint32_t SubClass = 0;
+        uint32_t InventoryType = 0;
+        uint32_t Durability = 0;
+        uint32_t MaxDurability = 0;
+        std::vector<ItemStat> Stats;
+        std::array<int32_t, 7> Resistances = {}; // armor, holy, fire, nature, frost, shadow, arcane
+        bool IsWeapon = false;
+        uint32_t Delay = 0;
+        float Dps = 0.0f;
+        std::vector<ItemDamage> Damages;
+        std::vector<ItemSocket> Sockets;
+        uint32_t SocketBonus = 0;
+        std::vector<ItemSpell> Spells;
+        uint32_t ItemSet = 0;
+        uint32_t Bonding = 0;
+        uint32_t StackSize = 1;
+        uint32_t SellPrice = 0;
+        uint32_t BuyPrice = 0;
+    };
+
+    struct Guild { uint32_t Id; std::string Name; uint32_t Rank; };
+
+    struct Group
+    {
+        uint32_t Id;
+        uint32_t LeaderGuid;
+        uint32_t MembersCount;
+        bool IsLeader;
+        bool IsAssistant;
+        uint32_t LootMethod;
+        bool IsRaid;
+    };
+
+    struct Player
+    {
+        std::string Name;
+        uint32_t Level = 1;
+        uint32_t Class = 1;
+        uint32_t Race = 1;
+        uint32_t Gender = 0;
+        uint32_t Guid = 0;
+        uint32_t ZoneId = 0;
+        uint32_t AreaId = 0;
+        uint32_t MapId = 0;
+        uint32_t AccountId = 0;
+        std::string AccountName;
+        uint32_t Latency = 0;
+        uint32_t SecurityLevel = 0;
+        std::optional<Guild> PlayerGuild;
+        uint32_t Money = 0;
+        uint32_t TotalPlayedTime = 0;
+        uint32_t LevelPlayedTime = 0;
+        uint32_t HonorPoints = 0;
+        uint32_t ArenaPoints = 0;
+        float X = 0.0f, Y = 0.0f, Z = 0.0f, Orientation = 0.0f;
+        uint32_t Health = 0, MaxHealth = 0;
+        uint32_t PowerType = 0, Power = 0, MaxPower = 0;
+        std::optional<Group> PlayerGroup;
+        std::array<float, 5> Attributes = {};    // strength, agility, stamina, intellect, spirit
+        float AverageItemLevel = 0.0f;
+        bool Alive = true, InCombat = false, Ghost = false, Resting = false, Away = false, Dnd = false, Gm = false;
+        std::array<std::optional<Item>, EQUIPMENT_SLOTS> Equipment;
+    };
+
+    inline std::string RandomName(std::mt19937& rng, uint32_t minSyllables, uint32_t maxSyllables)
+    {
+        static char const* const syllables[] = { "ar", "thas", "jai", "na", "mor", "gan", "ul", "dra", "kel", "zo",
+            "ri", "vash", "el", "dor", "syl", "va", "gar", "rosh", "an", "ith" };
+
+        uint32_t count = std::uniform_int_distribution<uint32_t>(minSyllables, maxSyllables)(rng);
+        std::string name;
+        for (uint32_t i = 0; i < count; ++i)
+            name += syllables[rng() % 20];
+
+        name[0] = char(name[0] - 'a' + 'A');
+        return name;
+    }
+
+    inline Item GenerateItem(std::mt19937& rng, uint32_t slot, uint32_t level)
+    {
+        Item item;
+        item.Entry = 1000 + rng() % 50000;
+        item.Name = RandomName(rng, 2, 3) + (rng() % 2 ? " of the " + RandomName(rng, 1, 2) : std::string(" of Valor"));
+        item.Quality = 2 + rng() % 3;
+        item.ItemLevel = level + rng() % 150;
+        item.RequiredLevel = level;
+        item.InventoryType = slot + 1;
+        item.MaxDurability = slot < 10 ? 60 + rng() % 60 : 0;
+        item.Durability = item.MaxDurability ? item.MaxDurability - rng() % (item.MaxDurability / 2) : 0;
+
+        uint32_t statCount = 2 + rng() % 4;
+        for (uint32_t i = 0; i < statCount; ++i)
+            item.Stats.push_back({ uint32_t(3 + rng() % 45), int32_t(5 + rng() % 120) });
+
+        item.Resistances[0] = slot < 10 ? int32_t(100 + rng() % 2000) : 0;
+
+        if (slot == 15 || slot == 17)
+        {
+            item.IsWeapon = true;
+            item.Class = 2;
+            item.SubClass = rng() % 20;
+            item.Delay = 1500 + rng() % 2300;
+            float min = float(100 + rng() % 400);
+            item.Damages.push_back({ min, min * 1.6f, 0 });
+            item.Dps = (min * 1.3f) / (item.Delay / 1000.0f);
+        }
+        else
+        {
+            item.Class = 4;
+            item.SubClass = rng() % 5;
+        }
+
+        if (rng() % 3 == 0)
+        {
+            uint32_t sockets = 1 + rng() % 3;
+            for (uint32_t i = 0; i < sockets; ++i)
+                item.Sockets.push_back({ 1u << (rng() % 4), 0 });
+            item.SocketBonus = 3000 + rng() % 600;
+        }
+
+        if (rng() % 4 == 0)
+            item.Spells.push_back({ int32_t(10000 + rng() % 60000), 1, 0, -1 });
+
+        item.ItemSet = rng() % 5 == 0 ? 700 + rng() % 200 : 0;
+        item.Bonding = 1 + rng() % 2;
+        item.SellPrice = rng() % 200000;
+        item.BuyPrice = item.SellPrice * 4;
+        return item;
+    }
+
+    inline Player GeneratePlayer(std::mt19937& rng, uint32_t guid)
+    {
+        Player player;
+        player.Name = RandomName(rng, 2, 4);
+        player.Level = rng() % 3 ? 80 : 1 + rng() % 80;
+        player.Class = 1 + rng() % 11;
+        player.Race = 1 + rng() % 11;
+        player.Gender = rng() % 2;
+        player.Guid = guid;
+        player.MapId = rng() % 4 ? 571 : rng() % 700;
+        player.ZoneId = rng() % 5000;
+        player.AreaId = rng() % 5000;
+        player.AccountId = guid + 100;
+        player.AccountName = player.Name;
+        player.Latency = 20 + rng() % 200;
+
+        if (rng() % 10 < 7)
+            player.PlayerGuild = Guild{ uint32_t(1 + rng() % 50), RandomName(rng, 2, 3) + " Vanguard", uint32_t(rng() % 10) };
+
+        player.Money = rng() % 200000000;
+        player.TotalPlayedTime = rng() % 10000000;
+        player.LevelPlayedTime = rng() % 500000;
+        player.HonorPoints = rng() % 75000;
+        player.ArenaPoints = rng() % 5000;
+
+        std::uniform_real_distribution<float> coordinate(-10000.0f, 10000.0f);
+        player.X = coordinate(rng);
+        player.Y = coordinate(rng);
+        player.Z = coordinate(rng) / 100.0f;
+        player.Orientation = std::uniform_real_distribution<float>(0.0f, 6.2831f)(rng);
+
+        player.MaxHealth = 1000 + player.Level * (300 + rng() % 200);
+        player.Health = player.MaxHealth - rng() % (player.MaxHealth / 2);
+        player.PowerType = rng() % 4;
+        player.MaxPower = player.PowerType == 0 ? 5000 + rng() % 20000 : 100;
+        player.Power = player.MaxPower - rng() % (player.MaxPower / 2 + 1);
+
+        if (rng() % 10 < 4)
+            player.PlayerGroup = Group{ uint32_t(1 + rng() % 10000), uint32_t(guid - rng() % 5), uint32_t(2 + rng() % 23), rng() % 5 == 0, rng() % 5 == 0, uint32_t(rng() % 5), rng() % 2 == 0 };
+
+        std::uniform_real_distribution<float> attribute(50.0f, 2000.0f);
+        for (float& value : player.Attributes)
+            value = attribute(rng);
+        player.AverageItemLevel = float(player.Level) * 2.8f;
+
+        player.Alive = rng() % 20 != 0;
+        player.Ghost = !player.Alive && rng() % 2;
+        player.InCombat = rng() % 4 == 0;
+        player.Resting = rng() % 3 == 0;
+        player.Away = rng() % 15 == 0;
+
+        for (uint32_t slot = 0; slot < EQUIPMENT_SLOTS; ++slot)
+            if (rng() % 10 != 0)
+                player.Equipment[slot] = GenerateItem(rng, slot, player.Level);
+
+        return player;
+    }
+
+    inline std::vector<Player> Generate(uint32_t count, uint32_t seed = 12345)
+    {
+        std::mt19937 rng(seed);
+        std::vector<Player> players;
+        players.reserve(count);
+        for (uint32_t i = 0; i < count; ++i)
+            players.push_back(GeneratePlayer(rng, i + 1));
+
+        return players;
+    }
+
+    // Same DOM as GameStateUtilities::GetItemData
+    inline nlohmann::json ItemToJson(Item const& item)
+    {
+        nlohmann::json data = nlohmann::json::object();
+        data["entry"] = item.Entry;
+        data["count"] = item.Count;
+        data["name"] = item.Name;
+        data["quality"] = item.Quality;
+        data["item_level"] = item.ItemLevel;
+        data["required_level"] = item.RequiredLevel;
+        data["class"] = item.Class;
+        data["subclass"] = item.SubClass;
+        data["inventory_type"] = item.InventoryType;
+        data["durability"] = item.Durability;
+        data["max_durability"] = item.MaxDurability;
+
+        nlohmann::json stats = nlohmann::json::array();
+        for (ItemStat const& stat : item.Stats)
+            stats.push_back({ {"type", stat.Type}, {"value", stat.Value} });
+        data["stats"] = stats;
+
+        data["resistances"] = {
+            {"armor", item.Resistances[0]},
+            {"holy", item.Resistances[1]},
+            {"fire", item.Resistances[2]},
+            {"nature", item.Resistances[3]},
+            {"frost", item.Resistances[4]},
+            {"shadow", item.Resistances[5]},
+            {"arcane", item.Resistances[6]}
+        };
+
+        if (item.IsWeapon)
+        {
+            nlohmann::json damages = nlohmann::json::array();
+            for (ItemDamage const& damage : item.Damages)
+                damages.push_back({ {"min", damage.Min}, {"max", damage.Max}, {"type", damage.Type} });
+
+            data["weapon_data"] = { {"delay", item.Delay}, {"dps", item.Dps}, {"damages", damages} };
+        }
+
+        if (!item.Sockets.empty())
+        {
+            nlohmann::json sockets = nlohmann::json::array();
+            for (ItemSocket const& socket : item.Sockets)
+                sockets.push_back({ {"color", socket.Color}, {"content", socket.Content} });
+            data["sockets"] = sockets;
+            if (item.SocketBonus)
+                data["socket_bonus"] = item.SocketBonus;
+        }
+
+        if (!item.Spells.empty())
+        {
+            nlohmann::json spells = nlohmann::json::array();
+            for (ItemSpell const& spell : item.Spells)
+                spells.push_back({ {"spell_id", spell.SpellId}, {"trigger", spell.Trigger}, {"charges", spell.Charges}, {"cooldown", spell.Cooldown} });
+            data["spells"] = spells;
+        }
+
+        data["item_set"] = item.ItemSet;
+        data["bonding"] = item.Bonding;
+        data["stack_size"] = item.StackSize;
+        data["sell_price"] = item.SellPrice;
+        data["buy_price"] = item.BuyPrice;
+        return data;
+    }
+
+    // Same DOM as GameStateUtilities::GetPlayerData
+    inline nlohmann::json PlayerToJson(Player const& player, bool includeEquipment)
+    {
+        nlohmann::json data = nlohmann::json::object();
+        data["name"] = player.Name;
+        data["level"] = player.Level;
+        data["class"] = player.Class;
+        data["race"] = player.Race;
+        data["gender"] = player.Gender;
+        data["guid"] = player.Guid;
+        data["zone_id"] = player.ZoneId;
+        data["area_id"] = player.AreaId;
+        data["map_id"] = player.MapId;
+        data["online"] = true;
+        data["account_id"] = player.AccountId;
+        data["account_name"] = player.AccountName;
+        data["latency"] = player.Latency;
+        data["security_level"] = player.SecurityLevel;
+
+        if (player.PlayerGuild)
+            data["guild"] = { {"id", player.PlayerGuild->Id}, {"name", player.PlayerGuild->Name}, {"rank", player.PlayerGuild->Rank} };
+        else
+            data["guild"] = nullptr;
+
+        data["money"] = player.Money;
+        data["played_time"] = { {"total", player.TotalPlayedTime}, {"level", player.LevelPlayedTime} };
+        data["honor_points"] = player.HonorPoints;
+        data["arena_points"] = player.ArenaPoints;
+        data["position"] = { {"x", player.X}, {"y", player.Y}, {"z", player.Z}, {"orientation", player.Orientation} };
+        data["health"] = { {"current", player.Health}, {"max", player.MaxHealth} };
+        data["power"] = { {"type", player.PowerType}, {"current", player.Power}, {"max", player.MaxPower} };
+
+        if (player.PlayerGroup)
+        {
+            Group const& group = *player.PlayerGroup;
+            data["group"] = {
+                {"id", group.Id},
+                {"leader_guid", group.LeaderGuid},
+                {"members_count", group.MembersCount},
+                {"is_leader", group.IsLeader},
+                {"is_assistant", group.IsAssistant},
+                {"loot_method", group.LootMethod},
+                {"is_raid", group.IsRaid},
+                {"is_bg_group", false},
+                {"is_lfg_group", false}
+            };
+        }
+        else
+            data["group"] = nullptr;
+
+        data["stats"] = {
+            {"strength", player.Attributes[0]},
+            {"agility", player.Attributes[1]},
+            {"stamina", player.Attributes[2]},
+            {"intellect", player.Attributes[3]},
+            {"spirit", player.Attributes[4]},
+            {"average_item_level", player.AverageItemLevel}
+        };
+
+        data["status"] = {
+            {"alive", player.Alive},
+            {"in_combat", player.InCombat},
+            {"ghost", player.Ghost},
+            {"resting", player.Resting},
+            {"away", player.Away},
+            {"dnd", player.Dnd},
+            {"gm", player.Gm}
+        };
+
+        if (includeEquipment)
+        {
+            nlohmann::json equipment = nlohmann::json::object();
+            for (uint32_t slot = 0; slot < EQUIPMENT_SLOTS; ++slot)
+                equipment[SlotNames[slot]] = player.Equipment[slot] ? ItemToJson(*player.Equipment[slot]) : nlohmann::json(nullptr);
+            data["equipment"] = equipment;
+        }
+
+        return data;
+    }
+
+    // Same document as GET /api/players
+    inline nlohmann::json PlayersResponse(std::vector<Player> const& players, bool includeEquipment)
+    {
+        nlohmann::json list = nlohmann::json::array();
+        for (Player const& player : players)
+            list.push_back(PlayerToJson(player, includeEquipment));
+
+        return { {"count", list.size()}, {"players", list} };
+    }
+
+    // Inverse of ItemToJson, for player documents captured from a live server
+    inline Item ItemFromJson(nlohmann::json const& data)
+    {
+        Item item;
+        item.Entry = data.value("entry", 0u);
+        item.Count = data.value("count", 1u);
+        item.Name = data.value("name", std::string());
+        item.Quality = data.value("quality", 0u);
+        item.ItemLevel = data.value("item_level", 0u);
+        item.RequiredLevel = data.value("required_level", 0u);
+        item.Class = data.value("class", 0u);
+        item.SubClass = data.value("subclass", 0u);
+        item.InventoryType = data.value("inventory_type", 0u);
+        item.Durability = data.value("durability", 0u);
+        item.MaxDurability = data.value("max_durability", 0u);
+
+        if (data.contains("stats"))
+            for (nlohmann::json const& stat : data["stats"])
+                item.Stats.push_back({ stat.value("type", 0u), stat.value("value", 0) });
+
+        if (data.contains("resistances"))
+        {
+            static char const* const keys[] = { "armor", "holy", "fire", "nature", "frost", "shadow", "arcane" };
+            for (uint32_t i = 0; i < 7; ++i)
+                item.Resistances[i] = data["resistances"].value(keys[i], 0);
+        }
+
+        if (data.contains("weapon_data"))
+        {
+            nlohmann::json const& weapon = data["weapon_data"];
+            item.IsWeapon = true;
+            item.Delay = weapon.value("delay", 0u);
+            item.Dps = weapon.value("dps", 0.0f);
+            if (weapon.contains("damages"))
+                for (nlohmann::json const& damage : weapon["damages"])
+                    item.Damages.push_back({ damage.value("min", 0.0f), damage.value("max", 0.0f), damage.value("type", 0u) });
+        }
+
+        if (data.contains("sockets"))
+            for (nlohmann::json const& socket : data["sockets"])
+                item.Sockets.push_back({ socket.value("color", 0u), socket.value("content", 0u) });
+        item.SocketBonus = data.value("socket_bonus", 0u);
+
+        if (data.contains("spells"))
+            for (nlohmann::json const& spell : data["spells"])
+                item.Spells.push_back({ spell.value("spell_id", 0), spell.value("trigger", 0u), spell.value("charges", 0), spell.value("cooldown", 0) });
+
+        item.ItemSet = data.value("item_set", 0u);
+        item.Bonding = data.value("bonding", 0u);
+        item.StackSize = data.value("stack_size", 1u);
+        item.SellPrice = data.value("sell_price", 0u);
+        item.BuyPrice = data.value("buy_price", 0u);
+        return item;
+    }
+
+    // Inverse of PlayerToJson. Fields the model does not know are dropped, so
+    // callers should compare PlayerToJson's output against the source document.
+    inline Player PlayerFromJson(nlohmann::json const& data)
+    {
+        Player player;
+        player.Name = data.value("name", std::string());
+        player.Level = data.value("level", 1u);
+        player.Class = data.value("class", 1u);
+        player.Race = data.value("race", 1u);
+        player.Gender = data.value("gender", 0u);
+        player.Guid = data.value("guid", 0u);
+        player.ZoneId = data.value("zone_id", 0u);
+        player.AreaId = data.value("area_id", 0u);
+        player.MapId = data.value("map_id", 0u);
+        player.AccountId = data.value("account_id", 0u);
+        player.AccountName = data.value("account_name", std::string());
+        player.Latency = data.value("latency", 0u);
+        player.SecurityLevel = data.value("security_level", 0u);
+
+        if (data.contains("guild") && data["guild"].is_object())
+        {
+            nlohmann::json const& guild = data["guild"];
+            player.PlayerGuild = Guild{ guild.value("id", 0u), guild.value("name", std::string()), guild.value("rank", 0u) };
+        }
+
+        player.Money = data.value("money", 0u);
+        if (data.contains("played_time"))
+        {
+            player.TotalPlayedTime = data["played_time"].value("total", 0u);
+            player.LevelPlayedTime = data["played_time"].value("level", 0u);
+        }
+        player.HonorPoints = data.value("honor_points", 0u);
+        player.ArenaPoints = data.value("arena_points", 0u);
+
+        if (data.contains("position"))
+        {
+            nlohmann::json const& position = data["position"];
+            player.X = position.value("x", 0.0f);
+            player.Y = position.value("y", 0.0f);
+            player.Z = position.value("z", 0.0f);
+            player.Orientation = position.value("orientation", 0.0f);
+        }
+
+        if (data.contains("health"))
+        {
+            player.Health = data["health"].value("current", 0u);
+            player.MaxHealth = data["health"].value("max", 0u);
+        }
+
+        if (data.contains("power"))
+        {
+            player.PowerType = data["power"].value("type", 0u);
+            player.Power = data["power"].value("current", 0u);
+            player.MaxPower = data["power"].value("max", 0u);
+        }
+
+        if (data.contains("group") && data["group"].is_object())
+        {
+            nlohmann::json const& group = data["group"];
+            player.PlayerGroup = Group{ group.value("id", 0u), group.value("leader_guid", 0u), group.value("members_count", 0u),
+                group.value("is_leader", false), group.value("is_assistant", false), group.value("loot_method", 0u), group.value("is_raid", false) };
+        }
+
+        if (data.contains("stats"))
+        {
+            static char const* const keys[] = { "strength", "agility", "stamina", "intellect", "spirit" };
+            for (uint32_t i = 0; i < 5; ++i)
+                player.Attributes[i] = data["stats"].value(keys[i], 0.0f);
+            player.AverageItemLevel = data["stats"].value("average_item_level", 0.0f);
+        }
+
+        if (data.contains("status"))
+        {
+            nlohmann::json const& status = data["status"];
+            player.Alive = status.value("alive", true);
+            player.InCombat = status.value("in_combat", false);
+            player.Ghost = status.value("ghost", false);
+            player.Resting = status.value("resting", false);
+            player.Away = status.value("away", false);
+            player.Dnd = status.value("dnd", false);
+            player.Gm = status.value("gm", false);
+        }
+
+        if (data.contains("equipment"))
+            for (uint32_t slot = 0; slot < EQUIPMENT_SLOTS; ++slot)
+                if (data["equipment"].contains(SlotNames[slot]) && data["equipment"][SlotNames[slot]].is_object())
+                    player.Equipment[slot] = ItemFromJson(data["equipment"][SlotNames[slot]]);
+
+        return player;
+    }
+}
+
+#endif // GAMESTATEAPI_TOOLS_SYNTHETICREALM_H
@@ -0,0 +1,803 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+// Load generator for the Game State API.
+//
+//   gamestate-loadgen --host=127.0.0.1 --port=8080 --connections=8 --duration=30
+//       --rate=500 --mix=players:4,player:4,server:1,host:1 --keep-alive=1 --gzip=0 --json=result.json
+//
+// Every connection runs on its own thread with its own httplib::Client. With
+// --rate the load is open loop: requests are scheduled at fixed intervals and
+// latency is measured from the scheduled time, so a stalled server shows up in
+// the percentiles instead of silently lowering the request rate.
+//
+//   gamestate-loadgen --replay=gamestate_requests.rec --speed=4 --connections=16
+//
+// Replays a recording made with GameStateAPI.Recorder.Enable, keeping the
+// original request targets and spacing (compressed by --speed). Requests of
+// one recorded client always go out on the same connection.
+
+#include "HdrHistogram.h"
+#include "MachineInfo.h"
+#include "RequestRecordFormat.h"
+#include <yhirose/httplib.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    struct Options
+    {
+        std::string Host = "127.0.0.1";
+        int Port = 8080;
+        uint32_t Connections = 4;
+        double DurationSeconds = 10.0;
+        double WarmupSeconds = 1.0;
+        double Rate = 0.0;             // total requests per second, 0 = as fast as possible
+        std::string Mix = "players:4,player:4,server:1,host:1";
+        std::string Players;           // comma separated, discovered from /api/players when empty
+        bool KeepAlive = true;
+        bool Gzip = false;
+        uint32_t TimeoutMs = 5000;
+        std::string JsonPath;          // "-" for stdout
+        std::string AllocBudgetsPath;  // check per-route allocations against this file
+        std::string ReplayPath;        // request recording to play back instead of the mix
+        double Speed = 1.0;            // replay speed factor
+    };
+
+    struct RouteWeight
+    {
+        std::string Name;
+        uint32_t Weight;
+    };
+
+    // Counters of one route, or of all routes together
+    struct RouteStats
+    {
+        HdrHistogram LatencyUs;
+        uint64_t Requests = 0;
+        uint64_t TransportErrors = 0;
+        uint64_t Status2xx = 0;
+        uint64_t Status4xx = 0;
+        uint64_t Status5xx = 0;
+        uint64_t StatusOther = 0;
+        uint64_t BytesReceived = 0;
+
+        uint64_t Errors() const { return TransportErrors + Status4xx + Status5xx + StatusOther; }
+
+        void Merge(RouteStats const& other)
+        {
+            LatencyUs.Merge(other.LatencyUs);
+            Requests += other.Requests;
+            TransportErrors += other.TransportErrors;
+            Status2xx += other.Status2xx;
+            Status4xx += other.Status4xx;
+            Status5xx += other.Status5xx;
+            StatusOther += other.StatusOther;
+            BytesReceived += other.BytesReceived;
+        }
+    };
+
+    std::vector<std::string> Split(std::string const& value, char separator)
+    {
+        std::vector<std::string> result;
+        std::string current;
+        for (char c : value)
+        {
+            if (c == separator)
+            {
+                if (!current.empty())
+                    result.push_back(current);
+                current.clear();
+            }
+            else
+                current += c;
+        }
+
+        if (!current.empty())
+            result.push_back(current);
+
+        return result;
+    }
+
+    void PrintUsage()
+    {
+        std::cerr <<
+            "Usage: gamestate-loadgen [options]\n"
+            "  --host=ADDR          server address (127.0.0.1)\n"
+            "  --port=N             server port (8080)\n"
+            "  --connections=N      concurrent connections, one thread each (4)\n"
+            "  --duration=SECONDS   measured duration (10)\n"
+            "  --warmup=SECONDS     unmeasured warmup before the run (1)\n"
+            "  --rate=RPS           total request rate, 0 = closed loop (0)\n"
+            "  --mix=ROUTE:W,...    weighted routes: players, player, server, host, health\n"
+            "                       or any literal path starting with '/' (players:4,player:4,server:1,host:1)\n"
+            "  --players=A,B        names used for /api/player/{name}/* (default: online players)\n"
+            "  --keep-alive=0|1     reuse connections (1)\n"
+            "  --gzip=0|1           send Accept-Encoding: gzip (0)\n"
+            "  --timeout-ms=N       connect/read timeout (5000)\n"
+            "  --json=PATH          also write results as JSON, '-' for stdout\n"
+            "  --alloc-budgets=PATH fail when a route allocates more per request than budgeted;\n"
+            "                       needs a server built with GAMESTATE_API_ALLOC_TRACKING\n"
+            "  --replay=PATH        replay a GameStateAPI.Recorder file; --duration, --warmup,\n"
+            "                       --rate, --mix and --players are ignored\n"
+            "  --speed=FACTOR       replay speed, 2 = twice as fast as recorded (1)\n";
+    }
+
+    bool ParseArgs(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "-h" || arg == "--help")
+                return false;
+
+            size_t eq = arg.find('=');
+            if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            {
+                std::cerr << "Unrecognized argument: " << arg << "\n";
+                return false;
+            }
+
+            std::string key = arg.substr(2, eq - 2);
+            std::string value = arg.substr(eq + 1);
+
+            try
+            {
+                if (key == "host") options.Host = value;
+                else if (key == "port") options.Port = std::stoi(value);
+                else if (key == "connections") options.Connections = std::max(1, std::stoi(value));
+                else if (key == "duration") options.DurationSeconds = std::stod(value);
+                else if (key == "warmup") options.WarmupSeconds = std::stod(value);
+                else if (key == "rate") options.Rate = std::stod(value);
+                else if (key == "mix") options.Mix = value;
+                else if (key == "players") options.Players = value;
+                else if (key == "keep-alive") options.KeepAlive = value != "0";
+                else if (key == "gzip") options.Gzip = value != "0";
+                else if (key == "timeout-ms") options.TimeoutMs = std::stoul(value);
+                else if (key == "json") options.JsonPath = value;
+                else if (key == "alloc-budgets") options.AllocBudgetsPath = value;
+                else if (key == "replay") options.ReplayPath = value;
+                else if (key == "speed")
+                {
+                    options.Speed = std::stod(value);
+                    if (!(options.Speed > 0.0))
+                        throw std::invalid_argument("speed");
+                }
+                else
+                {
+                    std::cerr << "Unknown option: --" << key << "\n";
+                    return false;
+                }
+            }
+            catch (std::exception const&)
+            {
+                std::cerr << "Invalid value for --" << key << ": " << value << "\n";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::vector<RouteWeight> ParseMix(std::string const& mix)
+    {
+        std::vector<RouteWeight> routes;
+        for (std::string const& entry : Split(mix, ','))
+        {
+            size_t colon = entry.rfind(':');
+            RouteWeight route{ entry, 1 };
+            if (colon != std::string::npos)
+            {
+                route.Name = entry.substr(0, colon);
+                route.Weight = std::stoul(entry.substr(colon + 1));
+            }
+
+            if (route.Weight)
+                routes.push_back(route);
+        }
+
+        return routes;
+    }
+
+    std::vector<std::string> DiscoverPlayers(Options const& options)
+    {
+        httplib::Client client(options.Host, options.Port);
+        client.set_connection_timeout(std::chrono::milliseconds(options.TimeoutMs));
+        client.set_read_timeout(std::chrono::milliseconds(options.TimeoutMs));
+
+        std::vector<std::string> names;
+        httplib::Result result = client.Get("/api/players");
+        if (!result || result->status != 200)
+            return names;
+
+        json body = json::parse(result->body, nullptr, false);
+        if (body.is_discarded() || !body.contains("players"))
+            return names;
+
+        for (json const& player : body["players"])
+            if (player.contains("name") && player["name"].is_string())
+                names.push_back(player["name"].get<std::string>());
+
+        return names;
+    }
+
+    // Cumulative per-route allocation counters reported by /api/stats/cpu
+    struct ServerRouteCost
+    {
+        uint64_t Requests = 0;
+        uint64_t Allocations = 0;
+    };
+
+    bool FetchRouteCosts(Options const& options, std::map<std::string, ServerRouteCost>& costs, std::string& error)
+    {
+        httplib::Client client(options.Host, options.Port);
+        client.set_read_timeout(std::chrono::milliseconds(options.TimeoutMs));
+
+        httplib::Result result = client.Get("/api/stats/cpu?top=0");
+        if (!result || result->status != 200)
+        {
+            error = "GET /api/stats/cpu failed";
+            return false;
+        }
+
+        json body = json::parse(result->body, nullptr, false);
+        if (body.is_discarded() || !body.value("allocation_tracking", false))
+        {
+            error = "the server does not track allocations, rebuild it with -DGAMESTATE_API_ALLOC_TRACKING=ON";
+            return false;
+        }
+
+        costs.clear();
+        for (json const& route : body["routes"])
+            costs[route["route"].get<std::string>()] = { route["requests"].get<uint64_t>(), route["allocations"].get<uint64_t>() };
+
+        return true;
+    }
+
+    uint64_t FetchPlayerCount(Options const& options)
+    {
+        httplib::Client client(options.Host, options.Port);
+        client.set_read_timeout(std::chrono::milliseconds(options.TimeoutMs));
+
+        httplib::Result result = client.Get("/api/server");
+        if (!result || result->status != 200)
+            return 0;
+
+        json body = json::parse(result->body, nullptr, false);
+        return body.is_discarded() ? 0 : body.value("player_count", uint64_t(0));
+    }
+
+    // Compares the allocations made during the run with the budgets file:
+    //   { "routes": { "/api/players": { "max_per_request": 128, "max_per_player": 320 } } }
+    // Returns false when a route is over budget, and the verdicts in `report`
+    bool CheckAllocBudgets(json const& budgets, std::map<std::string, ServerRouteCost> const& before,
+        std::map<std::string, ServerRouteCost> const& after, uint64_t playerCount, json& report)
+    {
+        bool passed = true;
+        report = json::array();
+
+        std::printf("\n%-36s %9s %14s %14s  %s\n", "allocation budget", "requests", "allocs/req", "budget", "result");
+        for (auto const& [route, budget] : budgets["routes"].items())
+        {
+            auto itr = after.find(route);
+            ServerRouteCost previous = before.count(route) ? before.at(route) : ServerRouteCost();
+            uint64_t requests = itr != after.end() ? itr->second.Requests - previous.Requests : 0;
+
+            double limit = budget.value("max_per_request", 0.0) + budget.value("max_per_player", 0.0) * double(playerCount);
+            if (!requests)
+            {
+                std::printf("%-36s %9s %14s %14.0f  %s\n", route.c_str(), "0", "-", limit, "skipped");
+                report.push_back({ {"route", route}, {"requests", 0}, {"budget", limit}, {"result", "skipped"} });
+                continue;
+            }
+
+            double perRequest = double(itr->second.Allocations - previous.Allocations) / double(requests);
+            bool ok = perRequest <= limit;
+            passed = passed && ok;
+
+            std::printf("%-36s %9llu %14.1f %14.0f  %s\n", route.c_str(), (unsigned long long)requests, perRequest, limit, ok ? "ok" : "OVER BUDGET");
+            report.push_back({ {"route", route}, {"requests", requests}, {"allocations_per_request", perRequest},
+                {"budget", limit}, {"result", ok ? "ok" : "over"} });
+        }
+
+        return passed;
+    }
+
+    // Turns the weighted route names into concrete request paths
+    class RequestPicker
+    {
+    public:
+        RequestPicker(std::vector<RouteWeight> const& routes, std::vector<std::string> const& players, uint32_t seed)
+            : _routes(routes), _players(players), _rng(seed)
+        {
+            for (RouteWeight const& route : _routes)
+                _totalWeight += route.Weight;
+        }
+
+        // Returns the route label used for reporting and fills in the path to request
+        std::string const& Next(std::string& path)
+        {
+            uint32_t pick = std::uniform_int_distribution<uint32_t>(0, _totalWeight - 1)(_rng);
+            RouteWeight const* route = &_routes.front();
+            for (RouteWeight const& candidate : _routes)
+            {
+                if (pick < candidate.Weight)
+                {
+                    route = &candidate;
+                    break;
+                }
+                pick -= candidate.Weight;
+            }
+
+            static char const* const playerSuffixes[] = { "", "/stats", "/equipment", "/skills", "/quests" };
+
+            if (route->Name == "players")
+                path = "/api/players";
+            else if (route->Name == "server")
+                path = "/api/server";
+            else if (route->Name == "host")
+                path = "/api/host";
+            else if (route->Name == "health")
+                path = "/api/health";
+            else if (route->Name == "player")
+            {
+                std::string const& name = _players[_rng() % _players.size()];
+                path = "/api/player/" + httplib::encode_uri_component(name) + playerSuffixes[_playerRequests++ % 5];
+            }
+            else
+                path = route->Name;
+
+            return route->Name;
+        }
+
+    private:
+        std::vector<RouteWeight> const& _routes;
+        std::vector<std::string> const& _players;
+        std::mt19937 _rng;
+        uint32_t _totalWeight = 0;
+        uint64_t _playerRequests = 0;
+    };
+
+    struct WorkerResult
+    {
+        std::map<std::string, RouteStats> Routes;
+    };
+
+    void ConfigureClient(httplib::Client& client, Options const& options)
+    {
+        client.set_keep_alive(options.KeepAlive);
+        client.set_tcp_nodelay(true);
+        client.set_connection_timeout(std::chrono::milliseconds(options.TimeoutMs));
+        client.set_read_timeout(std::chrono::milliseconds(options.TimeoutMs));
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+        client.set_decompress(false);
+#endif
+    }
+
+    void RecordResponse(RouteStats& stats, httplib::Result const& response, Clock::time_point scheduled, Clock::time_point done)
+    {
+        stats.Requests++;
+        stats.LatencyUs.Record(uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(done - scheduled).count()));
+
+        if (!response)
+        {
+            stats.TransportErrors++;
+            return;
+        }
+
+        int status = response->status;
+        if (status >= 200 && status < 300)
+            stats.Status2xx++;
+        else if (status >= 400 && status < 500)
+            stats.Status4xx++;
+        else if (status >= 500)
+            stats.Status5xx++;
+        else
+            stats.StatusOther++;
+
+        stats.BytesReceived += response->body.size();
+    }
+
+    void RunWorker(Options const& options, std::vector<RouteWeight> const& routes, std::vector<std::string> const& players,
+        uint32_t index, Clock::time_point start, Clock::time_point measureFrom, Clock::time_point end, WorkerResult& result)
+    {
+        httplib::Client client(options.Host, options.Port);
+        ConfigureClient(client, options);
+
+        httplib::Headers headers;
+        if (options.Gzip)
+            headers.emplace("Accept-Encoding", "gzip");
+
+        RequestPicker picker(routes, players, 0x9e3779b9u + index);
+
+        // Spread the connections evenly over one interval
+        std::chrono::nanoseconds interval(0);
+        Clock::time_point scheduled = start;
+        if (options.Rate > 0.0)
+        {
+            interval = std::chrono::nanoseconds(int64_t(1e9 * options.Connections / options.Rate));
+            scheduled += interval * index / options.Connections;
+        }
+
+        std::string path;
+        while (true)
+        {
+            if (options.Rate > 0.0)
+            {
+                std::this_thread::sleep_until(scheduled);
+            }
+            else
+                scheduled = Clock::now();
+
+            if (scheduled >= end)
+                break;
+
+            std::string const& route = picker.Next(path);
+            httplib::Result response = client.Get(path, headers);
+            Clock::time_point done = Clock::now();
+
+            if (scheduled >= measureFrom)
+                RecordResponse(result.Routes[route], response, scheduled, done);
+
+            scheduled += interval;
+        }
+    }
+
+    struct ReplayRequest
+    {
+        std::chrono::nanoseconds Offset;   // from the start of the replay
+        std::string Target;
+        std::string Route;
+    };
+
+    // "/api/player/Arthas/stats?x=1" -> "/api/player/{name}/stats", so players group together
+    std::string RouteOfTarget(std::string const& target)
+    {
+        std::string path = target.substr(0, target.find('?'));
+        static std::string const playerPrefix = "/api/player/";
+        if (path.rfind(playerPrefix, 0) != 0)
+            return path;
+
+        size_t nameEnd = path.find('/', playerPrefix.size());
+        return playerPrefix + "{name}" + (nameEnd == std::string::npos ? std::string() : path.substr(nameEnd));
+    }
+
+    // Reads a recording and deals its requests out to the connections by client
+    bool LoadRecording(Options const& options, std::vector<std::vector<ReplayRequest>>& schedules,
+        std::chrono::nanoseconds& span, std::string& error)
+    {
+        using namespace RequestRecord;
+
+        std::ifstream file(options.ReplayPath, std::ios::binary);
+        if (!file)
+        {
+            error = "cannot open " + options.ReplayPath;
+            return false;
+        }
+
+        std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        FileHeader header;
+        if (data.size() < sizeof(header))
+        {
+            error = options.ReplayPath + " is not a request recording";
+            return false;
+        }
+
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (std::memcmp(header.Magic, MAGIC, sizeof(MAGIC)) != 0 || header.Version != VERSION
+            || header.HeaderSize < sizeof(header) || header.Capacity == 0 || header.Capacity % 8 != 0
+            || data.size() < header.HeaderSize || data.size() - header.HeaderSize < header.Capacity
+            || header.Tail > header.Head || header.Head - header.Tail > header.Capacity)
+        {
+            error = options.ReplayPath + " is not a request recording, or of an unsupported version";
+            return false;
+        }
+
+        struct Recorded
+        {
+            uint64_t TimestampUs;
+            uint32_t ClientId;
+            std::string Target;
+        };
+
+        std::vector<Recorded> recorded;
+        char const* ring = data.data() + header.HeaderSize;
+        for (uint64_t offset = header.Tail; offset < header.Head;)
+        {
+            EntryHeader entry{};
+            uint64_t position = offset % header.Capacity;
+            std::memcpy(&entry, ring + position, std::min<uint64_t>(sizeof(entry), header.Capacity - position));
+            // Every entry has to fit in the ring and in [Tail, Head), and a request's target in its entry
+            bool request = entry.TargetLength != FILLER;
+            if (entry.Size == 0 || entry.Size % 8 != 0 || entry.Size > header.Capacity - position || entry.Size > header.Head - offset
+                || (request && (entry.TargetLength > MAX_TARGET_LENGTH || sizeof(entry) + entry.TargetLength > entry.Size)))
+            {
+                error = options.ReplayPath + " is corrupted at offset " + std::to_string(offset);
+                return false;
+            }
+
+            if (request)
+                recorded.push_back({ entry.TimestampUs, entry.ClientId, std::string(ring + position + sizeof(entry), entry.TargetLength) });
+
+            offset += entry.Size;
+        }
+
+        if (recorded.empty())
+        {
+            error = options.ReplayPath + " holds no requests";
+            return false;
+        }
+
+        // Entries are appended when a handler finishes, not in arrival order
+        std::stable_sort(recorded.begin(), recorded.end(), [](Recorded const& a, Recorded const& b) { return a.TimestampUs < b.TimestampUs; });
+
+        uint64_t first = recorded.front().TimestampUs;
+        schedules.assign(options.Connections, {});
+        for (Recorded& request : recorded)
+        {
+            std::chrono::nanoseconds offset(int64_t(double(request.TimestampUs - first) * 1000.0 / options.Speed));
+            std::string route = RouteOfTarget(request.Target);
+            schedules[request.ClientId % options.Connections].push_back({ offset, std::move(request.Target), std::move(route) });
+        }
+
+        span = std::chrono::nanoseconds(int64_t(double(recorded.back().TimestampUs - first) * 1000.0 / options.Speed));
+        return true;
+    }
+
+    void RunReplayWorker(Options const& options, std::vector<ReplayRequest> const& schedule, Clock::time_point start, WorkerResult& result)
+    {
+        httplib::Client client(options.Host, options.Port);
+        ConfigureClient(client, options);
+
+        httplib::Headers headers;
+        if (options.Gzip)
+            headers.emplace("Accept-Encoding", "gzip");
+
+        for (ReplayRequest const& request : schedule)
+        {
+            Clock::time_point scheduled = start + request.Offset;
+            std::this_thread::sleep_until(scheduled);
+
+            httplib::Result response = client.Get(request.Target, headers);
+            RecordResponse(result.Routes[request.Route], response, scheduled, Clock::now());
+        }
+    }
+
+    json LatencyToJson(HdrHistogram const& histogram)
+    {
+        return {
+            {"count", histogram.Count()},
+            {"mean", histogram.Mean()},
+            {"min", histogram.Min()},
+            {"p50", histogram.Percentile(50.0)},
+            {"p90", histogram.Percentile(90.0)},
+            {"p99", histogram.Percentile(99.0)},
+            {"p999", histogram.Percentile(99.9)},
+            {"max", histogram.Max()}
+        };
+    }
+
+    json StatsToJson(RouteStats const& stats, double seconds)
+    {
+        return {
+            {"requests", stats.Requests},
+            {"errors", stats.Errors()},
+            {"throughput_rps", seconds > 0 ? stats.Requests / seconds : 0.0},
+            {"bytes_received", stats.BytesReceived},
+            {"status", {
+                {"2xx", stats.Status2xx},
+                {"4xx", stats.Status4xx},
+                {"5xx", stats.Status5xx},
+                {"other", stats.StatusOther},
+                {"transport_error", stats.TransportErrors}
+            }},
+            {"latency_us", LatencyToJson(stats.LatencyUs)}
+        };
+    }
+
+    void PrintStats(char const* label, RouteStats const& stats, double seconds)
+    {
+        HdrHistogram const& h = stats.LatencyUs;
+        std::printf("%-32s %9llu %7llu %10.1f %9.2f %9.2f %9.2f %9.2f %9.2f\n", label,
+            (unsigned long long)stats.Requests, (unsigned long long)stats.Errors(), seconds > 0 ? stats.Requests / seconds : 0.0,
+            h.Percentile(50.0) / 1000.0, h.Percentile(90.0) / 1000.0, h.Percentile(99.0) / 1000.0,
+            h.Percentile(99.9) / 1000.0, h.Max() / 1000.0);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseArgs(argc, argv, options))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    bool replay = !options.ReplayPath.empty();
+    std::vector<RouteWeight> routes;
+    std::vector<std::string> players;
+    std::vector<std::vector<ReplayRequest>> schedules;
+    std::chrono::nanoseconds replaySpan(0);
+    if (replay)
+    {
+        std::string error;
+        if (!LoadRecording(options, schedules, replaySpan, error))
+        {
+            std::cerr << error << "\n";
+            return 2;
+        }
+    }
+    else
+    {
+        try
+        {
+            routes = ParseMix(options.Mix);
+        }
+        catch (std::exception const&)
+        {
+            std::cerr << "Invalid request mix: " << options.Mix << "\n";
+            return 2;
+        }
+
+        if (routes.empty())
+        {
+            std::cerr << "The request mix is empty\n";
+            return 2;
+        }
+
+        players = Split(options.Players, ',');
+        bool wantsPlayers = std::any_of(routes.begin(), routes.end(), [](RouteWeight const& route) { return route.Name == "player"; });
+        if (wantsPlayers && players.empty())
+        {
+            players = DiscoverPlayers(options);
+            if (players.empty())
+            {
+                std::cerr << "No players given or online, dropping the 'player' route from the mix\n";
+                routes.erase(std::remove_if(routes.begin(), routes.end(), [](RouteWeight const& route) { return route.Name == "player"; }), routes.end());
+                if (routes.empty())
+                    return 2;
+            }
+        }
+    }
+
+    json allocBudgets;
+    std::map<std::string, ServerRouteCost> costsBefore;
+    if (!options.AllocBudgetsPath.empty())
+    {
+        std::ifstream file(options.AllocBudgetsPath);
+        allocBudgets = json::parse(file, nullptr, false);
+        if (allocBudgets.is_discarded() || !allocBudgets.contains("routes"))
+        {
+            std::cerr << "Cannot read allocation budgets from " << options.AllocBudgetsPath << "\n";
+            return 2;
+        }
+
+        std::string error;
+        if (!FetchRouteCosts(options, costsBefore, error))
+        {
+            std::cerr << "Allocation budgets: " << error << "\n";
+            return 2;
+        }
+    }
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point measureFrom = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.WarmupSeconds));
+    Clock::time_point end = measureFrom + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.DurationSeconds));
+
+    std::vector<WorkerResult> results(options.Connections);
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < options.Connections; ++i)
+    {
+        if (replay)
+            workers.emplace_back(RunReplayWorker, std::cref(options), std::cref(schedules[i]), start, std::ref(results[i]));
+        else
+            workers.emplace_back(RunWorker, std::cref(options), std::cref(routes), std::cref(players), i, start, measureFrom, end, std::ref(results[i]));
+    }
+
+    for (std::thread& worker : workers)
+        worker.join();
+
+    // A replay is measured over the whole recording, stragglers included
+    double seconds = replay ? std::max(std::chrono::duration<double>(Clock::now() - start).count(), 1e-3) : options.DurationSeconds;
+
+    RouteStats total;
+    std::map<std::string, RouteStats> byRoute;
+    for (WorkerResult const& result : results)
+    {
+        for (auto const& [route, stats] : result.Routes)
+        {
+            byRoute[route].Merge(stats);
+            total.Merge(stats);
+        }
+    }
+
+    if (replay)
+        std::printf("%s:%d  connections=%u  replay=%s  speed=%gx  keep-alive=%d  gzip=%d  duration=%.1fs (recorded %.1fs)\n\n",
+            options.Host.c_str(), options.Port, options.Connections, options.ReplayPath.c_str(), options.Speed, options.KeepAlive,
+            options.Gzip, seconds, std::chrono::duration<double>(replaySpan).count() * options.Speed);
+    else
+        std::printf("%s:%d  connections=%u  rate=%s  keep-alive=%d  gzip=%d  duration=%.1fs\n\n", options.Host.c_str(), options.Port,
+            options.Connections, options.Rate > 0 ? std::to_string(options.Rate).c_str() : "max", options.KeepAlive, options.Gzip, seconds);
+    std::printf("%-32s %9s %7s %10s %9s %9s %9s %9s %9s\n", "route", "requests", "errors", "req/s", "p50 ms", "p90 ms", "p99 ms", "p99.9 ms", "max ms");
+    for (auto const& [route, stats] : byRoute)
+        PrintStats(route.c_str(), stats, seconds);
+    PrintStats("total", total, seconds);
+    std::printf("\nreceived %.1f MiB\n", total.BytesReceived / (1024.0 * 1024.0));
+
+    bool budgetsPassed = true;
+    json budgetReport;
+    if (!options.AllocBudgetsPath.empty())
+    {
+        std::map<std::string, ServerRouteCost> costsAfter;
+        std::string error;
+        if (!FetchRouteCosts(options, costsAfter, error))
+        {
+            std::cerr << "Allocation budgets: " << error << "\n";
+            return 2;
+        }
+
+        // Warmup requests are included here, the server cannot tell them apart
+        budgetsPassed = CheckAllocBudgets(allocBudgets, costsBefore, costsAfter, FetchPlayerCount(options), budgetReport);
+    }
+
+    if (!options.JsonPath.empty())
+    {
+        json output = {
+            {"machine", MachineInfo()},
+            {"config", {
+                {"host", options.Host},
+                {"port", options.Port},
+                {"connections", options.Connections},
+                {"duration_seconds", options.DurationSeconds},
+                {"warmup_seconds", options.WarmupSeconds},
+                {"rate", options.Rate},
+                {"mix", options.Mix},
+                {"keep_alive", options.KeepAlive},
+                {"gzip", options.Gzip},
+                {"replay", options.ReplayPath},
+                {"speed", options.Speed}
+            }},
+            {"total", StatsToJson(total, seconds)},
+            {"routes", json::object()}
+        };
+
+        for (auto const& [route, stats] : byRoute)
+            output["routes"][route] = StatsToJson(stats, seconds);
+
+        if (!options.AllocBudgetsPath.empty())
+            output["alloc_budgets"] = { {"passed", budgetsPassed}, {"routes", budgetReport} };
+
+        if (options.JsonPath == "-")
+            std::cout << output.dump(2) << "\n";
+        else
+        {
+            std::ofstream file(options.JsonPath);
+            file << output.dump(2) << "\n";
+            if (!file)
+            {
+                std::cerr << "Failed to write " << options.JsonPath << "\n";
+                return 1;
+            }
+        }
+    }
+
+    return total.Requests > 0 && budgetsPassed ? 0 : 1;
+}
@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+// Stand-in federation peer: a synthetic realm behind the routes a federated
+// worldserver reads from its peers.
+//
+//   gamestate-peer --port=8091 --realm=Northrend --players=2000 --seed=7 --interval-ms=2000 --churn=1
+//
+// Serves /api/server, /api/players and /api/players/stream (same lines as
+// GameStateAPI.Stream) for a synthetic realm whose players move every
+// interval, while --churn percent of them log out and are replaced by new
+// ones. Point GameStateAPI.Federation.Peers at a few of these to exercise
+// federation without running several worldservers.
+
+#include "SnapshotStreamFormat.h"
+#include "SyntheticRealm.h"
+#include <yhirose/httplib.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    struct Options
+    {
+        int Port = 8091;
+        std::string Host = "127.0.0.1";
+        std::string Realm = "standin";
+        uint32_t Players = 1000;
+        uint32_t Seed = 12345;
+        uint32_t IntervalMs = 2000;
+        double ChurnPercent = 1.0;     // of the players replaced every interval
+    };
+
+    struct Generation
+    {
+        uint64_t Sequence = 0;
+        int64_t Time = 0;
+        std::vector<SyntheticRealm::Player> Players;
+        std::shared_ptr<SnapshotStream::PlayerMap const> Map;
+        std::string Base;
+        std::string Delta;
+    };
+
+    SnapshotStream::Player ToStreamPlayer(SyntheticRealm::Player const& player)
+    {
+        SnapshotStream::Player result;
+        result.Guid = player.Guid;
+        result.Name = player.Name;
+        result.Level = uint8_t(player.Level);
+        result.Class = uint8_t(player.Class);
+        result.Race = uint8_t(player.Race);
+        result.Gender = uint8_t(player.Gender);
+        result.Map = player.MapId;
+        result.Zone = player.ZoneId;
+        result.Area = player.AreaId;
+        result.X = player.X;
+        result.Y = player.Y;
+        result.Z = player.Z;
+        if (player.PlayerGuild)
+        {
+            result.GuildId = player.PlayerGuild->Id;
+            result.Guild = player.PlayerGuild->Name;
+        }
+        for (uint32_t slot = 0; slot < SnapshotStream::EQUIPMENT_SLOTS; ++slot)
+            result.Equipment[slot] = player.Equipment[slot] ? player.Equipment[slot]->Entry : 0;
+        return result;
+    }
+
+    // Moves the synthetic realm every interval and keeps the latest generation
+    // with its stream lines encoded once, like SnapshotFeed in the module
+    class Realm
+    {
+    public:
+        Realm(Options const& options)
+            : _players(SyntheticRealm::Generate(options.Players, options.Seed)), _churnPercent(options.ChurnPercent),
+            _rng(options.Seed + 1), _nextGuid(options.Players + 1),
+            _epoch(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count())
+        {
+            Publish();
+        }
+
+        int64_t GetEpoch() const { return _epoch; }
+
+        std::shared_ptr<Generation const> GetLatest() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _latest;
+        }
+
+        std::shared_ptr<Generation const> WaitNewer(uint64_t after, std::chrono::milliseconds timeout) const
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait_for(lock, timeout, [this, after]() { return _closed || _latest->Sequence > after; });
+            return _closed || _latest->Sequence <= after ? nullptr : _latest;
+        }
+
+        bool IsClosed() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _closed;
+        }
+
+        void Close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _closed = true;
+            }
+            _condition.notify_all();
+        }
+
+        void Update()
+        {
+            std::uniform_real_distribution<float> step(-5.0f, 5.0f);
+            for (SyntheticRealm::Player& player : _players)
+            {
+                player.X += step(_rng);
+                player.Y += step(_rng);
+                if (player.Level < 80 && _rng() % 50 == 0)
+                    ++player.Level;
+            }
+
+            uint32_t churn = uint32_t(_players.size() * _churnPercent / 100.0);
+            for (uint32_t i = 0; i < churn && !_players.empty(); ++i)
+                _players[_rng() % _players.size()] = SyntheticRealm::GeneratePlayer(_rng, _nextGuid++);
+
+            Publish();
+        }
+
+    private:
+        void Publish()
+        {
+            auto generation = std::make_shared<Generation>();
+            generation->Time = int64_t(std::time(nullptr));
+            generation->Players = _players;
+
+            auto map = std::make_shared<SnapshotStream::PlayerMap>();
+            for (SyntheticRealm::Player const& player : _players)
+                map->emplace(player.Guid, ToStreamPlayer(player));
+            generation->Map = map;
+
+            std::shared_ptr<Generation const> previous = GetLatest();
+            generation->Sequence = previous ? previous->Sequence + 1 : 1;
+            generation->Base = SnapshotStream::Base(_epoch, generation->Sequence, generation->Time, *map);
+            generation->Delta = previous ? SnapshotStream::Delta(_epoch, generation->Sequence, generation->Time, *previous->Map, *map) : generation->Base;
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _latest = std::move(generation);
+            }
+            _condition.notify_all();
+        }
+
+        std::vector<SyntheticRealm::Player> _players;
+        double _churnPercent;
+        std::mt19937 _rng;
+        uint32_t _nextGuid;
+        int64_t _epoch;
+
+        mutable std::mutex _mutex;
+        mutable std::condition_variable _condition;
+        std::shared_ptr<Generation const> _latest;
+        bool _closed = false;
+    };
+
+    void RegisterRoutes(httplib::Server& server, Realm& realm, Options const& options)
+    {
+        server.Get("/api/players", [&realm](httplib::Request const& req, httplib::Response& res) {
+            bool equipment = req.has_param("equipment") && req.get_param_value("equipment") == "true";
+            res.set_content(SyntheticRealm::PlayersResponse(realm.GetLatest()->Players, equipment).dump(2), "application/json");
+        });
+
+        server.Get("/api/server", [&realm, &options](httplib::Request const& /*req*/, httplib::Response& res) {
+            std::shared_ptr<Generation const> latest = realm.GetLatest();
+            json data = {
+                {"realm_name", options.Realm},
+                {"player_count", latest->Players.size()},
+                {"generation", latest->Sequence},
+                {"timestamp", std::time(nullptr)}
+            };
+            res.set_content(data.dump(2), "application/json");
+        });
+
+        server.Get("/api/players/stream", [&realm](httplib::Request const& /*req*/, httplib::Response& res) {
+            uint64_t sent = 0;
+            bool greeted = false;
+            res.set_chunked_content_provider("application/x-ndjson",
+                [&realm, sent, greeted](size_t /*offset*/, httplib::DataSink& sink) mutable
+                {
+                    if (!greeted)
+                    {
+                        greeted = true;
+                        std::string hello = SnapshotStream::Hello(realm.GetEpoch(), 0);
+                        return sink.write(hello.data(), hello.size());
+                    }
+
+                    std::shared_ptr<Generation const> generation = realm.WaitNewer(sent, std::chrono::milliseconds(5000));
+                    if (realm.IsClosed())
+                    {
+                        sink.done();
+                        return true;
+                    }
+
+                    if (!generation)
+                    {
+                        std::string heartbeat = SnapshotStream::Heartbeat(realm.GetEpoch(), sent);
+                        return sink.write(heartbeat.data(), heartbeat.size());
+                    }
+
+                    std::string const& line = sent && generation->Sequence == sent + 1 ? generation->Delta : generation->Base;
+                    sent = generation->Sequence;
+                    return sink.write(line.data(), line.size());
+                });
+        });
+    }
+
+    bool ParseArgs(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+                return false;
+
+            std::string key = arg.substr(2, eq - 2);
+            std::string value = arg.substr(eq + 1);
+
+            try
+            {
+                if (key == "port") options.Port = std::stoi(value);
+                else if (key == "host") options.Host = value;
+                else if (key == "realm") options.Realm = value;
+                else if (key == "players") options.Players = std::max(1ul, std::stoul(value));
+                else if (key == "seed") options.Seed = std::stoul(value);
+                else if (key == "interval-ms") options.IntervalMs = std::max(10ul, std::stoul(value));
+                else if (key == "churn") options.ChurnPercent = std::clamp(std::stod(value), 0.0, 100.0);
+                else
+                    return false;
+            }
+            catch (std::exception const&)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    volatile std::sig_atomic_t Stopping = 0;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseArgs(argc, argv, options))
+    {
+        std::cerr <<
+            "Usage: gamestate-peer [options]\n"
+            "  --port=N             HTTP port (8091)\n"
+            "  --host=ADDRESS       address to listen on (127.0.0.1)\n"
+            "  --realm=NAME         realm name reported by /api/server (standin)\n"
+            "  --players=N          synthetic players online (1000)\n"
+            "  --seed=N             seed of the synthetic realm, use a different one per peer (12345)\n"
+            "  --interval-ms=N      milliseconds between generations (2000)\n"
+            "  --churn=PERCENT      players replaced by new ones every generation (1)\n";
+        return 2;
+    }
+
+    Realm realm(options);
+
+    httplib::Server server;
+    server.set_tcp_nodelay(true);
+    RegisterRoutes(server, realm, options);
+
+    if (!server.bind_to_port(options.Host, options.Port))
+    {
+        std::cerr << "Failed to bind " << options.Host << ":" << options.Port << "\n";
+        return 1;
+    }
+    std::thread serverThread([&server]() { server.listen_after_bind(); });
+
+    std::signal(SIGINT, [](int) { Stopping = 1; });
+    std::signal(SIGTERM, [](int) { Stopping = 1; });
+
+    std::printf("realm %s: %u players, a generation every %u ms, http on %s:%d\n", options.Realm.c_str(), options.Players,
+        options.IntervalMs, options.Host.c_str(), options.Port);
+
+    Clock::time_point next = Clock::now();
+    while (!Stopping)
+    {
+        next += std::chrono::milliseconds(options.IntervalMs);
+        // Short sleeps, a signal handler cannot wake a condition variable
+        while (!Stopping && Clock::now() < next)
+            std::this_thread::sleep_for(std::min<Clock::duration>(next - Clock::now(), std::chrono::milliseconds(100)));
+
+        if (Stopping)
+            break;
+
+        realm.Update();
+        if (next < Clock::now())
+            next = Clock::now();    // do not try to catch up after a slow generation
+    }
+
+    realm.Close();
+    server.stop();
+    serverThread.join();
+    return 0;
+}
@@ -0,0 +1,463 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+// World-tick soak test: does API traffic slow down the game?
+//
+//   gamestate-soak --players=2000 --tick-ms=50 --duration=30 --connections=4 --rate=200 --budget-pct=10
+//
+// A simulated world thread mutates a synthetic realm every tick and publishes
+// an immutable snapshot of it. An in-process httplib server answers the usual
+// routes from the latest snapshot. The run measures tick durations first
+// without API traffic (baseline), then while client threads drive the server
+// at the requested rate (load), and fails when the p99 tick duration under
+// load exceeds the baseline p99 by more than the budget.
+
+#include "HdrHistogram.h"
+#include "SyntheticRealm.h"
+#include <yhirose/httplib.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    struct Options
+    {
+        uint32_t Players = 1000;
+        uint32_t TickMs = 50;
+        double DurationSeconds = 20.0;     // per phase
+        double WarmupSeconds = 2.0;
+        uint32_t Connections = 4;
+        double Rate = 200.0;               // total requests per second during the load phase
+        std::string Mix = "players:2,player:6,server:1,players_equipment:1";
+        double BudgetPercent = 10.0;
+        double BudgetMs = 0.5;             // absolute slack on top of the percentage, against noise on fast ticks
+        int Port = 0;                      // 0 = any free port
+        std::string JsonPath;
+    };
+
+    // What the world thread hands to readers; never modified once published
+    struct Snapshot
+    {
+        uint64_t Tick = 0;
+        std::vector<SyntheticRealm::Player> Players;
+    };
+
+    class World
+    {
+    public:
+        World(uint32_t players, uint32_t tickMs) : _players(SyntheticRealm::Generate(players)), _tickMs(tickMs), _rng(777)
+        {
+            Publish();
+        }
+
+        std::shared_ptr<Snapshot const> GetSnapshot() const
+        {
+            std::lock_guard<std::mutex> lock(_snapshotMutex);
+            return _snapshot;
+        }
+
+        // Records tick durations into `histograms[phase]` until `phase` becomes negative
+        void Run(std::atomic<int>& phase, std::vector<HdrHistogram>& durations, std::vector<uint64_t>& overruns)
+        {
+            Clock::time_point next = Clock::now();
+            while (true)
+            {
+                int current = phase.load(std::memory_order_acquire);
+                if (current < 0)
+                    break;
+
+                Clock::time_point start = Clock::now();
+                Update();
+                Publish();
+                Clock::duration elapsed = Clock::now() - start;
+
+                durations[current].Record(uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+                if (elapsed > std::chrono::milliseconds(_tickMs))
+                    overruns[current]++;
+
+                next += std::chrono::milliseconds(_tickMs);
+                if (next < Clock::now())
+                    next = Clock::now();    // do not try to catch up after an overrun, like World::Update
+                std::this_thread::sleep_until(next);
+            }
+        }
+
+    private:
+        void Update()
+        {
+            std::uniform_real_distribution<float> step(-2.0f, 2.0f);
+            for (SyntheticRealm::Player& player : _players)
+            {
+                player.X += step(_rng);
+                player.Y += step(_rng);
+                player.Orientation = std::uniform_real_distribution<float>(0.0f, 6.2831f)(_rng);
+
+                if (_rng() % 8 == 0)
+                {
+                    player.InCombat = !player.InCombat;
+                    uint32_t damage = _rng() % (player.MaxHealth / 10 + 1);
+                    player.Health = player.Health > damage ? player.Health - damage : player.MaxHealth;
+                }
+
+                if (_rng() % 64 == 0)
+                    player.Money += _rng() % 1000;
+            }
+
+            ++_tick;
+        }
+
+        void Publish()
+        {
+            auto snapshot = std::make_shared<Snapshot>();
+            snapshot->Tick = _tick;
+            snapshot->Players = _players;
+
+            std::lock_guard<std::mutex> lock(_snapshotMutex);
+            _snapshot = std::move(snapshot);
+        }
+
+        std::vector<SyntheticRealm::Player> _players;
+        uint32_t _tickMs;
+        uint64_t _tick = 0;
+        std::mt19937 _rng;
+
+        mutable std::mutex _snapshotMutex;
+        std::shared_ptr<Snapshot const> _snapshot;
+    };
+
+    void RegisterRoutes(httplib::Server& server, World const& world)
+    {
+        server.Get("/api/players", [&world](httplib::Request const& req, httplib::Response& res) {
+            bool equipment = req.has_param("equipment") && req.get_param_value("equipment") == "true";
+            res.set_content(SyntheticRealm::PlayersResponse(world.GetSnapshot()->Players, equipment).dump(2), "application/json");
+        });
+
+        server.Get("/api/player/([^/]+)", [&world](httplib::Request const& req, httplib::Response& res) {
+            std::shared_ptr<Snapshot const> snapshot = world.GetSnapshot();
+            std::string name = req.matches[1];
+            auto itr = std::find_if(snapshot->Players.begin(), snapshot->Players.end(),
+                [&name](SyntheticRealm::Player const& player) { return player.Name == name; });
+
+            if (itr == snapshot->Players.end())
+            {
+                res.status = 404;
+                res.set_content(R"({"error":"Player not found or not online","status":404})", "application/json");
+                return;
+            }
+
+            res.set_content(SyntheticRealm::PlayerToJson(*itr, true).dump(2), "application/json");
+        });
+
+        server.Get("/api/server", [&world](httplib::Request const& /*req*/, httplib::Response& res) {
+            std::shared_ptr<Snapshot const> snapshot = world.GetSnapshot();
+            json data = {
+                {"player_count", snapshot->Players.size()},
+                {"tick", snapshot->Tick},
+                {"timestamp", std::time(nullptr)}
+            };
+            res.set_content(data.dump(2), "application/json");
+        });
+    }
+
+    struct ClientStats
+    {
+        HdrHistogram LatencyUs;
+        uint64_t Requests = 0;
+        uint64_t Errors = 0;
+        uint64_t Bytes = 0;
+    };
+
+    // Open-loop client at a fixed rate, see gamestate-loadgen for the full tool
+    void RunClient(Options const& options, int port, std::vector<std::pair<std::string, uint32_t>> const& mix,
+        std::vector<std::string> const& names, uint32_t index, std::atomic<bool>& stop, ClientStats& stats)
+    {
+        httplib::Client client("127.0.0.1", port);
+        client.set_keep_alive(true);
+        client.set_tcp_nodelay(true);
+        client.set_read_timeout(std::chrono::seconds(10));
+
+        uint32_t totalWeight = 0;
+        for (auto const& [route, weight] : mix)
+            totalWeight += weight;
+
+        std::mt19937 rng(index + 1);
+        std::chrono::nanoseconds interval(int64_t(1e9 * options.Connections / options.Rate));
+        Clock::time_point scheduled = Clock::now() + interval * index / options.Connections;
+
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            std::this_thread::sleep_until(scheduled);
+
+            uint32_t pick = rng() % totalWeight;
+            std::string route = mix.front().first;
+            for (auto const& [name, weight] : mix)
+            {
+                if (pick < weight)
+                {
+                    route = name;
+                    break;
+                }
+                pick -= weight;
+            }
+
+            std::string path;
+            if (route == "players")
+                path = "/api/players";
+            else if (route == "players_equipment")
+                path = "/api/players?equipment=true";
+            else if (route == "player")
+                path = "/api/player/" + names[rng() % names.size()];
+            else
+                path = "/api/server";
+
+            httplib::Result result = client.Get(path);
+            stats.LatencyUs.Record(uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - scheduled).count()));
+            stats.Requests++;
+            if (!result || result->status != 200)
+                stats.Errors++;
+            else
+                stats.Bytes += result->body.size();
+
+            scheduled += interval;
+        }
+    }
+
+    bool ParseArgs(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+                return false;
+
+            std::string key = arg.substr(2, eq - 2);
+            std::string value = arg.substr(eq + 1);
+
+            try
+            {
+                if (key == "players") options.Players = std::max(1ul, std::stoul(value));
+                else if (key == "tick-ms") options.TickMs = std::max(1ul, std::stoul(value));
+                else if (key == "duration") options.DurationSeconds = std::stod(value);
+                else if (key == "warmup") options.WarmupSeconds = std::stod(value);
+                else if (key == "connections") options.Connections = std::max(1ul, std::stoul(value));
+                else if (key == "rate") options.Rate = std::max(0.1, std::stod(value));
+                else if (key == "mix") options.Mix = value;
+                else if (key == "budget-pct") options.BudgetPercent = std::stod(value);
+                else if (key == "budget-ms") options.BudgetMs = std::stod(value);
+                else if (key == "port") options.Port = std::stoi(value);
+                else if (key == "json") options.JsonPath = value;
+                else
+                    return false;
+            }
+            catch (std::exception const&)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::vector<std::pair<std::string, uint32_t>> ParseMix(std::string const& mix)
+    {
+        std::vector<std::pair<std::string, uint32_t>> routes;
+        size_t start = 0;
+        while (start < mix.size())
+        {
+            size_t end = mix.find(',', start);
+            if (end == std::string::npos)
+                end = mix.size();
+
+            std::string entry = mix.substr(start, end - start);
+            size_t colon = entry.find(':');
+            uint32_t weight = colon == std::string::npos ? 1 : std::stoul(entry.substr(colon + 1));
+            if (weight)
+                routes.emplace_back(entry.substr(0, colon), weight);
+            start = end + 1;
+        }
+
+        return routes;
+    }
+
+    json TicksToJson(HdrHistogram const& ticks, uint64_t overruns)
+    {
+        return {
+            {"ticks", ticks.Count()},
+            {"overruns", overruns},
+            {"mean_us", ticks.Mean()},
+            {"p50_us", ticks.Percentile(50.0)},
+            {"p99_us", ticks.Percentile(99.0)},
+            {"p999_us", ticks.Percentile(99.9)},
+            {"max_us", ticks.Max()}
+        };
+    }
+
+    void PrintTicks(char const* phase, HdrHistogram const& ticks, uint64_t overruns)
+    {
+        std::printf("%-10s %8llu %9llu %10.3f %10.3f %10.3f %10.3f\n", phase, (unsigned long long)ticks.Count(),
+            (unsigned long long)overruns, ticks.Percentile(50.0) / 1000.0, ticks.Percentile(99.0) / 1000.0,
+            ticks.Percentile(99.9) / 1000.0, ticks.Max() / 1000.0);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    std::vector<std::pair<std::string, uint32_t>> mix;
+    bool valid = ParseArgs(argc, argv, options);
+    if (valid)
+    {
+        try
+        {
+            mix = ParseMix(options.Mix);
+        }
+        catch (std::exception const&)
+        {
+            valid = false;
+        }
+    }
+
+    if (!valid || mix.empty())
+    {
+        std::cerr <<
+            "Usage: gamestate-soak [options]\n"
+            "  --players=N          synthetic players in the world (1000)\n"
+            "  --tick-ms=N          world tick interval (50)\n"
+            "  --duration=SECONDS   length of each phase (20)\n"
+            "  --warmup=SECONDS     unmeasured ticks before the baseline (2)\n"
+            "  --connections=N      client connections during the load phase (4)\n"
+            "  --rate=RPS           total request rate during the load phase (200)\n"
+            "  --mix=ROUTE:W,...    players, players_equipment, player, server (players:2,player:6,server:1,players_equipment:1)\n"
+            "  --budget-pct=P       allowed p99 tick regression in percent (10)\n"
+            "  --budget-ms=MS       absolute slack added to the budget (0.5)\n"
+            "  --port=N             HTTP port, 0 = any free port (0)\n"
+            "  --json=PATH          also write results as JSON, '-' for stdout\n";
+        return 2;
+    }
+
+    World world(options.Players, options.TickMs);
+
+    httplib::Server server;
+    server.set_tcp_nodelay(true);
+    RegisterRoutes(server, world);
+
+    int port = options.Port ? (server.bind_to_port("127.0.0.1", options.Port) ? options.Port : -1) : server.bind_to_any_port("127.0.0.1");
+    if (port <= 0)
+    {
+        std::cerr << "Failed to bind the HTTP server\n";
+        return 1;
+    }
+    std::thread serverThread([&server]() { server.listen_after_bind(); });
+
+    std::vector<std::string> names;
+    for (SyntheticRealm::Player const& player : world.GetSnapshot()->Players)
+        names.push_back(httplib::encode_uri_component(player.Name));
+
+    enum Phase { PHASE_WARMUP = 0, PHASE_BASELINE = 1, PHASE_LOAD = 2 };
+    std::atomic<int> phase{ PHASE_WARMUP };
+    std::vector<HdrHistogram> ticks(3);
+    std::vector<uint64_t> overruns(3, 0);
+    std::thread worldThread([&]() { world.Run(phase, ticks, overruns); });
+
+    auto sleepSeconds = [](double seconds) { std::this_thread::sleep_for(std::chrono::duration<double>(seconds)); };
+
+    std::printf("world: %u players, %u ms ticks, http on 127.0.0.1:%d\n", options.Players, options.TickMs, port);
+    sleepSeconds(options.WarmupSeconds);
+
+    std::printf("baseline: %.0fs without API traffic\n", options.DurationSeconds);
+    phase.store(PHASE_BASELINE, std::memory_order_release);
+    sleepSeconds(options.DurationSeconds);
+
+    std::printf("load: %.0fs at %.0f req/s over %u connections\n", options.DurationSeconds, options.Rate, options.Connections);
+    std::atomic<bool> stopClients{ false };
+    std::vector<ClientStats> clientStats(options.Connections);
+    std::vector<std::thread> clients;
+    for (uint32_t i = 0; i < options.Connections; ++i)
+        clients.emplace_back(RunClient, std::cref(options), port, std::cref(mix), std::cref(names), i, std::ref(stopClients), std::ref(clientStats[i]));
+
+    phase.store(PHASE_LOAD, std::memory_order_release);
+    sleepSeconds(options.DurationSeconds);
+
+    phase.store(-1, std::memory_order_release);
+    worldThread.join();
+    stopClients.store(true);
+    for (std::thread& client : clients)
+        client.join();
+    server.stop();
+    serverThread.join();
+
+    ClientStats requests;
+    for (ClientStats const& stats : clientStats)
+    {
+        requests.LatencyUs.Merge(stats.LatencyUs);
+        requests.Requests += stats.Requests;
+        requests.Errors += stats.Errors;
+        requests.Bytes += stats.Bytes;
+    }
+
+    double baselineP99 = ticks[PHASE_BASELINE].Percentile(99.0) / 1000.0;
+    double loadP99 = ticks[PHASE_LOAD].Percentile(99.0) / 1000.0;
+    double allowedP99 = baselineP99 * (1.0 + options.BudgetPercent / 100.0) + options.BudgetMs;
+    double regressionPercent = baselineP99 > 0 ? (loadP99 / baselineP99 - 1.0) * 100.0 : 0.0;
+    bool passed = loadP99 <= allowedP99;
+
+    std::printf("\n%-10s %8s %9s %10s %10s %10s %10s\n", "phase", "ticks", "overruns", "p50 ms", "p99 ms", "p99.9 ms", "max ms");
+    PrintTicks("baseline", ticks[PHASE_BASELINE], overruns[PHASE_BASELINE]);
+    PrintTicks("load", ticks[PHASE_LOAD], overruns[PHASE_LOAD]);
+    std::printf("\nrequests: %llu (%llu errors), %.1f req/s, p99 %.2f ms, %.1f MiB\n", (unsigned long long)requests.Requests,
+        (unsigned long long)requests.Errors, requests.Requests / options.DurationSeconds, requests.LatencyUs.Percentile(99.0) / 1000.0,
+        requests.Bytes / (1024.0 * 1024.0));
+    std::printf("p99 tick regression: %+.1f%% (%.3f ms -> %.3f ms, budget %.3f ms): %s\n", regressionPercent, baselineP99, loadP99,
+        allowedP99, passed ? "PASS" : "FAIL");
+
+    if (!options.JsonPath.empty())
+    {
+        json output = {
+            {"config", {
+                {"players", options.Players},
+                {"tick_ms", options.TickMs},
+                {"duration_seconds", options.DurationSeconds},
+                {"connections", options.Connections},
+                {"rate", options.Rate},
+                {"mix", options.Mix},
+                {"budget_pct", options.BudgetPercent},
+                {"budget_ms", options.BudgetMs}
+            }},
+            {"baseline", TicksToJson(ticks[PHASE_BASELINE], overruns[PHASE_BASELINE])},
+            {"load", TicksToJson(ticks[PHASE_LOAD], overruns[PHASE_LOAD])},
+            {"requests", {
+                {"count", requests.Requests},
+                {"errors", requests.Errors},
+                {"bytes", requests.Bytes},
+                {"p50_us", requests.LatencyUs.Percentile(50.0)},
+                {"p99_us", requests.LatencyUs.Percentile(99.0)}
+            }},
+            {"p99_regression_pct", regressionPercent},
+            {"allowed_p99_us", allowedP99 * 1000.0},
+            {"passed", passed}
+        };
+
+        if (options.JsonPath == "-")
+            std::cout << output.dump(2) << "\n";
+        else
+            std::ofstream(options.JsonPath) << output.dump(2) << "\n";
+    }
+
+    return passed ? 0 : 1;
+}
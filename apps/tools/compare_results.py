@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2016+ AzerothCore <www.azerothcore.org>
+# Released under GNU AGPL v3 License: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+#
+
+"""Compare gamestate-bench / gamestate-loadgen JSON results against a baseline.
+
+    compare_results.py --baseline apps/bench/baseline.json --candidate bench.json
+    compare_results.py --baseline base-1.json base-2.json base-3.json --candidate new-1.json new-2.json new-3.json
+
+Benchmark files carry one CPU time sample per iteration, so a single file per
+side is enough. Load generator files carry one value per metric, so pass
+several repeated runs per side. A metric counts as regressed when the
+two-sided Mann-Whitney U test rejects "same distribution" at --alpha and the
+median moved more than --threshold percent in the bad direction. Allocation
+counts are deterministic and are compared exactly.
+
+Exit status: 0 no regression, 1 regression found, 2 usage or input error.
+"""
+
+import argparse
+import json
+import math
+import statistics
+import sys
+
+
+def mann_whitney_u(a, b):
+    """Two-sided p-value of the Mann-Whitney U test, normal approximation with tie correction."""
+    n1, n2 = len(a), len(b)
+    if n1 == 0 or n2 == 0:
+        return 1.0
+
+    combined = sorted([(value, 0) for value in a] + [(value, 1) for value in b])
+    ranks = [0.0] * len(combined)
+    tie_term = 0.0
+    i = 0
+    while i < len(combined):
+        j = i
+        while j + 1 < len(combined) and combined[j + 1][0] == combined[i][0]:
+            j += 1
+        average_rank = (i + j) / 2.0 + 1.0
+        for k in range(i, j + 1):
+            ranks[k] = average_rank
+        ties = j - i + 1
+        tie_term += ties ** 3 - ties
+        i = j + 1
+
+    rank_sum_a = sum(rank for rank, (_, group) in zip(ranks, combined) if group == 0)
+    u = rank_sum_a - n1 * (n1 + 1) / 2.0
+    mean = n1 * n2 / 2.0
+    n = n1 + n2
+    variance = n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1))) if n > 1 else 0.0
+    if variance <= 0:
+        return 1.0
+
+    # Continuity correction
+    z = (abs(u - mean) - 0.5) / math.sqrt(variance)
+    return max(0.0, min(1.0, math.erfc(max(z, 0.0) / math.sqrt(2.0))))
+
+
+class Metric:
+    """Samples of one metric; `higher_is_better` flips the regression direction."""
+
+    def __init__(self, name, higher_is_better=False, exact=False):
+        self.name = name
+        self.higher_is_better = higher_is_better
+        self.exact = exact
+        self.samples = []
+
+
+def collect_bench(document, metrics):
+    for bench in document["benchmarks"]:
+        name = bench["name"]
+        metrics.setdefault(name + " cpu_ns", Metric(name + " cpu_ns")).samples.extend(bench["cpu_ns"])
+        metrics.setdefault(name + " allocations", Metric(name + " allocations", exact=True)).samples.append(bench["allocations"])
+        metrics.setdefault(name + " output_bytes", Metric(name + " output_bytes", exact=True)).samples.append(bench["output_bytes"])
+
+
+def collect_loadgen(document, metrics):
+    sections = [("total", document["total"])] + sorted(document.get("routes", {}).items())
+    for route, stats in sections:
+        latency = stats["latency_us"]
+        for key in ("p50", "p99", "p999"):
+            metric = route + " latency_" + key + "_us"
+            metrics.setdefault(metric, Metric(metric)).samples.append(latency[key])
+
+        metric = route + " throughput_rps"
+        metrics.setdefault(metric, Metric(metric, higher_is_better=True)).samples.append(stats["throughput_rps"])
+
+        metric = route + " errors"
+        metrics.setdefault(metric, Metric(metric, exact=True)).samples.append(stats["errors"])
+
+
+def load(paths):
+    metrics = {}
+    kinds = set()
+    hosts = set()
+    for path in paths:
+        with open(path) as file:
+            document = json.load(file)
+
+        hosts.add(json.dumps(document.get("machine", {}), sort_keys=True))
+        if "benchmarks" in document:
+            kinds.add("bench")
+            collect_bench(document, metrics)
+        elif "total" in document:
+            kinds.add("loadgen")
+            collect_loadgen(document, metrics)
+        else:
+            raise ValueError(path + " is neither a gamestate-bench nor a gamestate-loadgen result")
+
+    if len(kinds) != 1:
+        raise ValueError("cannot mix benchmark and load generator results on one side")
+
+    return kinds.pop(), metrics, hosts
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--baseline", nargs="+", required=True, help="baseline result file(s)")
+    parser.add_argument("--candidate", nargs="+", required=True, help="candidate result file(s)")
+    parser.add_argument("--alpha", type=float, default=0.01, help="significance level (0.01)")
+    parser.add_argument("--threshold", type=float, default=10.0, help="minimum median change in percent to report (10)")
+    parser.add_argument("--filter", default="", help="only compare metrics containing this string")
+    args = parser.parse_args()
+
+    try:
+        base_kind, baseline, base_hosts = load(args.baseline)
+        cand_kind, candidate, cand_hosts = load(args.candidate)
+    except (OSError, ValueError, KeyError) as error:
+        print("error: {}".format(error), file=sys.stderr)
+        return 2
+
+    if base_kind != cand_kind:
+        print("error: baseline is a {} result, candidate a {} result".format(base_kind, cand_kind), file=sys.stderr)
+        return 2
+
+    if base_hosts != cand_hosts:
+        print("warning: baseline and candidate ran on different machines, timings are not comparable\n")
+
+    regressions = 0
+    print("{:<52} {:>14} {:>14} {:>9} {:>9}  {}".format("metric", "baseline", "candidate", "delta", "p-value", "verdict"))
+    for name in sorted(set(baseline) & set(candidate)):
+        if args.filter and args.filter not in name:
+            continue
+
+        base, cand = baseline[name], candidate[name]
+        base_median = statistics.median(base.samples)
+        cand_median = statistics.median(cand.samples)
+        if base_median:
+            delta = (cand_median - base_median) / abs(base_median) * 100.0
+        else:
+            delta = 0.0 if cand_median == base_median else math.inf
+
+        worse = delta < 0 if base.higher_is_better else delta > 0
+        if base.exact:
+            p_value = None
+            significant = cand_median != base_median
+        else:
+            p_value = mann_whitney_u(base.samples, cand.samples)
+            significant = p_value < args.alpha and abs(delta) >= args.threshold
+
+        if not significant:
+            verdict = ""
+        elif worse:
+            verdict = "REGRESSED"
+            regressions += 1
+        else:
+            verdict = "improved"
+
+        print("{:<52} {:>14.6g} {:>14.6g} {:>+8.1f}% {:>9}  {}".format(name, base_median, cand_median, delta,
+            "-" if p_value is None else "{:.2g}".format(p_value), verdict))
+
+    missing = sorted(set(baseline) ^ set(candidate))
+    if missing:
+        print("\nnot compared (only on one side): " + ", ".join(missing))
+
+    if regressions:
+        print("\n{} metric(s) regressed".format(regressions))
+        return 1
+
+    print("\nno regressions")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -13,3 +13,71 @@ target_include_directories(modules
     ${CMAKE_CURRENT_LIST_DIR}/include)
 
 message("  -> Game State API Module: Added utilities, nlohmann/json, and httplib include paths")
+
+# Count heap allocations per API request (replaces the global operator new of
+# worldserver, Linux only), checked by gamestate-loadgen --alloc-budgets
+option(GAMESTATE_API_ALLOC_TRACKING "Count heap allocations per Game State API request" OFF)
+if (GAMESTATE_API_ALLOC_TRACKING)
+  target_compile_definitions(modules PRIVATE GAMESTATE_API_ALLOC_TRACKING)
+  message("  -> Game State API Module: Allocation tracking enabled")
+endif()
+
+# Optional developer tools (load generator, benchmarks), enable with -DGAMESTATE_API_TOOLS=ON
+option(GAMESTATE_API_TOOLS "Build the Game State API load testing and benchmark tools" OFF)
+if (GAMESTATE_API_TOOLS)
+  find_package(Threads REQUIRED)
+
+  add_executable(gamestate-loadgen
+    ${CMAKE_CURRENT_LIST_DIR}/apps/loadgen/LoadGen.cpp)
+  target_include_directories(gamestate-loadgen
+    PRIVATE
+      ${CMAKE_CURRENT_LIST_DIR}/apps/common
+      ${CMAKE_CURRENT_LIST_DIR}/include
+      ${CMAKE_CURRENT_LIST_DIR}/src)
+  target_compile_features(gamestate-loadgen PRIVATE cxx_std_20)
+  target_link_libraries(gamestate-loadgen PRIVATE Threads::Threads)
+
+  add_executable(gamestate-soak
+    ${CMAKE_CURRENT_LIST_DIR}/apps/soak/SoakTest.cpp)
+  target_include_directories(gamestate-soak
+    PRIVATE
+      ${CMAKE_CURRENT_LIST_DIR}/apps/common
+      ${CMAKE_CURRENT_LIST_DIR}/include)
+  target_compile_features(gamestate-soak PRIVATE cxx_std_20)
+  target_link_libraries(gamestate-soak PRIVATE Threads::Threads)
+
+  add_executable(gamestate-bench
+    ${CMAKE_CURRENT_LIST_DIR}/apps/bench/SerializationBench.cpp)
+  target_include_directories(gamestate-bench
+    PRIVATE
+      ${CMAKE_CURRENT_LIST_DIR}/apps/common
+      ${CMAKE_CURRENT_LIST_DIR}/include)
+  target_compile_features(gamestate-bench PRIVATE cxx_std_20)
+
+  # Compressed variants are only benchmarked when the library is around
+  find_package(ZLIB)
+  if (ZLIB_FOUND)
+    target_compile_definitions(gamestate-bench PRIVATE GAMESTATE_BENCH_ZLIB)
+    target_link_libraries(gamestate-bench PRIVATE ZLIB::ZLIB)
+  endif()
+
+  find_path(GAMESTATE_ZSTD_INCLUDE_DIR zstd.h)
+  find_library(GAMESTATE_ZSTD_LIBRARY zstd)
+  if (GAMESTATE_ZSTD_INCLUDE_DIR AND GAMESTATE_ZSTD_LIBRARY)
+    target_compile_definitions(gamestate-bench PRIVATE GAMESTATE_BENCH_ZSTD)
+    target_include_directories(gamestate-bench PRIVATE ${GAMESTATE_ZSTD_INCLUDE_DIR})
+    target_link_libraries(gamestate-bench PRIVATE ${GAMESTATE_ZSTD_LIBRARY})
+  endif()
+
+  add_executable(gamestate-peer
+    ${CMAKE_CURRENT_LIST_DIR}/apps/peer/StandInPeer.cpp)
+  target_include_directories(gamestate-peer
+    PRIVATE
+      ${CMAKE_CURRENT_LIST_DIR}/apps/common
+      ${CMAKE_CURRENT_LIST_DIR}/include
+      ${CMAKE_CURRENT_LIST_DIR}/src)
+  target_compile_features(gamestate-peer PRIVATE cxx_std_20)
+  target_link_libraries(gamestate-peer PRIVATE Threads::Threads)
+
+  message("  -> Game State API Module: Added gamestate-loadgen, gamestate-soak, gamestate-bench and gamestate-peer tools")
+endif()
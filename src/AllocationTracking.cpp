@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "AllocationTracking.h"
+
+#if defined(GAMESTATE_API_ALLOC_TRACKING) && !defined(_WIN32)
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // Constant-initialized, so safe to touch from operator new at any time
+    thread_local uint64 _allocations = 0;
+    thread_local uint64 _allocatedBytes = 0;
+
+    void* TrackedAlloc(std::size_t size)
+    {
+        ++_allocations;
+        _allocatedBytes += size;
+        if (void* ptr = std::malloc(size ? size : 1))
+            return ptr;
+
+        throw std::bad_alloc();
+    }
+
+    void* TrackedAlignedAlloc(std::size_t size, std::align_val_t alignment)
+    {
+        ++_allocations;
+        _allocatedBytes += size;
+
+        std::size_t align = static_cast<std::size_t>(alignment);
+        if (void* ptr = std::aligned_alloc(align, (size + align - 1) / align * align))
+            return ptr;
+
+        throw std::bad_alloc();
+    }
+}
+
+// The operators live in this translation unit next to ThreadCounters(), which
+// the HTTP server references, so the linker always pulls them in
+void* operator new(std::size_t size) { return TrackedAlloc(size); }
+void* operator new[](std::size_t size) { return TrackedAlloc(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return TrackedAlignedAlloc(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return TrackedAlignedAlloc(size, alignment); }
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept
+{
+    try { return TrackedAlloc(size); } catch (...) { return nullptr; }
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept
+{
+    try { return TrackedAlloc(size); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+bool AllocationTracking::IsEnabled()
+{
+    return true;
+}
+
+AllocationTracking::Counters AllocationTracking::ThreadCounters()
+{
+    return { _allocations, _allocatedBytes };
+}
+
+#else
+
+bool AllocationTracking::IsEnabled()
+{
+    return false;
+}
+
+AllocationTracking::Counters AllocationTracking::ThreadCounters()
+{
+    return {};
+}
+
+#endif
@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_ALLOCATIONTRACKING_H
+#define GAMESTATEAPI_ALLOCATIONTRACKING_H
+
+#include "Define.h"
+
+// Per-thread heap allocation counters, fed by a replaced global operator new.
+// Only compiled in with -DGAMESTATE_API_ALLOC_TRACKING=ON (Linux/glibc builds),
+// as it puts an extra TLS increment on every allocation of the whole worldserver.
+namespace AllocationTracking
+{
+    struct Counters
+    {
+        uint64 Allocations = 0;
+        uint64 Bytes = 0;
+    };
+
+    bool IsEnabled();
+
+    // Allocations made by the calling thread so far; all zero when disabled
+    Counters ThreadCounters();
+}
+
+#endif // GAMESTATEAPI_ALLOCATIONTRACKING_H
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "AllocatorStats.h"
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#ifndef _WIN32
+// Resolved only when worldserver is linked against (or preloads) these
+// allocators, otherwise they stay null
+extern "C"
+{
+    int mallctl(char const* name, void* oldp, size_t* oldlenp, void* newp, size_t newlen) __attribute__((weak));
+    int MallocExtension_GetNumericProperty(char const* property, size_t* value) __attribute__((weak));
+}
+#endif
+
+namespace
+{
+#ifndef _WIN32
+    bool CollectJemalloc(AllocatorMetrics& metrics)
+    {
+        if (!mallctl)
+            return false;
+
+        // Statistics are cached until the epoch is advanced
+        uint64_t epoch = 1;
+        size_t epochSize = sizeof(epoch);
+        mallctl("epoch", &epoch, &epochSize, &epoch, epochSize);
+
+        static char const* const stats[] = { "stats.allocated", "stats.active", "stats.metadata",
+            "stats.resident", "stats.mapped", "stats.retained" };
+
+        for (char const* name : stats)
+        {
+            size_t value = 0;
+            size_t size = sizeof(value);
+            if (mallctl(name, &value, &size, nullptr, 0) == 0)
+                metrics.Extra.emplace_back(name, value);
+        }
+
+        for (auto const& [name, value] : metrics.Extra)
+        {
+            if (name == "stats.allocated")
+                metrics.InUseBytes = value;
+            else if (name == "stats.mapped")
+                metrics.ArenaBytes = value;
+        }
+        metrics.FreeBytes = metrics.ArenaBytes > metrics.InUseBytes ? metrics.ArenaBytes - metrics.InUseBytes : 0;
+        metrics.Allocator = "jemalloc";
+        return true;
+    }
+
+    bool CollectTcmalloc(AllocatorMetrics& metrics)
+    {
+        if (!MallocExtension_GetNumericProperty)
+            return false;
+
+        static char const* const properties[] = { "generic.current_allocated_bytes", "generic.heap_size",
+            "tcmalloc.pageheap_free_bytes", "tcmalloc.pageheap_unmapped_bytes",
+            "tcmalloc.current_total_thread_cache_bytes", "tcmalloc.central_cache_free_bytes" };
+
+        for (char const* name : properties)
+        {
+            size_t value = 0;
+            if (MallocExtension_GetNumericProperty(name, &value))
+                metrics.Extra.emplace_back(name, value);
+        }
+
+        for (auto const& [name, value] : metrics.Extra)
+        {
+            if (name == "generic.current_allocated_bytes")
+                metrics.InUseBytes = value;
+            else if (name == "generic.heap_size")
+                metrics.ArenaBytes = value;
+            else if (name == "tcmalloc.pageheap_unmapped_bytes")
+                metrics.ReleasableBytes = value;
+        }
+        metrics.FreeBytes = metrics.ArenaBytes > metrics.InUseBytes ? metrics.ArenaBytes - metrics.InUseBytes : 0;
+        metrics.Allocator = "tcmalloc";
+        return true;
+    }
+#endif
+
+#ifdef __GLIBC__
+    void CollectGlibc(AllocatorMetrics& metrics)
+    {
+#if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33)
+        struct mallinfo2 info = mallinfo2();
+#else
+        // Fields are int and wrap above 2 GB on old glibc
+        struct mallinfo info = mallinfo();
+#endif
+        metrics.ArenaBytes = static_cast<uint64>(info.arena);
+        metrics.MmapBytes = static_cast<uint64>(info.hblkhd);
+        metrics.InUseBytes = static_cast<uint64>(info.uordblks) + static_cast<uint64>(info.hblkhd);
+        metrics.FreeBytes = static_cast<uint64>(info.fordblks);
+        metrics.ReleasableBytes = static_cast<uint64>(info.keepcost);
+        metrics.MmapChunks = static_cast<uint32>(info.hblks);
+        metrics.FreeChunks = static_cast<uint32>(info.ordblks);
+        metrics.Extra.emplace_back("fastbin_free_bytes", static_cast<uint64>(info.fsmblks));
+        metrics.Extra.emplace_back("fastbin_blocks", static_cast<uint64>(info.smblks));
+        metrics.Allocator = "glibc";
+    }
+#endif
+}
+
+namespace AllocatorStats
+{
+    AllocatorMetrics Collect()
+    {
+        AllocatorMetrics metrics;
+        metrics.Timestamp = std::time(nullptr);
+        metrics.Allocator = "unknown";
+
+#ifndef _WIN32
+        // A replacement allocator makes glibc's numbers meaningless, check those first
+        if (CollectJemalloc(metrics) || CollectTcmalloc(metrics))
+        {
+            metrics.Available = true;
+            return metrics;
+        }
+#endif
+
+#ifdef __GLIBC__
+        CollectGlibc(metrics);
+        metrics.Available = true;
+#endif
+
+        return metrics;
+    }
+
+    std::string MallocInfoXml()
+    {
+        std::string xml;
+
+#ifdef __GLIBC__
+        char* buffer = nullptr;
+        size_t size = 0;
+        if (FILE* stream = open_memstream(&buffer, &size))
+        {
+            malloc_info(0, stream);
+            fclose(stream);
+            xml.assign(buffer, size);
+        }
+        std::free(buffer);
+#endif
+
+        return xml;
+    }
+}
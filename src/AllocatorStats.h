@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_ALLOCATORSTATS_H
+#define GAMESTATEAPI_ALLOCATORSTATS_H
+
+#include "Define.h"
+#include <ctime>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Heap statistics of whichever allocator worldserver is running on
+struct AllocatorMetrics
+{
+    bool Available = false;
+    time_t Timestamp = 0;
+    std::string Allocator;      // "glibc", "jemalloc", "tcmalloc" or "unknown"
+
+    uint64 ArenaBytes = 0;      // memory the allocator holds for small allocations
+    uint64 MmapBytes = 0;       // large allocations served directly by mmap
+    uint64 InUseBytes = 0;      // handed out to the application (arena + mmap)
+    uint64 FreeBytes = 0;       // held by the allocator but not in use
+    uint64 ReleasableBytes = 0; // free memory at the top of the heap that trim could return
+    uint32 MmapChunks = 0;
+    uint32 FreeChunks = 0;
+
+    // Allocator specific counters (jemalloc stats.*, tcmalloc properties)
+    std::vector<std::pair<std::string, uint64>> Extra;
+
+    // Share of the allocator's memory that is free; high values mean fragmentation
+    double FragmentationRatio() const
+    {
+        uint64 held = InUseBytes + FreeBytes;
+        return held > 0 ? double(FreeBytes) / double(held) : 0.0;
+    }
+};
+
+namespace AllocatorStats
+{
+    // Snapshot of the current heap statistics. Briefly takes the allocator's
+    // arena locks, so keep it off hot paths.
+    AllocatorMetrics Collect();
+
+    // glibc malloc_info() XML, empty when unavailable
+    std::string MallocInfoXml();
+}
+
+#endif // GAMESTATEAPI_ALLOCATORSTATS_H
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "DatabaseMetrics.h"
+#include "DatabaseEnv.h"
+#include "Log.h"
+#include <algorithm>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace
+{
+    // While a probe is in flight the monitor polls its future this often
+    constexpr std::chrono::milliseconds PROBE_POLL_INTERVAL(2);
+
+    // A probe that has not completed by then is counted as timed out
+    constexpr std::chrono::seconds PROBE_TIMEOUT(30);
+
+    template <class T>
+    std::function<size_t()> QueueSizeOf(DatabaseWorkerPool<T>& pool)
+    {
+        return [&pool]() { return pool.QueueSize(); };
+    }
+
+    template <class T>
+    std::function<QueryCallback()> ProbeOf(DatabaseWorkerPool<T>& pool)
+    {
+        return [&pool]() { return pool.AsyncQuery("SELECT 1"); };
+    }
+}
+
+DatabaseMonitor::DatabaseMonitor(uint32 sampleIntervalMs, uint32 probeIntervalMs, uint32 historySize)
+    : _sampleIntervalMs(std::max<uint32>(sampleIntervalMs, 100)), _probeIntervalMs(probeIntervalMs),
+    _historySize(std::max<uint32>(historySize, 1)), _stopping(false)
+{
+    _pools.resize(3);
+    _pools[0].Name = "auth";
+    _pools[0].QueueSize = QueueSizeOf(LoginDatabase);
+    _pools[0].Probe = ProbeOf(LoginDatabase);
+    _pools[1].Name = "characters";
+    _pools[1].QueueSize = QueueSizeOf(CharacterDatabase);
+    _pools[1].Probe = ProbeOf(CharacterDatabase);
+    _pools[2].Name = "world";
+    _pools[2].QueueSize = QueueSizeOf(WorldDatabase);
+    _pools[2].Probe = ProbeOf(WorldDatabase);
+
+    _queueHistory.resize(_pools.size());
+    _metrics.resize(_pools.size());
+    for (size_t i = 0; i < _pools.size(); ++i)
+        _metrics[i].Name = _pools[i].Name;
+}
+
+DatabaseMonitor::~DatabaseMonitor()
+{
+    Stop();
+}
+
+void DatabaseMonitor::Start()
+{
+    if (_thread.joinable())
+        return;
+
+    _stopping = false;
+    _thread = std::thread([this]()
+    {
+#ifndef _WIN32
+        pthread_setname_np(pthread_self(), "gsapi-dbmon");
+#endif
+        Run();
+    });
+}
+
+void DatabaseMonitor::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_stopMutex);
+        _stopping = true;
+    }
+    _stopCondition.notify_all();
+
+    if (_thread.joinable())
+        _thread.join();
+
+    // Abandon pending probes; their tasks complete into an orphaned future
+    for (Pool& pool : _pools)
+        pool.InFlight.reset();
+}
+
+DatabaseMetrics DatabaseMonitor::GetMetrics() const
+{
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+
+    DatabaseMetrics metrics;
+    metrics.Timestamp = _historyTimestamps.empty() ? 0 : _historyTimestamps.back();
+    metrics.HistoryTimestamps.assign(_historyTimestamps.begin(), _historyTimestamps.end());
+    metrics.Pools = _metrics;
+    for (size_t i = 0; i < metrics.Pools.size(); ++i)
+        metrics.Pools[i].QueueHistory.assign(_queueHistory[i].begin(), _queueHistory[i].end());
+
+    return metrics;
+}
+
+void DatabaseMonitor::Run()
+{
+    auto nextSample = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(_stopMutex);
+    while (!_stopping)
+    {
+        lock.unlock();
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= nextSample)
+        {
+            SampleQueues();
+            nextSample = now + std::chrono::milliseconds(_sampleIntervalMs);
+        }
+
+        bool probing = false;
+        if (_probeIntervalMs)
+        {
+            UpdateProbes(now);
+            probing = std::any_of(_pools.begin(), _pools.end(), [](Pool const& pool) { return pool.InFlight != nullptr; });
+        }
+
+        auto wakeAt = probing ? std::min(nextSample, now + PROBE_POLL_INTERVAL) : nextSample;
+        if (_probeIntervalMs && !probing)
+        {
+            for (Pool const& pool : _pools)
+                wakeAt = std::min(wakeAt, pool.NextProbeAt);
+        }
+
+        lock.lock();
+        _stopCondition.wait_until(lock, wakeAt, [this] { return _stopping; });
+    }
+}
+
+void DatabaseMonitor::SampleQueues()
+{
+    std::vector<uint64> sizes;
+    for (Pool const& pool : _pools)
+        sizes.push_back(pool.QueueSize());
+
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+
+    _historyTimestamps.push_back(std::time(nullptr));
+    if (_historyTimestamps.size() > _historySize)
+        _historyTimestamps.pop_front();
+
+    for (size_t i = 0; i < _pools.size(); ++i)
+    {
+        _metrics[i].QueueSize = sizes[i];
+        _metrics[i].PeakQueueSize = std::max(_metrics[i].PeakQueueSize, sizes[i]);
+
+        _queueHistory[i].push_back(static_cast<uint32>(std::min<uint64>(sizes[i], UINT32_MAX)));
+        if (_queueHistory[i].size() > _historySize)
+            _queueHistory[i].pop_front();
+    }
+}
+
+void DatabaseMonitor::UpdateProbes(std::chrono::steady_clock::time_point now)
+{
+    for (size_t i = 0; i < _pools.size(); ++i)
+    {
+        Pool& pool = _pools[i];
+
+        if (pool.InFlight)
+        {
+            if (pool.InFlight->InvokeIfReady())
+            {
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pool.ProbeSentAt).count();
+                pool.InFlight.reset();
+
+                std::lock_guard<std::mutex> lock(_metricsMutex);
+                _metrics[i].ProbesCompleted++;
+                _metrics[i].LastProbeMs = ms;
+                _metrics[i].ProbeLatency.Record(ms);
+            }
+            else if (now - pool.ProbeSentAt > PROBE_TIMEOUT)
+            {
+                LOG_WARN("module.gamestate_api", "Database probe on the {} pool timed out", pool.Name);
+                pool.InFlight.reset();
+
+                std::lock_guard<std::mutex> lock(_metricsMutex);
+                _metrics[i].ProbesTimedOut++;
+            }
+            continue;
+        }
+
+        if (now < pool.NextProbeAt)
+            continue;
+
+        pool.ProbeSentAt = std::chrono::steady_clock::now();
+        pool.NextProbeAt = pool.ProbeSentAt + std::chrono::milliseconds(_probeIntervalMs);
+        pool.InFlight = std::make_unique<QueryCallback>(pool.Probe().WithCallback([](QueryResult /*result*/) { }));
+
+        std::lock_guard<std::mutex> lock(_metricsMutex);
+        _metrics[i].ProbesSent++;
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_DATABASEMETRICS_H
+#define GAMESTATEAPI_DATABASEMETRICS_H
+
+#include "Define.h"
+#include "LatencyHistogram.h"
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class QueryCallback;
+
+// Async queue state of one DatabaseWorkerPool. The pool does not count the
+// operations it executes, so there is no throughput figure.
+struct DatabasePoolMetrics
+{
+    std::string Name;
+    uint64 QueueSize = 0;
+    uint64 PeakQueueSize = 0;       // since startup
+    std::vector<uint32> QueueHistory; // aligned with DatabaseMetrics::HistoryTimestamps
+
+    // A "SELECT 1" pushed through the async queue measures queue wait + execution
+    uint64 ProbesSent = 0;
+    uint64 ProbesCompleted = 0;
+    uint64 ProbesTimedOut = 0;
+    double LastProbeMs = 0.0;
+    LatencyHistogram ProbeLatency;
+};
+
+struct DatabaseMetrics
+{
+    time_t Timestamp = 0;
+    std::vector<time_t> HistoryTimestamps;
+    std::vector<DatabasePoolMetrics> Pools;
+};
+
+// Samples the auth, characters and world DatabaseWorkerPool queues on its own
+// thread, and periodically times a probe query through each async queue.
+class DatabaseMonitor
+{
+public:
+    DatabaseMonitor(uint32 sampleIntervalMs, uint32 probeIntervalMs, uint32 historySize);
+    ~DatabaseMonitor();
+
+    void Start();
+    void Stop();
+
+    DatabaseMetrics GetMetrics() const;
+
+private:
+    struct Pool
+    {
+        std::string Name;
+        std::function<size_t()> QueueSize;
+        std::function<QueryCallback()> Probe;
+
+        std::unique_ptr<QueryCallback> InFlight;
+        std::chrono::steady_clock::time_point ProbeSentAt;
+        std::chrono::steady_clock::time_point NextProbeAt;
+    };
+
+    void Run();
+    void SampleQueues();
+    void UpdateProbes(std::chrono::steady_clock::time_point now);
+
+    uint32 _sampleIntervalMs;
+    uint32 _probeIntervalMs;
+    uint32 _historySize;
+
+    std::vector<Pool> _pools;
+
+    std::thread _thread;
+    std::mutex _stopMutex;
+    std::condition_variable _stopCondition;
+    bool _stopping;
+
+    mutable std::mutex _metricsMutex;
+    std::deque<time_t> _historyTimestamps;
+    std::vector<std::deque<uint32>> _queueHistory;
+    std::vector<DatabasePoolMetrics> _metrics;
+};
+
+#endif // GAMESTATEAPI_DATABASEMETRICS_H
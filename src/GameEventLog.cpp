@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "GameEventLog.h"
+#include <algorithm>
+#include <chrono>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace
+{
+    char const* const TYPE_NAMES[] = {
+        "login", "logout", "level_change", "death", "zone_change",
+        "quest_complete", "guild_join", "guild_leave", "money_change"
+    };
+    static_assert(std::size(TYPE_NAMES) == size_t(GameEventType::Count), "every event type needs a name");
+}
+
+GameEventLog::Node GameEventLog::_stub;
+std::atomic<GameEventLog::Node*> GameEventLog::_head{ &GameEventLog::_stub };
+GameEventLog::Node* GameEventLog::_tail = &GameEventLog::_stub;
+std::atomic<uint32> GameEventLog::_pending{ 0 };
+std::atomic<uint64> GameEventLog::_dropped{ 0 };
+std::atomic<bool> GameEventLog::_capturing{ false };
+
+GameEventLog::GameEventLog(uint32 capacity)
+    : _capacity(std::max<uint32>(capacity, 1)), _nextSequence(1), _stopping(false)
+{
+    _epoch = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+GameEventLog::~GameEventLog()
+{
+    Stop();
+}
+
+char const* GameEventLog::TypeName(GameEventType type)
+{
+    return type < GameEventType::Count ? TYPE_NAMES[size_t(type)] : "unknown";
+}
+
+bool GameEventLog::ParseType(std::string const& name, GameEventType& type)
+{
+    for (size_t i = 0; i < std::size(TYPE_NAMES); ++i)
+    {
+        if (name == TYPE_NAMES[i])
+        {
+            type = GameEventType(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void GameEventLog::Push(Node* node)
+{
+    node->Next.store(nullptr, std::memory_order_relaxed);
+    Node* previous = _head.exchange(node, std::memory_order_acq_rel);
+    previous->Next.store(node, std::memory_order_release);
+}
+
+GameEventLog::Node* GameEventLog::Pop()
+{
+    Node* tail = _tail;
+    Node* next = tail->Next.load(std::memory_order_acquire);
+    if (tail == &_stub)
+    {
+        if (!next)
+            return nullptr;
+
+        _tail = next;
+        tail = next;
+        next = next->Next.load(std::memory_order_acquire);
+    }
+
+    if (next)
+    {
+        _tail = next;
+        return tail;
+    }
+
+    // A producer swapped _head but has not linked its node yet; pick it up next time
+    if (tail != _head.load(std::memory_order_acquire))
+        return nullptr;
+
+    // tail is the last node: put the stub behind it so it can be handed out
+    Push(&_stub);
+    next = tail->Next.load(std::memory_order_acquire);
+    if (next)
+    {
+        _tail = next;
+        return tail;
+    }
+
+    return nullptr;
+}
+
+void GameEventLog::Publish(GameEvent&& event)
+{
+    if (!_capturing.load(std::memory_order_relaxed))
+        return;
+
+    if (_pending.fetch_add(1, std::memory_order_relaxed) >= MAX_PENDING)
+    {
+        _pending.fetch_sub(1, std::memory_order_relaxed);
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Node* node = new Node();
+    node->Event = std::move(event);
+    node->Event.TimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    Push(node);
+}
+
+void GameEventLog::Start()
+{
+    if (_thread.joinable())
+        return;
+
+    _capturing.store(true, std::memory_order_relaxed);
+    _stopping = false;
+    _thread = std::thread([this]()
+    {
+#ifndef _WIN32
+        pthread_setname_np(pthread_self(), "gsapi-events");
+#endif
+        Run();
+    });
+}
+
+void GameEventLog::Stop()
+{
+    _capturing.store(false, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(_stopMutex);
+        _stopping = true;
+    }
+    _stopCondition.notify_all();
+
+    if (_thread.joinable())
+        _thread.join();
+
+    // Free what is still queued; a hook racing with the flag above can at worst leave one node behind
+    std::lock_guard<std::mutex> lock(_mutex);
+    Drain();
+}
+
+void GameEventLog::Run()
+{
+    std::unique_lock<std::mutex> lock(_stopMutex);
+    while (!_stopping)
+    {
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> eventsLock(_mutex);
+            Drain();
+        }
+        lock.lock();
+
+        _stopCondition.wait_for(lock, std::chrono::milliseconds(DRAIN_INTERVAL_MS), [this]() { return _stopping; });
+    }
+}
+
+void GameEventLog::Drain()
+{
+    while (Node* node = Pop())
+    {
+        _pending.fetch_sub(1, std::memory_order_relaxed);
+
+        node->Event.Sequence = _nextSequence++;
+        _events.push_back(std::move(node->Event));
+        if (_events.size() > _capacity)
+            _events.pop_front();
+
+        delete node;
+    }
+}
+
+std::vector<GameEvent> GameEventLog::Read(uint64 after, uint32 typeMask, uint32 limit, uint64& next)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Readers see everything published up to now, not only the last drain
+    Drain();
+
+    std::vector<GameEvent> events;
+    next = std::max(after, _nextSequence - 1);
+    if (_events.empty())
+        return events;
+
+    uint64 first = _events.front().Sequence;
+    for (size_t i = after >= first ? size_t(after - first + 1) : 0; i < _events.size(); ++i)
+    {
+        GameEvent const& event = _events[i];
+        if (!(typeMask & (1u << uint32(event.Type))))
+            continue;
+
+        events.push_back(event);
+        if (events.size() >= limit)
+        {
+            next = event.Sequence;
+            break;
+        }
+    }
+
+    return events;
+}
+
+uint64 GameEventLog::GetFirstSequence() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _events.empty() ? _nextSequence : _events.front().Sequence;
+}
+
+uint64 GameEventLog::GetLastSequence() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _nextSequence - 1;
+}
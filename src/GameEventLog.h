@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_GAMEEVENTLOG_H
+#define GAMESTATEAPI_GAMEEVENTLOG_H
+
+#include "Define.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class GameEventType : uint8
+{
+    Login,
+    Logout,
+    LevelChange,
+    Death,
+    ZoneChange,
+    QuestComplete,
+    GuildJoin,
+    GuildLeave,
+    MoneyChange,
+    Count
+};
+
+// Meaning of Value/Extra/Text depends on the type, see GameEventToJson
+struct GameEvent
+{
+    uint64 Sequence = 0;        // assigned when the event enters the log
+    int64 TimeMs = 0;
+    GameEventType Type = GameEventType::Login;
+    uint32 Guid = 0;
+    std::string Player;
+    int64 Value = 0;
+    int64 Extra = 0;
+    std::string Text;
+};
+
+// Player and guild events captured by script hooks. Hooks run on the world
+// and map update threads and only push onto a lock-free multi-producer queue;
+// a background thread moves the events into a bounded log where each gets the
+// next sequence number, so consumers can resume from the last one they saw.
+class GameEventLog
+{
+public:
+    // Events waiting in the queue beyond this are dropped and counted
+    static constexpr uint32 MAX_PENDING = 65536;
+    static constexpr uint32 DRAIN_INTERVAL_MS = 100;
+
+    explicit GameEventLog(uint32 capacity);
+    ~GameEventLog();
+
+    // Called by the hooks; does nothing while no log is capturing
+    static void Publish(GameEvent&& event);
+    static bool IsCapturing() { return _capturing.load(std::memory_order_relaxed); }
+
+    static char const* TypeName(GameEventType type);
+    // Returns false for an unknown name
+    static bool ParseType(std::string const& name, GameEventType& type);
+
+    void Start();
+    void Stop();
+
+    // Up to `limit` events with a sequence above `after` whose type bit is
+    // set in `typeMask`. `next` is the cursor to pass as `after` next time:
+    // the last event returned, or the newest event scanned when the batch
+    // was not full, so filtered-out events are not scanned again.
+    std::vector<GameEvent> Read(uint64 after, uint32 typeMask, uint32 limit, uint64& next);
+
+    uint64 GetFirstSequence() const;
+    uint64 GetLastSequence() const;
+    int64 GetEpoch() const { return _epoch; }
+    uint32 GetCapacity() const { return _capacity; }
+    static uint64 GetDroppedCount() { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> Next{ nullptr };
+        GameEvent Event;
+    };
+
+    static void Push(Node* node);
+    static Node* Pop();
+
+    void Run();
+    void Drain();
+
+    // Intrusive MPSC queue (Vyukov): producers swap _head, the single
+    // consumer owns _tail. Drain() is the consumer and runs under _mutex.
+    static std::atomic<Node*> _head;
+    static Node* _tail;
+    static Node _stub;
+    static std::atomic<uint32> _pending;
+    static std::atomic<uint64> _dropped;
+    static std::atomic<bool> _capturing;
+
+    uint32 _capacity;
+    int64 _epoch;       // ms, changes on every restart as sequences start over
+
+    mutable std::mutex _mutex;
+    std::deque<GameEvent> _events;
+    uint64 _nextSequence;
+
+    std::thread _thread;
+    std::mutex _stopMutex;
+    std::condition_variable _stopCondition;
+    bool _stopping;
+};
+
+#endif // GAMESTATEAPI_GAMEEVENTLOG_H
@@ -4,10 +4,12 @@
 
 #include "GameStateAPI.h"
 #include "HttpGameStateServer.h"
+#include "SystemMetrics.h"
 #include "Log.h"
 #include "Config.h"
+#include <algorithm>
 
-GameStateAPI::GameStateAPI() : WorldScript("GameStateAPI"), _enabled(false), _port(8080)
+GameStateAPI::GameStateAPI() : WorldScript("GameStateAPI")
 {
 }
 
@@ -21,24 +23,70 @@ GameStateAPI::~GameStateAPI()
 
 void GameStateAPI::OnAfterConfigLoad(bool /*reload*/)
 {
-    _enabled = sConfigMgr->GetOption<bool>("GameStateAPI.Enable", false);
-    _host = sConfigMgr->GetOption<std::string>("GameStateAPI.Host", "127.0.0.1");
-    _port = static_cast<uint16>(sConfigMgr->GetOption<int32>("GameStateAPI.Port", 8080));
-    _allowedOrigin = sConfigMgr->GetOption<std::string>("GameStateAPI.AllowedOrigin", "*");
+    _config.Enable = sConfigMgr->GetOption<bool>("GameStateAPI.Enable", false);
+    _config.Host = sConfigMgr->GetOption<std::string>("GameStateAPI.Host", "127.0.0.1");
+    _config.Port = static_cast<uint16>(sConfigMgr->GetOption<int32>("GameStateAPI.Port", 8080));
+    _config.Listeners = sConfigMgr->GetOption<uint32>("GameStateAPI.Listeners", 1);
+    _config.AllowedOrigin = sConfigMgr->GetOption<std::string>("GameStateAPI.AllowedOrigin", "*");
+    _config.SamplerIntervalMs = sConfigMgr->GetOption<uint32>("GameStateAPI.Sampler.Interval", 1000);
+    _config.SamplerHistorySize = sConfigMgr->GetOption<uint32>("GameStateAPI.Sampler.HistorySize", 300);
+    _config.PsiTriggers = sConfigMgr->GetOption<std::string>("GameStateAPI.PSI.Triggers", "");
+    _config.PsiEventHistory = sConfigMgr->GetOption<uint32>("GameStateAPI.PSI.EventHistory", 256);
+    _config.DbMonitorEnable = sConfigMgr->GetOption<bool>("GameStateAPI.DB.Enable", true);
+    _config.DbProbeIntervalMs = sConfigMgr->GetOption<uint32>("GameStateAPI.DB.ProbeInterval", 5000);
+    _config.RecorderEnable = sConfigMgr->GetOption<bool>("GameStateAPI.Recorder.Enable", false);
+    _config.RecorderFile = sConfigMgr->GetOption<std::string>("GameStateAPI.Recorder.File", "gamestate_requests.rec");
+    _config.RecorderSizeMB = sConfigMgr->GetOption<uint32>("GameStateAPI.Recorder.SizeMB", 64);
+    _config.HistoryEnable = sConfigMgr->GetOption<bool>("GameStateAPI.History.Enable", true);
+    _config.HistoryFile = sConfigMgr->GetOption<std::string>("GameStateAPI.History.File", "");
+    _config.HistoryCheckpointSeconds = sConfigMgr->GetOption<uint32>("GameStateAPI.History.CheckpointInterval", 60);
+    _config.TrailEnable = sConfigMgr->GetOption<bool>("GameStateAPI.Trail.Enable", true);
+    _config.TrailIntervalMs = sConfigMgr->GetOption<uint32>("GameStateAPI.Trail.Interval", 2000);
+    _config.TrailSeconds = sConfigMgr->GetOption<uint32>("GameStateAPI.Trail.Seconds", 600);
+    _config.HeatmapEnable = sConfigMgr->GetOption<bool>("GameStateAPI.Heatmap.Enable", true);
+    _config.HeatmapCellSize = sConfigMgr->GetOption<uint32>("GameStateAPI.Heatmap.CellSize", 50);
+    _config.HeatmapIntervalMs = sConfigMgr->GetOption<uint32>("GameStateAPI.Heatmap.Interval", 5000);
+    _config.EventsEnable = sConfigMgr->GetOption<bool>("GameStateAPI.Events.Enable", true);
+    _config.EventsCapacity = sConfigMgr->GetOption<uint32>("GameStateAPI.Events.Capacity", 100000);
+    _config.JournalEnable = sConfigMgr->GetOption<bool>("GameStateAPI.Journal.Enable", false);
+    _config.JournalDirectory = sConfigMgr->GetOption<std::string>("GameStateAPI.Journal.Directory", "gamestate_journal");
+    _config.JournalIntervalMs = sConfigMgr->GetOption<uint32>("GameStateAPI.Journal.Interval", 10000);
+    _config.JournalBaseEvery = sConfigMgr->GetOption<uint32>("GameStateAPI.Journal.BaseEvery", 60);
+    _config.JournalSegmentSizeMB = sConfigMgr->GetOption<uint32>("GameStateAPI.Journal.SegmentSizeMB", 64);
+    _config.JournalRetentionHours = sConfigMgr->GetOption<uint32>("GameStateAPI.Journal.RetentionHours", 48);
+    _config.JournalMaxSizeMB = sConfigMgr->GetOption<uint32>("GameStateAPI.Journal.MaxSizeMB", 1024);
+    _config.PushEnable = sConfigMgr->GetOption<bool>("GameStateAPI.Push.Enable", false);
+    _config.PushEndpoint = sConfigMgr->GetOption<std::string>("GameStateAPI.Push.Endpoint", "");
+    _config.PushIntervalMs = sConfigMgr->GetOption<uint32>("GameStateAPI.Push.Interval", 5000);
+    _config.PushBaseEvery = sConfigMgr->GetOption<uint32>("GameStateAPI.Push.BaseEvery", 60);
+    _config.PushBufferKB = sConfigMgr->GetOption<uint32>("GameStateAPI.Push.BufferKB", 16384);
+    _config.PushBatchKB = sConfigMgr->GetOption<uint32>("GameStateAPI.Push.BatchKB", 256);
+    _config.StreamEnable = sConfigMgr->GetOption<bool>("GameStateAPI.Stream.Enable", false);
+    _config.StreamIntervalMs = sConfigMgr->GetOption<uint32>("GameStateAPI.Stream.Interval", 2000);
+    _config.StreamMaxSubscribers = sConfigMgr->GetOption<uint32>("GameStateAPI.Stream.MaxSubscribers", 4);
+    _config.FederationEnable = sConfigMgr->GetOption<bool>("GameStateAPI.Federation.Enable", false);
+    _config.FederationRealmName = sConfigMgr->GetOption<std::string>("GameStateAPI.Federation.RealmName", "local");
+    _config.FederationPeers = sConfigMgr->GetOption<std::string>("GameStateAPI.Federation.Peers", "");
+    _config.FederationServerIntervalMs = sConfigMgr->GetOption<uint32>("GameStateAPI.Federation.ServerInterval", 10000);
+    _config.DebugEnable = sConfigMgr->GetOption<bool>("GameStateAPI.Debug.Enable", false);
+    _config.ProfileMaxSeconds = std::max(1u, sConfigMgr->GetOption<uint32>("GameStateAPI.Debug.Profile.MaxSeconds", 30));
+    _config.ProfileMaxHz = std::max(1u, sConfigMgr->GetOption<uint32>("GameStateAPI.Debug.Profile.MaxHz", 999));
+    _config.MallocSampleInterval = sConfigMgr->GetOption<uint32>("GameStateAPI.Debug.Malloc.SampleInterval", 60);
 
     LOG_INFO("module.gamestate_api", "Game State API Module Configuration:");
-    LOG_INFO("module.gamestate_api", "  Enabled: {}", _enabled ? "Yes" : "No");
-    if (_enabled)
+    LOG_INFO("module.gamestate_api", "  Enabled: {}", _config.Enable ? "Yes" : "No");
+    if (_config.Enable)
     {
-        LOG_INFO("module.gamestate_api", "  Host: {}", _host);
-        LOG_INFO("module.gamestate_api", "  Port: {}", _port);
-        LOG_INFO("module.gamestate_api", "  Allowed Origin: {}", _allowedOrigin);
+        LOG_INFO("module.gamestate_api", "  Host: {}", _config.Host);
+        LOG_INFO("module.gamestate_api", "  Port: {}", _config.Port);
+        LOG_INFO("module.gamestate_api", "  Allowed Origin: {}", _config.AllowedOrigin);
+        LOG_INFO("module.gamestate_api", "  Debug Endpoints: {}", _config.DebugEnable ? "Yes" : "No");
     }
 }
 
 void GameStateAPI::OnStartup()
 {
-    if (!_enabled)
+    if (!_config.Enable)
     {
         LOG_INFO("module.gamestate_api", "Game State API Module is disabled");
         return;
@@ -46,11 +94,11 @@ void GameStateAPI::OnStartup()
 
     LOG_INFO("module.gamestate_api", "Starting Game State API HTTP Server...");
 
-    _httpServer = std::make_unique<HttpGameStateServer>(_host, _port, _allowedOrigin);
+    _httpServer = std::make_unique<HttpGameStateServer>(_config);
 
     if (_httpServer->Start())
     {
-        LOG_INFO("module.gamestate_api", "Game State API HTTP Server started successfully on {}:{}", _host, _port);
+        LOG_INFO("module.gamestate_api", "Game State API HTTP Server started successfully on {}:{}", _config.Host, _config.Port);
     }
     else
     {
@@ -70,6 +118,16 @@ void GameStateAPI::OnShutdown()
     }
 }
 
+void GameStateAPI::OnUpdate(uint32 diff)
+{
+    // OnUpdate runs on the world thread; tag it for /api/process/threads
+    SystemMetricsSampler::RegisterCurrentThread("world");
+    SystemMetricsSampler::RecordWorldTick(diff);
+
+    if (_httpServer)
+        _httpServer->OnWorldUpdate(diff);
+}
+
 // Register the script
 void AddGameStateAPIScripts()
 {
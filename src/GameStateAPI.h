@@ -7,6 +7,7 @@
 
 #include "ScriptMgr.h"
 #include "Config.h"
+#include "GameStateConfig.h"
 #include <string>
 #include <memory>
 
@@ -22,13 +23,11 @@ public:
     void OnAfterConfigLoad(bool reload) override;
     void OnStartup() override;
     void OnShutdown() override;
+    void OnUpdate(uint32 diff) override;
 
 private:
     std::unique_ptr<HttpGameStateServer> _httpServer;
-    bool _enabled;
-    std::string _host;
-    uint16 _port;
-    std::string _allowedOrigin;
+    GameStateAPIConfig _config;
 };
 
 #endif // GAME_STATE_API_H
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAME_STATE_CONFIG_H
+#define GAME_STATE_CONFIG_H
+
+#include "Define.h"
+#include <string>
+
+// Module configuration, loaded by GameStateAPI and handed to the HTTP server
+struct GameStateAPIConfig
+{
+    bool Enable = false;
+    std::string Host = "127.0.0.1";
+    uint16 Port = 8080;
+    uint32 Listeners = 1;               // accept threads sharing Port, Linux only
+    std::string AllowedOrigin = "*";
+
+    // Background /proc sampler
+    uint32 SamplerIntervalMs = 1000;
+    uint32 SamplerHistorySize = 300;
+
+    // Pressure-stall triggers, e.g. "cpu.some.avg10>25,cgroup.memory.full.avg10>5"
+    std::string PsiTriggers;
+    uint32 PsiEventHistory = 256;
+
+    // Database pool monitor
+    bool DbMonitorEnable = true;
+    uint32 DbProbeIntervalMs = 5000;
+
+    // Request recorder, replayed by gamestate-loadgen --replay
+    bool RecorderEnable = false;
+    std::string RecorderFile = "gamestate_requests.rec";
+    uint32 RecorderSizeMB = 64;
+
+    // Compressed per-second metric history (/api/history)
+    bool HistoryEnable = true;
+    std::string HistoryFile;            // empty = memory only
+    uint32 HistoryCheckpointSeconds = 60;
+
+    // Per-player position trails (/api/player/{name}/trail)
+    bool TrailEnable = true;
+    uint32 TrailIntervalMs = 2000;
+    uint32 TrailSeconds = 600;
+
+    // Per-map population heatmaps (/api/heatmap/{map})
+    bool HeatmapEnable = true;
+    uint32 HeatmapCellSize = 50;        // yards
+    uint32 HeatmapIntervalMs = 5000;
+
+    // Player and guild event log (/api/events)
+    bool EventsEnable = true;
+    uint32 EventsCapacity = 100000;
+
+    // On-disk snapshot journal (/api/players?at=)
+    bool JournalEnable = false;
+    std::string JournalDirectory = "gamestate_journal";
+    uint32 JournalIntervalMs = 10000;
+    uint32 JournalBaseEvery = 60;       // generations per full snapshot
+    uint32 JournalSegmentSizeMB = 64;
+    uint32 JournalRetentionHours = 48;
+    uint32 JournalMaxSizeMB = 1024;
+
+    // Snapshot push to a collector
+    bool PushEnable = false;
+    std::string PushEndpoint;           // tcp://host:port or unix:/path
+    uint32 PushIntervalMs = 5000;
+    uint32 PushBaseEvery = 60;          // generations per full snapshot
+    uint32 PushBufferKB = 16384;
+    uint32 PushBatchKB = 256;
+
+    // Player stream for subscribers such as a federating instance (/api/players/stream)
+    bool StreamEnable = false;
+    uint32 StreamIntervalMs = 2000;
+    uint32 StreamMaxSubscribers = 4;    // each holds an HTTP worker thread
+
+    // Merged views over several realms (/api/federation/*)
+    bool FederationEnable = false;
+    std::string FederationRealmName = "local";
+    std::string FederationPeers;        // Name=http://host:port,...
+    uint32 FederationServerIntervalMs = 10000;
+
+    // Debug endpoints (/api/debug/*)
+    bool DebugEnable = false;
+    uint32 ProfileMaxSeconds = 30;
+    uint32 ProfileMaxHz = 999;
+    uint32 MallocSampleInterval = 60;
+};
+
+#endif // GAME_STATE_CONFIG_H
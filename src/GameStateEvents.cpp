@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "GameEventLog.h"
+#include "ScriptMgr.h"
+#include "Player.h"
+#include "Guild.h"
+#include "QuestDef.h"
+#include <algorithm>
+
+namespace
+{
+    // Only the hook's own arguments are touched: these run on map update threads
+    void PublishPlayerEvent(GameEventType type, Player* player, int64 value, int64 extra, std::string text = {})
+    {
+        if (!GameEventLog::IsCapturing() || !player)
+            return;
+
+        GameEvent event;
+        event.Type = type;
+        event.Guid = uint32(player->GetGUID().GetCounter());
+        event.Player = player->GetName();
+        event.Value = value;
+        event.Extra = extra;
+        event.Text = std::move(text);
+        GameEventLog::Publish(std::move(event));
+    }
+}
+
+// Feeds /api/events
+class GameStatePlayerEvents : public PlayerScript
+{
+public:
+    GameStatePlayerEvents() : PlayerScript("GameStatePlayerEvents", {
+        PLAYERHOOK_ON_LOGIN,
+        PLAYERHOOK_ON_LOGOUT,
+        PLAYERHOOK_ON_LEVEL_CHANGED,
+        PLAYERHOOK_ON_PLAYER_JUST_DIED,
+        PLAYERHOOK_ON_UPDATE_ZONE,
+        PLAYERHOOK_ON_PLAYER_COMPLETE_QUEST,
+        PLAYERHOOK_ON_MONEY_CHANGED
+    })
+    {
+    }
+
+    void OnPlayerLogin(Player* player) override
+    {
+        PublishPlayerEvent(GameEventType::Login, player, player->GetLevel(), player->GetZoneId());
+    }
+
+    void OnPlayerLogout(Player* player) override
+    {
+        PublishPlayerEvent(GameEventType::Logout, player, player->GetLevel(), player->GetZoneId());
+    }
+
+    void OnPlayerLevelChanged(Player* player, uint8 oldLevel) override
+    {
+        PublishPlayerEvent(GameEventType::LevelChange, player, player->GetLevel(), oldLevel);
+    }
+
+    void OnPlayerJustDied(Player* player) override
+    {
+        PublishPlayerEvent(GameEventType::Death, player, player->GetMapId(), player->GetZoneId());
+    }
+
+    void OnPlayerUpdateZone(Player* player, uint32 newZone, uint32 newArea) override
+    {
+        PublishPlayerEvent(GameEventType::ZoneChange, player, newZone, newArea);
+    }
+
+    void OnPlayerCompleteQuest(Player* player, Quest const* quest) override
+    {
+        if (quest)
+            PublishPlayerEvent(GameEventType::QuestComplete, player, quest->GetQuestId(), 0, quest->GetTitle());
+    }
+
+    // Runs before the change is applied, so the balance afterwards is computed here
+    void OnPlayerMoneyChanged(Player* player, int32& amount) override
+    {
+        if (amount)
+            PublishPlayerEvent(GameEventType::MoneyChange, player, amount, std::max<int64>(int64(player->GetMoney()) + amount, 0));
+    }
+};
+
+class GameStateGuildEvents : public GuildScript
+{
+public:
+    GameStateGuildEvents() : GuildScript("GameStateGuildEvents", {
+        GUILDHOOK_ON_ADD_MEMBER,
+        GUILDHOOK_ON_REMOVE_MEMBER
+    })
+    {
+    }
+
+    // Guild hooks pass nullptr for members who are offline; those are not reported
+    void OnAddMember(Guild* guild, Player* player, uint8& rank) override
+    {
+        if (guild)
+            PublishPlayerEvent(GameEventType::GuildJoin, player, guild->GetId(), rank, guild->GetName());
+    }
+
+    void OnRemoveMember(Guild* guild, Player* player, bool isDisbanding, bool isKicked) override
+    {
+        if (guild)
+            PublishPlayerEvent(GameEventType::GuildLeave, player, guild->GetId(), isDisbanding ? 2 : (isKicked ? 1 : 0), guild->GetName());
+    }
+};
+
+void AddGameStateEventScripts()
+{
+    new GameStatePlayerEvents();
+    new GameStateGuildEvents();
+}
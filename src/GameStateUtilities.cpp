@@ -20,6 +20,7 @@
 #include "SpellInfo.h"
 #include "SpellMgr.h"
 #include <fmt/format.h>
+#include <unordered_map>
 
 namespace GameStateUtilities
 {
@@ -716,4 +717,71 @@ namespace GameStateUtilities
 
         return questsData;
     }
+
+    nlohmann::json GetSnapshotData(bool anonymize)
+    {
+        nlohmann::json players = nlohmann::json::array();
+
+        // Anonymized ids are ordinals in order of first appearance, so they stay
+        // consistent within the snapshot (group leaders, guild mates) but do not
+        // match anything on the server
+        std::unordered_map<uint32, uint32> guids;
+        std::unordered_map<uint32, uint32> guilds;
+        std::unordered_map<uint32, uint32> groups;
+        auto ordinal = [](std::unordered_map<uint32, uint32>& ids, uint32 id)
+        {
+            return ids.emplace(id, uint32(ids.size() + 1)).first->second;
+        };
+
+        const auto& sessions = sWorldSessionMgr->GetAllSessions();
+        for (const auto& [accountId, session] : sessions)
+        {
+            Player* player = session->GetPlayer();
+            if (!player || !player->IsInWorld())
+                continue;
+
+            nlohmann::json data = GetPlayerData(player, true);
+            if (anonymize)
+            {
+                // Names are replaced by the player's ordinal, account ids dropped
+                uint32 guid = ordinal(guids, data["guid"].get<uint32>());
+                std::string name = fmt::format("Player{}", guid);
+                data["guid"] = guid;
+                data["name"] = name;
+                data.erase("account_id");
+                if (data.contains("account_name"))
+                    data["account_name"] = name;
+
+                if (data["guild"].is_object())
+                {
+                    uint32 guild = ordinal(guilds, data["guild"]["id"].get<uint32>());
+                    data["guild"]["id"] = guild;
+                    data["guild"]["name"] = fmt::format("Guild{}", guild);
+                }
+
+                if (data["group"].is_object())
+                {
+                    data["group"]["id"] = ordinal(groups, data["group"]["id"].get<uint32>());
+                    data["group"]["leader_guid"] = ordinal(guids, data["group"]["leader_guid"].get<uint32>());
+                }
+            }
+
+            players.push_back({
+                {"player", std::move(data)},
+                {"stats", GetPlayerStats(player)},
+                {"skills", GetPlayerSkills(player)},
+                {"skills_full", GetPlayerSkillsFull(player)},
+                {"quests", GetPlayerQuests(player)}
+            });
+        }
+
+        return {
+            {"format", "gamestate-snapshot"},
+            {"version", 1},
+            {"captured_at", GameTime::GetGameTime().count()},
+            {"anonymized", anonymize},
+            {"server", GetServerData()},
+            {"players", std::move(players)}
+        };
+    }
 }
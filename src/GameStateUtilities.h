@@ -44,6 +44,9 @@ namespace GameStateUtilities
 
     // Get player's active quests information
     nlohmann::json GetPlayerQuests(Player* player);
+
+    // Capture server data and every per-player endpoint document for offline replay
+    nlohmann::json GetSnapshotData(bool anonymize = false);
 }
 
 #endif // GAMESTATEAPI_GAMESTATESUTILITIES_H
@@ -5,14 +5,39 @@
 #include "HttpGameStateServer.h"
 #include "GameStateAPI.h"
 #include "GameStateUtilities.h"
+#include "AllocationTracking.h"
+#include "AllocatorStats.h"
+#include "DatabaseMetrics.h"
+#include "GameEventLog.h"
+#include "HttpListeners.h"
+#include "MetricHistory.h"
+#include "PlayerTrails.h"
+#include "PopulationHeatmap.h"
+#include "RequestAccounting.h"
+#include "RequestRecorder.h"
+#include "SamplingProfiler.h"
+#include "SnapshotFeed.h"
+#include "SnapshotJournal.h"
+#include "SnapshotPusher.h"
+#include "SystemMetrics.h"
 #include "Log.h"
+#include "Guild.h"
+#include "GuildMgr.h"
 #include "ObjectAccessor.h"
+#include "ObjectMgr.h"
 #include "Player.h"
 #include "WorldSession.h"
 #include "WorldSessionMgr.h"
 #include "World.h"
 #include "GameTime.h"
 #include <nlohmann/json.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -21,358 +46,2811 @@
 #include <sys/sysinfo.h>
 #include <unistd.h>
 #include <fstream>
-#include <sstream>
 #endif
 
 using json = nlohmann::json;
 
-HttpGameStateServer::HttpGameStateServer(const std::string& host, uint16 port, const std::string& allowedOrigin)
-    : _host(host), _port(port), _allowedOrigin(allowedOrigin), _running(false)
+namespace
 {
-    _server = std::make_unique<httplib::Server>();
+    // Beyond a few accept threads the kernel's per-socket accept queues are no longer the bottleneck
+    constexpr uint32 MAX_LISTENERS = 16;
+    // How long /api/debug/snapshot waits for a world update to collect it
+    constexpr uint32 SNAPSHOT_TIMEOUT_SECONDS = 10;
 
-    // Set up CORS middleware for all requests
-    _server->set_pre_routing_handler([this](const httplib::Request& /*req*/, httplib::Response& res) {
-        SetCorsHeaders(res);
-        return httplib::Server::HandlerResponse::Unhandled;
-    });
+    json PressureLineToJson(const PressureLine& line)
+    {
+        return {
+            {"avg10", line.Avg10},
+            {"avg60", line.Avg60},
+            {"avg300", line.Avg300},
+            {"total_usec", line.TotalUsec}
+        };
+    }
 
-    // Handle OPTIONS requests for CORS preflight
-    _server->Options(".*", [this](const httplib::Request& /*req*/, httplib::Response& res) {
-        SetCorsHeaders(res);
-        res.status = 200;
-    });
+    json CpuUtilizationToJson(const CpuUtilization& util)
+    {
+        return {
+            {"busy", util.Busy},
+            {"user", util.User},
+            {"nice", util.Nice},
+            {"system", util.System},
+            {"idle", util.Idle},
+            {"iowait", util.Iowait},
+            {"irq", util.Irq},
+            {"softirq", util.Softirq},
+            {"steal", util.Steal}
+        };
+    }
+
+    json PressureToJson(const PressureStats& stats)
+    {
+        if (!stats.Available)
+            return nullptr;
+
+        return {
+            {"some", PressureLineToJson(stats.Some)},
+            {"full", PressureLineToJson(stats.Full)}
+        };
+    }
+
+    json PressureMetricsToJson(const PressureMetrics& pressure)
+    {
+        json result = {
+            {"host", {
+                {"cpu", PressureToJson(pressure.HostCpu)},
+                {"memory", PressureToJson(pressure.HostMemory)},
+                {"io", PressureToJson(pressure.HostIo)}
+            }},
+            {"cgroup", nullptr}
+        };
+
+        if (pressure.CgroupCpu.Available || pressure.CgroupMemory.Available || pressure.CgroupIo.Available)
+        {
+            result["cgroup"] = {
+                {"cpu", PressureToJson(pressure.CgroupCpu)},
+                {"memory", PressureToJson(pressure.CgroupMemory)},
+                {"io", PressureToJson(pressure.CgroupIo)}
+            };
+        }
+
+        return result;
+    }
+
+    // Minimal writer for the Prometheus text exposition format
+    class MetricsWriter
+    {
+    public:
+        void Family(char const* name, char const* type, char const* help)
+        {
+            _out += fmt::format("# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+        }
+
+        void Sample(char const* name, double value, std::string const& labels = "")
+        {
+            if (labels.empty())
+                _out += fmt::format("{} {}\n", name, value);
+            else
+                _out += fmt::format("{}{{{}}} {}\n", name, labels, value);
+        }
+
+        struct PressureSource
+        {
+            char const* Scope;
+            char const* Resource;
+            PressureStats const& Stats;
+        };
+
+        // Samples of a family must be contiguous, so iterate families first
+        void Pressure(std::initializer_list<PressureSource> sources)
+        {
+            static constexpr char const* names[] = { "gamestate_pressure_avg10", "gamestate_pressure_avg60",
+                "gamestate_pressure_avg300", "gamestate_pressure_stall_seconds_total" };
+            static constexpr char const* helps[] = { "PSI stall percentage averaged over 10s",
+                "PSI stall percentage averaged over 60s", "PSI stall percentage averaged over 300s", "Total PSI stall time" };
+
+            for (uint32 family = 0; family < 4; ++family)
+            {
+                Family(names[family], family == 3 ? "counter" : "gauge", helps[family]);
+                for (PressureSource const& source : sources)
+                {
+                    if (!source.Stats.Available)
+                        continue;
+
+                    for (bool full : { false, true })
+                    {
+                        PressureLine const& line = full ? source.Stats.Full : source.Stats.Some;
+                        double values[] = { line.Avg10, line.Avg60, line.Avg300, line.TotalUsec / 1e6 };
+                        Sample(names[family], values[family], fmt::format("scope=\"{}\",resource=\"{}\",kind=\"{}\"",
+                            source.Scope, source.Resource, full ? "full" : "some"));
+                    }
+                }
+            }
+        }
+
+        // Cumulative _bucket/_sum/_count samples, converted from milliseconds to seconds
+        void Histogram(char const* name, LatencyHistogram const& histogram, std::string const& labels)
+        {
+            std::string const bucketName = fmt::format("{}_bucket", name);
+            std::string const prefix = labels.empty() ? "" : labels + ",";
+            uint64 cumulative = 0;
+            for (uint32 bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket)
+            {
+                cumulative += histogram.Buckets[bucket];
+                Sample(bucketName.c_str(), double(cumulative), fmt::format("{}le=\"{}\"", prefix, LatencyHistogram::BOUNDS_MS[bucket] / 1000.0));
+            }
+            Sample(bucketName.c_str(), double(histogram.Count), fmt::format("{}le=\"+Inf\"", prefix));
+            Sample(fmt::format("{}_sum", name).c_str(), histogram.SumMs / 1000.0, labels);
+            Sample(fmt::format("{}_count", name).c_str(), double(histogram.Count), labels);
+        }
+
+        std::string const& Str() const { return _out; }
+
+    private:
+        std::string _out;
+    };
+
+    // Requests counted between two cumulative snapshots; MaxMs stays cumulative
+    LatencyHistogram HistogramSince(LatencyHistogram const& now, LatencyHistogram const& before)
+    {
+        LatencyHistogram delta = now;
+        for (uint32 bucket = 0; bucket <= LatencyHistogram::BUCKET_COUNT; ++bucket)
+            delta.Buckets[bucket] -= std::min(delta.Buckets[bucket], before.Buckets[bucket]);
+        delta.Count -= std::min(delta.Count, before.Count);
+        delta.SumMs = std::max(0.0, delta.SumMs - before.SumMs);
+        return delta;
+    }
+
+    // [time, map, zone, x, y, z, orientation, flags] per point, matching TRAIL_FIELDS
+    json TrailPointsToJson(std::vector<TrailPoint> const& points)
+    {
+        json result = json::array();
+        for (TrailPoint const& point : points)
+        {
+            result.push_back({
+                point.Time,
+                point.Map,
+                point.Zone,
+                PlayerTrails::Coordinate(point.X),
+                PlayerTrails::Coordinate(point.Y),
+                PlayerTrails::Coordinate(point.Z),
+                std::round(PlayerTrails::Orientation(point.Orientation) * 100.0) / 100.0,
+                point.Flags
+            });
+        }
+        return result;
+    }
+
+    json GameEventToJson(GameEvent const& event)
+    {
+        json result = {
+            {"seq", event.Sequence},
+            {"time_ms", event.TimeMs},
+            {"type", GameEventLog::TypeName(event.Type)},
+            {"guid", event.Guid},
+            {"player", event.Player}
+        };
+
+        switch (event.Type)
+        {
+            case GameEventType::Login:
+            case GameEventType::Logout:
+                result["level"] = event.Value;
+                result["zone"] = event.Extra;
+                break;
+            case GameEventType::LevelChange:
+                result["level"] = event.Value;
+                result["previous_level"] = event.Extra;
+                break;
+            case GameEventType::Death:
+                result["map"] = event.Value;
+                result["zone"] = event.Extra;
+                break;
+            case GameEventType::ZoneChange:
+                result["zone"] = event.Value;
+                result["area"] = event.Extra;
+                break;
+            case GameEventType::QuestComplete:
+                result["quest_id"] = event.Value;
+                result["title"] = event.Text;
+                break;
+            case GameEventType::GuildJoin:
+                result["guild_id"] = event.Value;
+                result["guild"] = event.Text;
+                result["rank"] = event.Extra;
+                break;
+            case GameEventType::GuildLeave:
+                result["guild_id"] = event.Value;
+                result["guild"] = event.Text;
+                result["reason"] = event.Extra == 2 ? "disbanded" : (event.Extra == 1 ? "kicked" : "left");
+                break;
+            case GameEventType::MoneyChange:
+                result["delta"] = event.Value;
+                result["money"] = event.Extra;
+                break;
+            default:
+                break;
+        }
+
+        return result;
+    }
+
+    json const TRAIL_FIELDS = { "time", "map", "zone", "x", "y", "z", "orientation", "flags" };
+
+    char const* MetricKindName(MetricKind kind)
+    {
+        switch (kind)
+        {
+            case MetricKind::Peak: return "peak";
+            case MetricKind::Counter: return "rate";
+            default: return "gauge";
+        }
+    }
+
+    std::string ToLower(std::string value)
+    {
+        std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+        return value;
+    }
+
+    json FederatedPlayerToJson(const std::string& realm, const SnapshotStream::Player& player, bool includeEquipment)
+    {
+        json data = SnapshotStream::PlayerToJson(player);
+        data["realm"] = realm;
+        if (!includeEquipment)
+            data.erase("equipment");
+        return data;
+    }
+}
+
+HttpGameStateServer::HttpGameStateServer(const GameStateAPIConfig& config)
+    : _config(config), _trailElapsedMs(0), _heatmapElapsedMs(0), _journalElapsedMs(0), _pushElapsedMs(0), _feedElapsedMs(0), _snapshotPending(false), _running(false)
+{
+    uint32 listeners = std::clamp<uint32>(_config.Listeners, 1, MAX_LISTENERS);
+#ifdef _WIN32
+    // SO_REUSEADDR on Windows lets a second socket steal the port instead of sharing the accepts
+    if (listeners > 1)
+    {
+        LOG_WARN("module.gamestate_api", "GameStateAPI.Listeners > 1 needs SO_REUSEPORT, using a single listener");
+        listeners = 1;
+    }
+#endif
+
+    for (uint32 i = 0; i < listeners; ++i)
+    {
+        Listener& listener = _listeners.emplace_back();
+        listener.Server = std::make_unique<httplib::Server>();
+        listener.Accepts = std::make_unique<ListenerAccepts>();
+        // Headers and body go out as separate writes; without this Nagle holds the
+        // body back until the client's delayed ACK, adding ~40ms on keep-alive connections
+        listener.Server->set_tcp_nodelay(true);
+
+        // Every listener feeds the same workers, so Listeners adds accept threads, not request threads
+        ListenerAccepts* accepts = listener.Accepts.get();
+        listener.Server->new_task_queue = [this, accepts]() { return new ListenerTaskQueue(*_workers, *accepts); };
+
+#ifndef _WIN32
+        if (listeners > 1)
+        {
+            listener.Server->set_socket_options([](socket_t sock) {
+                int enable = 1;
+                setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+                setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+            });
+        }
+#endif
+    }
+
+    _accounting = std::make_unique<RequestAccounting>();
+    _sampler = std::make_unique<SystemMetricsSampler>(_config.SamplerIntervalMs, _config.SamplerHistorySize);
+    _sampler->SetPressureTriggers(_config.PsiTriggers, _config.PsiEventHistory);
+    if (_config.DebugEnable)
+    {
+        _sampler->SetAllocatorSampling(_config.MallocSampleInterval);
+    }
+
+    if (_config.DbMonitorEnable)
+    {
+        _dbMonitor = std::make_unique<DatabaseMonitor>(_config.SamplerIntervalMs, _config.DbProbeIntervalMs, _config.SamplerHistorySize);
+    }
+
+    if (_config.RecorderEnable)
+    {
+        _recorder = std::make_unique<RequestRecorder>(_config.RecorderFile, uint64(_config.RecorderSizeMB) * 1024 * 1024);
+        std::string error;
+        if (_recorder->Open(error))
+        {
+            LOG_INFO("module.gamestate_api", "Recording requests to {} ({} MB ring)", _config.RecorderFile, _config.RecorderSizeMB);
+        }
+        else
+        {
+            LOG_ERROR("module.gamestate_api", "Request recorder disabled: {}", error);
+            _recorder.reset();
+        }
+    }
+
+    if (_config.HistoryEnable)
+    {
+        _history = std::make_unique<MetricHistory>(_config.HistoryFile, _config.HistoryCheckpointSeconds);
+        RegisterHistoryMetrics();
+    }
+
+    if (_config.TrailEnable)
+    {
+        _trails = std::make_unique<PlayerTrails>(_config.TrailIntervalMs, _config.TrailSeconds);
+    }
+
+    if (_config.HeatmapEnable)
+    {
+        _heatmaps = std::make_unique<PopulationHeatmaps>(_config.HeatmapCellSize, _config.HeatmapIntervalMs);
+    }
+
+    if (_config.EventsEnable)
+    {
+        _events = std::make_unique<GameEventLog>(_config.EventsCapacity);
+    }
+
+    if (_config.JournalEnable)
+    {
+        _journal = std::make_unique<SnapshotJournal>(_config.JournalDirectory, _config.JournalBaseEvery,
+            _config.JournalSegmentSizeMB, _config.JournalRetentionHours, _config.JournalMaxSizeMB);
+        std::string error;
+        if (_journal->Open(error))
+        {
+            LOG_INFO("module.gamestate_api", "Journaling snapshots to {} every {} ms", _config.JournalDirectory, _config.JournalIntervalMs);
+        }
+        else
+        {
+            LOG_ERROR("module.gamestate_api", "Snapshot journal disabled: {}", error);
+            _journal.reset();
+        }
+    }
+
+    if (_config.PushEnable)
+    {
+        _pusher = std::make_unique<SnapshotPusher>(_config.PushEndpoint, _config.PushBaseEvery, _config.PushBufferKB, _config.PushBatchKB);
+        std::string error;
+        if (_pusher->Open(error))
+        {
+            LOG_INFO("module.gamestate_api", "Pushing snapshots to {} every {} ms", _config.PushEndpoint, _config.PushIntervalMs);
+        }
+        else
+        {
+            LOG_ERROR("module.gamestate_api", "Snapshot push disabled: {}", error);
+            _pusher.reset();
+        }
+    }
+
+    // The federation serves the local realm from the same feed the stream subscribers read
+    if (_config.StreamEnable || _config.FederationEnable)
+    {
+        _feed = std::make_unique<SnapshotFeed>();
+    }
+
+    if (_config.FederationEnable)
+    {
+        _federation = std::make_unique<RealmFederation>(_config.FederationServerIntervalMs);
+        std::string error;
+        if (_federation->Open(_config.FederationPeers, error))
+        {
+            LOG_INFO("module.gamestate_api", "Federating realm {} with {}", _config.FederationRealmName, _config.FederationPeers);
+        }
+        else
+        {
+            LOG_ERROR("module.gamestate_api", "Federation disabled: {}", error);
+            _federation.reset();
+        }
+    }
+
+    for (Listener& listener : _listeners)
+    {
+        // Set up CORS middleware for all requests
+        listener.Server->set_pre_routing_handler([this](const httplib::Request& /*req*/, httplib::Response& res) {
+            SetCorsHeaders(res);
+            return httplib::Server::HandlerResponse::Unhandled;
+        });
+
+        // Handle OPTIONS requests for CORS preflight
+        listener.Server->Options(".*", [this](const httplib::Request& /*req*/, httplib::Response& res) {
+            SetCorsHeaders(res);
+            res.status = 200;
+        });
+    }
 
     // API endpoints
-    _server->Get("/api/health", [this](const httplib::Request& req, httplib::Response& res) {
-        HandleHealthCheck(req, res);
-    });
+    Route("/api/health", &HttpGameStateServer::HandleHealthCheck);
+    Route("/api/server", &HttpGameStateServer::HandleServerInfo);
+    Route("/api/host", &HttpGameStateServer::HandleHostInfo);
+    Route("/api/host/cpu", &HttpGameStateServer::HandleHostCpu);
+    Route("/api/host/io", &HttpGameStateServer::HandleHostIo);
+    Route("/api/host/pressure", &HttpGameStateServer::HandleHostPressure);
+    Route("/metrics", &HttpGameStateServer::HandleMetrics);
+    Route("/api/listeners", &HttpGameStateServer::HandleListeners);
+    Route("/api/process", &HttpGameStateServer::HandleProcessInfo);
+    Route("/api/process/threads", &HttpGameStateServer::HandleProcessThreads);
+    Route("/api/db", &HttpGameStateServer::HandleDatabase);
+    Route("/api/stats/cpu", &HttpGameStateServer::HandleRequestCpu);
+    Route("/api/history", &HttpGameStateServer::HandleHistoryList);
+    Route("/api/history/([^/]+)", &HttpGameStateServer::HandleHistory);
+    Route("/api/players", &HttpGameStateServer::HandleOnlinePlayers);
+    Route("/api/player/([^/]+)", &HttpGameStateServer::HandlePlayerInfo);
+    Route("/api/player/([^/]+)/stats", &HttpGameStateServer::HandlePlayerStats);
+    Route("/api/player/([^/]+)/equipment", &HttpGameStateServer::HandlePlayerEquipment);
+    Route("/api/player/([^/]+)/skills", &HttpGameStateServer::HandlePlayerSkills);
+    Route("/api/player/([^/]+)/skills-full", &HttpGameStateServer::HandlePlayerSkillsFull);
+    Route("/api/player/([^/]+)/quests", &HttpGameStateServer::HandlePlayerQuests);
+    Route("/api/player/([^/]+)/trail", &HttpGameStateServer::HandlePlayerTrail);
+    Route("/api/trails", &HttpGameStateServer::HandleTrails);
+    Route("/api/heatmap", &HttpGameStateServer::HandleHeatmapList);
+    Route("/api/heatmap/(\\d+)", &HttpGameStateServer::HandleHeatmap);
+    Route("/api/events", &HttpGameStateServer::HandleEvents);
+    Route("/api/journal", &HttpGameStateServer::HandleJournal);
+    Route("/api/push", &HttpGameStateServer::HandlePush);
+
+    if (_config.StreamEnable)
+    {
+        Route("/api/players/stream", &HttpGameStateServer::HandlePlayersStream);
+    }
 
-    _server->Get("/api/server", [this](const httplib::Request& req, httplib::Response& res) {
-        HandleServerInfo(req, res);
-    });
+    if (_federation)
+    {
+        Route("/api/federation/players", &HttpGameStateServer::HandleFederationPlayers);
+        Route("/api/federation/server", &HttpGameStateServer::HandleFederationServer);
+        Route("/api/federation/search", &HttpGameStateServer::HandleFederationSearch);
+        Route("/api/federation/leaderboard", &HttpGameStateServer::HandleFederationLeaderboard);
+    }
 
-    _server->Get("/api/host", [this](const httplib::Request& req, httplib::Response& res) {
-        HandleHostInfo(req, res);
-    });
+    // Debug endpoints, disabled unless explicitly enabled in the config
+    if (_config.DebugEnable)
+    {
+        Route("/api/debug/profile", &HttpGameStateServer::HandleDebugProfile);
+        Route("/api/debug/malloc", &HttpGameStateServer::HandleDebugMalloc);
+        Route("/api/debug/snapshot", &HttpGameStateServer::HandleDebugSnapshot);
+    }
 
-    _server->Get("/api/players", [this](const httplib::Request& req, httplib::Response& res) {
-        HandleOnlinePlayers(req, res);
-    });
+    // Set up CORS and error handling
+    for (Listener& listener : _listeners)
+    {
+        listener.Server->set_pre_routing_handler([](const httplib::Request& /*req*/, httplib::Response& res) {
+            SystemMetricsSampler::RegisterCurrentThread("api");
+            res.set_header("Access-Control-Allow-Origin", "*");
+            res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
+            res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
+            return httplib::Server::HandlerResponse::Unhandled;
+        });
+    }
+}
 
-    _server->Get("/api/player/([^/]+)", [this](const httplib::Request& req, httplib::Response& res) {
-        HandlePlayerInfo(req, res);
-    });
+HttpGameStateServer::~HttpGameStateServer()
+{
+    Stop();
+}
 
-    _server->Get("/api/player/([^/]+)/stats", [this](const httplib::Request& req, httplib::Response& res) {
-        HandlePlayerStats(req, res);
-    });
+void HttpGameStateServer::Route(const char* pattern, RouteHandler handler)
+{
+    std::string route = pattern;
+    auto routeHandler = [this, route, handler](const httplib::Request& req, httplib::Response& res) {
+        AllocationTracking::Counters allocStart = AllocationTracking::ThreadCounters();
+        auto arrival = std::chrono::system_clock::now();
+        auto wallStart = std::chrono::steady_clock::now();
+        uint64 cpuStart = RequestAccounting::ThreadCpuNs();
+
+        (this->*handler)(req, res);
+
+        // Serialization and compression by httplib happen after this point and are not included
+        RequestSample sample;
+        sample.CpuNs = RequestAccounting::ThreadCpuNs() - cpuStart;
+        sample.WallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wallStart).count();
+        AllocationTracking::Counters allocEnd = AllocationTracking::ThreadCounters();
+        sample.Allocations = allocEnd.Allocations - allocStart.Allocations;
+        sample.AllocatedBytes = allocEnd.Bytes - allocStart.Bytes;
+        sample.Status = res.status;
+        sample.ResponseBytes = res.body.size();
+
+        std::string client = GetClientKey(req);
+        _accounting->Record(route, client, sample);
+
+        if (_recorder)
+        {
+            _recorder->Append(req.target, res.status,
+                std::chrono::duration_cast<std::chrono::microseconds>(arrival.time_since_epoch()).count(),
+                uint32(std::min<uint64>(sample.WallNs / 1000, std::numeric_limits<uint32>::max())),
+                uint32(std::hash<std::string>{}(client)));
+        }
+    };
+
+    for (Listener& listener : _listeners)
+        listener.Server->Get(pattern, routeHandler);
+}
+
+std::string HttpGameStateServer::GetClientKey(const httplib::Request& req)
+{
+    // Never keep the key itself around, only a fingerprint of it
+    std::string apiKey = req.get_header_value("X-API-Key");
+    if (!apiKey.empty())
+        return fmt::format("key:{:016x}", std::hash<std::string>{}(apiKey));
 
-    _server->Get("/api/player/([^/]+)/equipment", [this](const httplib::Request& req, httplib::Response& res) {
-        HandlePlayerEquipment(req, res);
+    return req.remote_addr;
+}
+
+void HttpGameStateServer::RegisterHistoryMetrics()
+{
+    _history->AddMetric("players.online", "players", MetricKind::Gauge, []() { return double(sWorldSessionMgr->GetPlayerCount()); });
+    _history->AddMetric("sessions.active", "sessions", MetricKind::Gauge, []() { return double(sWorldSessionMgr->GetActiveSessionCount()); });
+    _history->AddMetric("sessions.queued", "sessions", MetricKind::Peak, []() { return double(sWorldSessionMgr->GetQueuedSessionCount()); });
+
+    // The tick histogram is cumulative, so each sample covers the ticks since the previous one
+    auto ticksSince = [previous = LatencyHistogram()]() mutable
+    {
+        LatencyHistogram now = SystemMetricsSampler::GetWorldTickHistogram();
+        LatencyHistogram window = HistogramSince(now, previous);
+        previous = now;
+        return window;
+    };
+    _history->AddMetric("world.tick_mean_ms", "ms", MetricKind::Gauge, [ticksSince]() mutable { return ticksSince().MeanMs(); });
+    _history->AddMetric("world.tick_p99_ms", "ms", MetricKind::Peak, [ticksSince]() mutable { return ticksSince().Quantile(0.99); });
+
+    _history->AddMetric("process.cpu_percent", "percent", MetricKind::Gauge, [this]() { return _sampler->GetProcessMetrics().CpuPercent; });
+    _history->AddMetric("process.rss_bytes", "bytes", MetricKind::Gauge, [this]() { return double(_sampler->GetProcessMetrics().RssBytes); });
+    _history->AddMetric("host.cpu_percent", "percent", MetricKind::Gauge, [this]() { return _sampler->GetHostCpuMetrics().Total.Busy; });
+    _history->AddMetric("cgroup.memory_bytes", "bytes", MetricKind::Gauge, [this]() { return double(_sampler->GetCgroupMetrics().WorkingSet()); });
+
+    _history->AddMetric("http.requests", "requests/s", MetricKind::Counter, [this]()
+    {
+        uint64 requests = 0;
+        for (RequestCost const& route : _accounting->GetRoutes())
+            requests += route.Requests;
+        return double(requests);
     });
 
-    _server->Get("/api/player/([^/]+)/skills", [this](const httplib::Request& req, httplib::Response& res) {
-        HandlePlayerSkills(req, res);
-    });
+    if (_dbMonitor)
+    {
+        for (DatabasePoolMetrics const& pool : _dbMonitor->GetMetrics().Pools)
+        {
+            std::string name = pool.Name;
+            _history->AddMetric("db.queue." + name, "queries", MetricKind::Peak, [this, name]()
+            {
+                for (DatabasePoolMetrics const& current : _dbMonitor->GetMetrics().Pools)
+                    if (current.Name == name)
+                        return double(current.QueueSize);
+                return 0.0;
+            });
+        }
+    }
+}
+
+void HttpGameStateServer::OnWorldUpdate(uint32 diff)
+{
+    if (_snapshotPending.load(std::memory_order_acquire))
+        CaptureSnapshot();
+
+    bool recordTrails = false;
+    if (_trails)
+    {
+        _trailElapsedMs += diff;
+        recordTrails = _trailElapsedMs >= _trails->GetIntervalMs();
+        if (recordTrails)
+            _trailElapsedMs = 0;
+    }
+
+    bool recordHeatmaps = false;
+    if (_heatmaps)
+    {
+        _heatmapElapsedMs += diff;
+        recordHeatmaps = _heatmapElapsedMs >= _heatmaps->GetIntervalMs();
+        if (recordHeatmaps)
+            _heatmapElapsedMs = 0;
+    }
+
+    bool recordJournal = false;
+    if (_journal)
+    {
+        _journalElapsedMs += diff;
+        recordJournal = _journalElapsedMs >= _config.JournalIntervalMs;
+        if (recordJournal)
+            _journalElapsedMs = 0;
+    }
+
+    bool recordPush = false;
+    if (_pusher)
+    {
+        _pushElapsedMs += diff;
+        recordPush = _pushElapsedMs >= _config.PushIntervalMs;
+        if (recordPush)
+            _pushElapsedMs = 0;
+    }
+
+    bool recordFeed = false;
+    if (_feed)
+    {
+        _feedElapsedMs += diff;
+        recordFeed = _feedElapsedMs >= _config.StreamIntervalMs;
+        if (recordFeed)
+            _feedElapsedMs = 0;
+    }
+
+    if (!recordTrails && !recordHeatmaps && !recordJournal && !recordPush && !recordFeed)
+        return;
+
+    // Player state may only be read here, on the world thread
+    const auto& sessions = sWorldSessionMgr->GetAllSessions();
+    std::vector<PlayerPosition> positions;
+    std::vector<JournalPlayer> generation;
+    positions.reserve(sessions.size());
+    bool captureGeneration = recordJournal || recordPush || recordFeed;
+    if (captureGeneration)
+        generation.reserve(sessions.size());
+    for (const auto& [accountId, session] : sessions)
+    {
+        Player* player = session->GetPlayer();
+        if (!player || !player->IsInWorld())
+            continue;
+
+        if (captureGeneration)
+        {
+            JournalPlayer& entry = generation.emplace_back();
+            entry.Guid = uint32(player->GetGUID().GetCounter());
+            entry.Name = player->GetName();
+            entry.Level = player->GetLevel();
+            entry.Class = player->getClass();
+            entry.Race = player->getRace();
+            entry.Gender = player->getGender();
+            entry.Map = player->GetMapId();
+            entry.Zone = player->GetZoneId();
+            entry.Area = player->GetAreaId();
+            entry.X = player->GetPositionX();
+            entry.Y = player->GetPositionY();
+            entry.Z = player->GetPositionZ();
+            entry.GuildId = player->GetGuildId();
+            if (Guild* guild = sGuildMgr->GetGuildById(entry.GuildId))
+                entry.Guild = guild->GetName();
+            for (uint8 slot = EQUIPMENT_SLOT_START; slot < EQUIPMENT_SLOT_END; ++slot)
+                if (Item* item = player->GetItemByPos(INVENTORY_SLOT_BAG_0, slot))
+                    entry.Equipment[slot] = item->GetEntry();
+        }
+
+        PlayerPosition& position = positions.emplace_back();
+        position.Guid = uint32(player->GetGUID().GetCounter());
+        position.Name = player->GetName();
+        position.Map = player->GetMapId();
+        position.Zone = player->GetZoneId();
+        position.X = player->GetPositionX();
+        position.Y = player->GetPositionY();
+        position.Z = player->GetPositionZ();
+        position.Orientation = player->GetOrientation();
+        position.Flags = (player->IsAlive() ? 0 : TRAIL_FLAG_DEAD)
+            | (player->IsInCombat() ? TRAIL_FLAG_IN_COMBAT : 0)
+            | (player->IsMounted() ? TRAIL_FLAG_MOUNTED : 0);
+    }
+
+    time_t now = std::time(nullptr);
+    if (recordTrails)
+        _trails->Record(now, positions);
+    if (recordHeatmaps)
+        _heatmaps->Record(now, positions);
+    // The last consumer of the capture takes it, the others get a copy
+    if (recordJournal)
+        _journal->Submit(now, recordPush || recordFeed ? generation : std::move(generation));
+    if (recordPush)
+        _pusher->Submit(now, recordFeed ? generation : std::move(generation));
+    if (recordFeed)
+        _feed->Publish(now, std::move(generation));
+}
+
+void HttpGameStateServer::CaptureSnapshot()
+{
+    std::shared_ptr<SnapshotCapture> capture;
+    {
+        // The request stays in place until it is done, so the handler keeps answering 409 meanwhile
+        std::lock_guard<std::mutex> lock(_snapshotMutex);
+        capture = _snapshotRequest;
+        _snapshotPending.store(false, std::memory_order_relaxed);
+    }
+
+    if (!capture)
+        return;
+
+    // Collected outside the lock, the handler only reads it once Done is set
+    nlohmann::json data;
+    bool captured = true;
+    try
+    {
+        data = GameStateUtilities::GetSnapshotData(capture->Anonymize);
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error capturing snapshot: {}", e.what());
+        captured = false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_snapshotMutex);
+        capture->Data = std::move(data);
+        capture->Done = captured;
+        capture->Cancelled = !captured;
+        if (_snapshotRequest == capture)
+            _snapshotRequest.reset();
+    }
+    _snapshotCondition.notify_all();
+}
+
+bool HttpGameStateServer::Start()
+{
+    if (_running.load())
+    {
+        LOG_WARN("module.gamestate_api", "HTTP server is already running");
+        return false;
+    }
+
+    LOG_INFO("module.gamestate_api", "Starting HTTP server on {}:{} with {} listener(s)", _config.Host, _config.Port, _listeners.size());
+    _workers = std::make_unique<httplib::ThreadPool>(CPPHTTPLIB_THREAD_POOL_COUNT);
+
+    bool listening = true;
+    for (size_t i = 0; i < _listeners.size(); ++i)
+    {
+        Listener& listener = _listeners[i];
+        if (!listener.Server->bind_to_port(_config.Host, _config.Port))
+        {
+            LOG_ERROR("module.gamestate_api", "Failed to start HTTP server on {}:{}", _config.Host, _config.Port);
+            listening = false;
+            break;
+        }
+
+        std::string threadName = _listeners.size() == 1 ? "gsapi-listen" : fmt::format("gsapi-listen{}", i);
+        httplib::Server* server = listener.Server.get();
+        listener.Thread = std::make_unique<std::thread>([server, threadName]() {
+#ifndef _WIN32
+            pthread_setname_np(pthread_self(), threadName.c_str());
+#endif
+            SystemMetricsSampler::RegisterCurrentThread("api");
+            if (!server->listen_after_bind())
+            {
+                LOG_ERROR("module.gamestate_api", "HTTP listener {} stopped accepting connections", threadName);
+            }
+        });
+
+        // stop() only reaches a listener whose accept loop is already running
+        listener.Server->wait_until_ready();
+    }
+
+    if (listening)
+    {
+        _running.store(true);
+        _sampler->Start();
+        if (_dbMonitor)
+        {
+            _dbMonitor->Start();
+        }
+        if (_history)
+        {
+            _history->Start();
+        }
+        if (_events)
+        {
+            _events->Start();
+        }
+        if (_journal)
+        {
+            _journal->Start();
+        }
+        if (_pusher)
+        {
+            _pusher->Start();
+        }
+        if (_federation)
+        {
+            _federation->Start();
+        }
+        LOG_INFO("module.gamestate_api", "Game State API HTTP server started successfully on {}:{}", _config.Host, _config.Port);
+        return true;
+    }
+    else
+    {
+        LOG_ERROR("module.gamestate_api", "Failed to start Game State API HTTP server");
+        StopListeners();
+        return false;
+    }
+}
+
+void HttpGameStateServer::Stop()
+{
+    if (_sampler)
+    {
+        _sampler->Stop();
+    }
+
+    if (_dbMonitor)
+    {
+        _dbMonitor->Stop();
+    }
+
+    if (_history)
+    {
+        _history->Stop();
+    }
+
+    if (_events)
+    {
+        _events->Stop();
+    }
+
+    if (_journal)
+    {
+        _journal->Stop();
+    }
+
+    if (_pusher)
+    {
+        _pusher->Stop();
+    }
+
+    if (_federation)
+    {
+        _federation->Stop();
+    }
+
+    // Stream subscribers wait on the feed and would keep the HTTP workers busy
+    if (_feed)
+    {
+        _feed->Close();
+    }
+
+    // The world thread no longer updates us, a waiting snapshot gives up
+    {
+        std::lock_guard<std::mutex> lock(_snapshotMutex);
+        if (_snapshotRequest)
+            _snapshotRequest->Cancelled = true;
+        _snapshotRequest.reset();
+        _snapshotPending.store(false, std::memory_order_relaxed);
+    }
+    _snapshotCondition.notify_all();
+
+    if (!_running.load())
+    {
+        return;
+    }
+
+    LOG_INFO("module.gamestate_api", "Stopping HTTP server...");
+
+    StopListeners();
+
+    _running.store(false);
+    LOG_INFO("module.gamestate_api", "HTTP server stopped");
+}
+
+void HttpGameStateServer::StopListeners()
+{
+    for (Listener& listener : _listeners)
+    {
+        listener.Server->stop();
+    }
+
+    for (Listener& listener : _listeners)
+    {
+        if (listener.Thread && listener.Thread->joinable())
+        {
+            listener.Thread->join();
+        }
+        listener.Thread.reset();
+    }
+
+    // Connections still being served end once their listener's socket is closed
+    if (_workers)
+    {
+        _workers->shutdown();
+        _workers.reset();
+    }
+}
+
+void HttpGameStateServer::HandleHealthCheck(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    json response = {
+        {"status", "ok"},
+        {"timestamp", std::time(nullptr)},
+        {"uptime_seconds", GameTime::GetUptime().count()}
+    };
+
+    SendJsonResponse(res, response.dump(2));
+}
+
+void HttpGameStateServer::HandleHostInfo(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    // Static variables to track peak values since server start
+    static double peakCpuUsage = 0.0;
+    static uint64_t peakMemUsage = 0;
+
+    try
+    {
+        json response;
+        double currentCpuUsage = 0.0;
+        uint64_t currentMemUsage = 0;
+
+#ifdef _WIN32
+        // Windows implementation
+
+        // Host uptime
+        ULONGLONG uptimeMs = GetTickCount64();
+        response["uptime_seconds"] = uptimeMs / 1000;
+
+        // Get current CPU usage using GetSystemTimes
+        FILETIME idleTime, kernelTime, userTime;
+        static FILETIME prevIdleTime = {0}, prevKernelTime = {0}, prevUserTime = {0};
+        static bool firstCall = true;
+
+        if (GetSystemTimes(&idleTime, &kernelTime, &userTime))
+        {
+            if (firstCall)
+            {
+                prevIdleTime = idleTime;
+                prevKernelTime = kernelTime;
+                prevUserTime = userTime;
+                firstCall = false;
+                currentCpuUsage = 0.0;
+            }
+            else
+            {
+                ULONGLONG idle = (((ULONGLONG)idleTime.dwHighDateTime << 32) | idleTime.dwLowDateTime) -
+                                 (((ULONGLONG)prevIdleTime.dwHighDateTime << 32) | prevIdleTime.dwLowDateTime);
+                ULONGLONG kernel = (((ULONGLONG)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime) -
+                                   (((ULONGLONG)prevKernelTime.dwHighDateTime << 32) | prevKernelTime.dwLowDateTime);
+                ULONGLONG user = (((ULONGLONG)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime) -
+                                 (((ULONGLONG)prevUserTime.dwHighDateTime << 32) | prevUserTime.dwLowDateTime);
+
+                ULONGLONG total = kernel + user;
+                currentCpuUsage = (total > 0) ? (1.0 - ((double)idle / (double)total)) * 100.0 : 0.0;
+                currentCpuUsage = std::round(currentCpuUsage * 100.0) / 100.0;
+
+                prevIdleTime = idleTime;
+                prevKernelTime = kernelTime;
+                prevUserTime = userTime;
+            }
+        }
+
+        // Memory information
+        MEMORYSTATUSEX memInfo;
+        memInfo.dwLength = sizeof(MEMORYSTATUSEX);
+        if (GlobalMemoryStatusEx(&memInfo))
+        {
+            currentMemUsage = memInfo.ullTotalPhys - memInfo.ullAvailPhys;
+        }
+
+#else
+        // Linux implementation
+
+        // Host uptime
+        struct sysinfo si;
+        if (sysinfo(&si) == 0)
+        {
+            response["uptime_seconds"] = si.uptime;
+        }
+        else
+        {
+            response["uptime_seconds"] = 0;
+        }
+
+        // Memory usage from /proc/meminfo (container-aware on Proxmox)
+        {
+            unsigned long long memTotal = 0, memAvailable = 0;
+            std::ifstream memInfoFile("/proc/meminfo");
+            if (memInfoFile.is_open())
+            {
+                std::string line;
+                while (std::getline(memInfoFile, line))
+                {
+                    unsigned long long value;
+                    if (sscanf(line.c_str(), "MemTotal: %llu kB", &value) == 1)
+                        memTotal = value * 1024ULL;
+                    else if (sscanf(line.c_str(), "MemAvailable: %llu kB", &value) == 1)
+                        memAvailable = value * 1024ULL;
+                }
+                memInfoFile.close();
+            }
+
+            response["total_mem"] = memTotal;
+            currentMemUsage = memTotal - memAvailable;
+        }
+
+        // CPU usage from the sampler's /proc/stat deltas (iowait counts as idle)
+        HostCpuMetrics hostCpu = _sampler->GetHostCpuMetrics();
+        if (hostCpu.Available)
+        {
+            currentCpuUsage = hostCpu.Total.Busy;
+            response["cpu"] = CpuUtilizationToJson(hostCpu.Total);
+
+            json cores = json::array();
+            for (size_t i = 0; i < hostCpu.Cores.size(); ++i)
+            {
+                json core = CpuUtilizationToJson(hostCpu.Cores[i]);
+                core["id"] = hostCpu.CoreIds[i];
+                cores.push_back(std::move(core));
+            }
+            response["cpu"]["cores"] = std::move(cores);
+        }
+
+        // In a container the cgroup limits are what capacity alerts care about,
+        // so they replace the host-wide values whenever a limit is set
+        std::string limitsSource = "host";
+        CgroupMetrics cgroup = _sampler->GetCgroupMetrics();
+        if (cgroup.Available)
+        {
+            if (cgroup.HasMemoryLimit())
+            {
+                response["total_mem"] = cgroup.MemoryMax;
+                currentMemUsage = cgroup.MemoryCurrent;
+                limitsSource = "cgroup";
+            }
+
+            if (cgroup.HasCpuLimit())
+            {
+                currentCpuUsage = cgroup.CpuPercent;
+                limitsSource = "cgroup";
+            }
+
+            response["cgroup"] = {
+                {"path", cgroup.Path},
+                {"memory", {
+                    {"current", cgroup.MemoryCurrent},
+                    {"max", cgroup.HasMemoryLimit() ? json(cgroup.MemoryMax) : json(nullptr)},
+                    {"working_set", cgroup.WorkingSet()},
+                    {"pressure", PressureToJson(cgroup.MemoryPressure)}
+                }},
+                {"cpu", {
+                    {"quota_cpus", cgroup.HasCpuLimit() ? json(cgroup.CpuQuota) : json(nullptr)},
+                    {"percent", cgroup.CpuPercent},
+                    {"usage_usec", cgroup.CpuUsageUsec},
+                    {"user_usec", cgroup.CpuUserUsec},
+                    {"system_usec", cgroup.CpuSystemUsec},
+                    {"nr_periods", cgroup.NrPeriods},
+                    {"nr_throttled", cgroup.NrThrottled},
+                    {"throttled_usec", cgroup.ThrottledUsec},
+                    {"throttled_percent", cgroup.ThrottledPercent}
+                }}
+            };
+        }
+        response["limits_source"] = limitsSource;
+        response["pressure"] = PressureMetricsToJson(_sampler->GetPressureMetrics());
+#endif
+
+        // Update peak values
+        if (currentCpuUsage > peakCpuUsage)
+        {
+            peakCpuUsage = currentCpuUsage;
+        }
+        if (currentMemUsage > peakMemUsage)
+        {
+            peakMemUsage = currentMemUsage;
+        }
+
+        // Build response
+        response["current_cpu"] = currentCpuUsage;
+        response["max_cpu"] = peakCpuUsage;
+        response["current_mem"] = currentMemUsage;
+        response["max_mem"] = peakMemUsage;
+
+        response["timestamp"] = std::time(nullptr);
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting host info: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleHostCpu(const httplib::Request& req, httplib::Response& res)
+{
+    try
+    {
+        uint32 samples = std::min(GetUIntParam(req, "samples", _config.SamplerHistorySize), _config.SamplerHistorySize);
+        std::vector<CpuSeriesSample> history = _sampler->GetCpuHistory(samples);
+        HostCpuMetrics hostCpu = _sampler->GetHostCpuMetrics();
+
+        // Columnar layout: one array per core and metric, aligned with "timestamps"
+        json timestamps = json::array();
+        json totalBusy = json::array();
+        json totalSteal = json::array();
+        json totalIowait = json::array();
+        for (const CpuSeriesSample& point : history)
+        {
+            timestamps.push_back(point.Timestamp);
+            totalBusy.push_back(point.TotalBusy);
+            totalSteal.push_back(point.TotalSteal);
+            totalIowait.push_back(point.TotalIowait);
+        }
+
+        json cores = json::array();
+        for (size_t core = 0; core < hostCpu.CoreIds.size(); ++core)
+        {
+            json busy = json::array();
+            json steal = json::array();
+            json iowait = json::array();
+            for (const CpuSeriesSample& point : history)
+            {
+                bool present = core < point.Busy.size();
+                busy.push_back(present ? json(point.Busy[core]) : json(nullptr));
+                steal.push_back(present ? json(point.Steal[core]) : json(nullptr));
+                iowait.push_back(present ? json(point.Iowait[core]) : json(nullptr));
+            }
+
+            cores.push_back({
+                {"id", hostCpu.CoreIds[core]},
+                {"busy", std::move(busy)},
+                {"steal", std::move(steal)},
+                {"iowait", std::move(iowait)}
+            });
+        }
+
+        json response = {
+            {"interval_ms", _sampler->GetIntervalMs()},
+            {"samples", history.size()},
+            {"timestamps", std::move(timestamps)},
+            {"total", {
+                {"busy", std::move(totalBusy)},
+                {"steal", std::move(totalSteal)},
+                {"iowait", std::move(totalIowait)}
+            }},
+            {"cores", std::move(cores)},
+            {"timestamp", std::time(nullptr)}
+        };
+
+        SendJsonResponse(res, response.dump());
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting host cpu history: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleHostIo(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    try
+    {
+        HostIoMetrics io = _sampler->GetHostIoMetrics();
+        if (!io.Available)
+        {
+            SendErrorResponse(res, "Host I/O metrics are not supported on this platform", 501);
+            return;
+        }
+
+        json disks = json::array();
+        for (const DiskMetrics& disk : io.Disks)
+        {
+            disks.push_back({
+                {"device", disk.Device},
+                {"read_iops", disk.ReadIops},
+                {"write_iops", disk.WriteIops},
+                {"read_bytes_per_sec", disk.ReadBytesPerSec},
+                {"write_bytes_per_sec", disk.WriteBytesPerSec},
+                {"await_ms", disk.AwaitMs},
+                {"utilization_percent", disk.UtilizationPercent},
+                {"in_flight", disk.InFlight}
+            });
+        }
+
+        json interfaces = json::array();
+        for (const NetInterfaceMetrics& iface : io.Interfaces)
+        {
+            interfaces.push_back({
+                {"interface", iface.Interface},
+                {"rx_bytes_per_sec", iface.RxBytesPerSec},
+                {"tx_bytes_per_sec", iface.TxBytesPerSec},
+                {"rx_packets_per_sec", iface.RxPacketsPerSec},
+                {"tx_packets_per_sec", iface.TxPacketsPerSec},
+                {"rx_drops_per_sec", iface.RxDropsPerSec},
+                {"tx_drops_per_sec", iface.TxDropsPerSec},
+                {"rx_drops", iface.RxDrops},
+                {"tx_drops", iface.TxDrops},
+                {"rx_errors", iface.RxErrors},
+                {"tx_errors", iface.TxErrors}
+            });
+        }
+
+        json response = {
+            {"disks", std::move(disks)},
+            {"interfaces", std::move(interfaces)},
+            {"sample_interval_ms", _sampler->GetIntervalMs()},
+            {"sampled_at", io.Timestamp},
+            {"timestamp", std::time(nullptr)}
+        };
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting host io info: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleHostPressure(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    try
+    {
+        PressureMetrics pressure = _sampler->GetPressureMetrics();
+
+        json triggers = json::array();
+        for (const PressureTrigger& trigger : _sampler->GetPressureTriggers())
+        {
+            triggers.push_back({
+                {"trigger", trigger.Name},
+                {"threshold", trigger.Threshold},
+                {"active", trigger.Active},
+                {"since", trigger.ActiveSince}
+            });
+        }
+
+        json events = json::array();
+        for (const PressureEvent& event : _sampler->GetPressureEvents())
+        {
+            events.push_back({
+                {"timestamp", event.Timestamp},
+                {"trigger", event.Trigger},
+                {"state", event.Rising ? "above" : "below"},
+                {"value", event.Value},
+                {"threshold", event.Threshold},
+                {"world_tick_max_ms", event.WorldTickMaxMs},
+                {"duration_seconds", event.DurationSeconds}
+            });
+        }
+
+        json response = PressureMetricsToJson(pressure);
+        response["world_tick_max_ms"] = pressure.WorldTickMaxMs;
+        response["triggers"] = std::move(triggers);
+        response["events"] = std::move(events);
+        response["sampled_at"] = pressure.Timestamp;
+        response["timestamp"] = std::time(nullptr);
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting pressure info: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleMetrics(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    try
+    {
+        MetricsWriter writer;
+
+        writer.Family("gamestate_players_online", "gauge", "Players currently in world");
+        writer.Sample("gamestate_players_online", sWorldSessionMgr->GetPlayerCount());
+        writer.Family("gamestate_sessions", "gauge", "World sessions by state");
+        writer.Sample("gamestate_sessions", sWorldSessionMgr->GetActiveSessionCount(), "state=\"active\"");
+        writer.Sample("gamestate_sessions", sWorldSessionMgr->GetQueuedSessionCount(), "state=\"queued\"");
+
+        ProcessMetrics process = _sampler->GetProcessMetrics();
+        writer.Family("gamestate_process_resident_memory_bytes", "gauge", "Resident set size of worldserver");
+        writer.Sample("gamestate_process_resident_memory_bytes", double(process.RssBytes));
+        writer.Family("gamestate_process_cpu_seconds_total", "counter", "CPU time consumed by worldserver");
+        writer.Sample("gamestate_process_cpu_seconds_total", process.UserSeconds, "mode=\"user\"");
+        writer.Sample("gamestate_process_cpu_seconds_total", process.SystemSeconds, "mode=\"system\"");
+        writer.Family("gamestate_process_threads", "gauge", "Threads in worldserver");
+        writer.Sample("gamestate_process_threads", process.Threads);
+        writer.Family("gamestate_process_open_fds", "gauge", "Open file descriptors of worldserver");
+        writer.Sample("gamestate_process_open_fds", process.OpenFds);
+
+        HostCpuMetrics hostCpu = _sampler->GetHostCpuMetrics();
+        if (hostCpu.Available)
+        {
+            writer.Family("gamestate_host_cpu_percent", "gauge", "Host CPU usage over the last sampler interval");
+            writer.Sample("gamestate_host_cpu_percent", hostCpu.Total.Busy, "mode=\"busy\"");
+            writer.Sample("gamestate_host_cpu_percent", hostCpu.Total.Iowait, "mode=\"iowait\"");
+            writer.Sample("gamestate_host_cpu_percent", hostCpu.Total.Steal, "mode=\"steal\"");
+        }
+
+        PressureMetrics pressure = _sampler->GetPressureMetrics();
+        writer.Pressure({
+            { "host", "cpu", pressure.HostCpu },
+            { "host", "memory", pressure.HostMemory },
+            { "host", "io", pressure.HostIo },
+            { "cgroup", "cpu", pressure.CgroupCpu },
+            { "cgroup", "memory", pressure.CgroupMemory },
+            { "cgroup", "io", pressure.CgroupIo }
+        });
+        writer.Family("gamestate_world_tick_seconds", "histogram", "World update diff between ticks");
+        writer.Histogram("gamestate_world_tick_seconds", SystemMetricsSampler::GetWorldTickHistogram(), "");
+
+        writer.Family("gamestate_pressure_trigger_events_total", "counter", "PSI trigger threshold crossings");
+        writer.Sample("gamestate_pressure_trigger_events_total", double(_sampler->GetPressureEventCount()));
+
+        if (_dbMonitor)
+        {
+            DatabaseMetrics db = _dbMonitor->GetMetrics();
+            writer.Family("gamestate_db_queue_size", "gauge", "Queued async operations per database pool");
+            for (const DatabasePoolMetrics& pool : db.Pools)
+                writer.Sample("gamestate_db_queue_size", double(pool.QueueSize), fmt::format("pool=\"{}\"", pool.Name));
+
+            writer.Family("gamestate_db_probe_timeouts_total", "counter", "Database probe queries that did not complete");
+            for (const DatabasePoolMetrics& pool : db.Pools)
+                writer.Sample("gamestate_db_probe_timeouts_total", double(pool.ProbesTimedOut), fmt::format("pool=\"{}\"", pool.Name));
+
+            writer.Family("gamestate_db_probe_latency_seconds", "histogram", "Round trip of a probe query through the async queue");
+            for (const DatabasePoolMetrics& pool : db.Pools)
+                writer.Histogram("gamestate_db_probe_latency_seconds", pool.ProbeLatency, fmt::format("pool=\"{}\"", pool.Name));
+        }
+
+        std::vector<RequestCost> routes = _accounting->GetRoutes();
+        writer.Family("gamestate_http_requests_total", "counter", "HTTP requests handled per route");
+        for (const RequestCost& route : routes)
+            writer.Sample("gamestate_http_requests_total", double(route.Requests), fmt::format("route=\"{}\"", route.Key));
+        writer.Family("gamestate_http_request_cpu_seconds_total", "counter", "Handler thread CPU time per route");
+        for (const RequestCost& route : routes)
+            writer.Sample("gamestate_http_request_cpu_seconds_total", route.CpuSeconds(), fmt::format("route=\"{}\"", route.Key));
+        writer.Family("gamestate_http_accepted_connections_total", "counter", "Connections accepted per listener");
+        for (size_t i = 0; i < _listeners.size(); ++i)
+            writer.Sample("gamestate_http_accepted_connections_total", double(_listeners[i].Accepts->GetTotal()), fmt::format("listener=\"{}\"", i));
+
+        res.status = 200;
+        res.set_content(writer.Str(), "text/plain; version=0.0.4");
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error building metrics: {}", e.what());
+        SendErrorResponse(res, "Internal server error", 500);
+    }
+}
+
+void HttpGameStateServer::HandleListeners(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    try
+    {
+        uint64 accepted = 0;
+        double rate10 = 0.0;
+        double rate60 = 0.0;
+        for (const Listener& listener : _listeners)
+        {
+            accepted += listener.Accepts->GetTotal();
+            rate10 += listener.Accepts->GetRate(10);
+            rate60 += listener.Accepts->GetRate(60);
+        }
+
+        json listeners = json::array();
+        for (size_t i = 0; i < _listeners.size(); ++i)
+        {
+            const ListenerAccepts& accepts = *_listeners[i].Accepts;
+            double listenerRate60 = accepts.GetRate(60);
+            listeners.push_back({
+                {"listener", i},
+                {"accepted", accepts.GetTotal()},
+                {"accepts_per_second", {
+                    {"10s", accepts.GetRate(10)},
+                    {"60s", listenerRate60}
+                }},
+                // An even spread is 1 / listener_count; the kernel picks a listener by hashing the client address and port
+                {"share_60s", rate60 > 0.0 ? listenerRate60 / rate60 : 0.0}
+            });
+        }
+
+        json response = {
+            {"listener_count", _listeners.size()},
+            {"reuseport", _listeners.size() > 1},
+            {"worker_threads", CPPHTTPLIB_THREAD_POOL_COUNT},
+            {"accepted", accepted},
+            {"accepts_per_second", {
+                {"10s", rate10},
+                {"60s", rate60}
+            }},
+            {"listeners", listeners},
+            {"timestamp", std::time(nullptr)}
+        };
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting listener stats: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleProcessInfo(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    try
+    {
+        ProcessMetrics process = _sampler->GetProcessMetrics();
+
+#ifdef _WIN32
+        uint64 pid = GetCurrentProcessId();
+#else
+        uint64 pid = getpid();
+#endif
+
+        json response = {
+            {"pid", pid},
+            {"memory", {
+                {"rss", process.RssBytes},
+                {"pss", process.PssBytes},
+                {"virtual", process.VirtualBytes}
+            }},
+            {"threads", process.Threads},
+            {"open_fds", process.OpenFds},
+            {"context_switches", {
+                {"voluntary", process.VoluntaryCtxSwitches},
+                {"involuntary", process.InvoluntaryCtxSwitches}
+            }},
+            {"page_faults", {
+                {"minor", process.MinorFaults},
+                {"major", process.MajorFaults}
+            }},
+            {"cpu", {
+                {"percent", process.CpuPercent},
+                {"percent_of_host", process.CpuPercentOfHost},
+                {"user_seconds", process.UserSeconds},
+                {"system_seconds", process.SystemSeconds}
+            }},
+            {"sample_interval_ms", _sampler->GetIntervalMs()},
+            {"sampled_at", process.Timestamp},
+            {"timestamp", std::time(nullptr)}
+        };
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting process info: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleProcessThreads(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    try
+    {
+        ProcessThreadMetrics metrics = _sampler->GetThreadMetrics();
+        if (!metrics.Available)
+        {
+            SendErrorResponse(res, "Per-thread metrics are not supported on this platform", 501);
+            return;
+        }
+
+        json threads = json::array();
+        for (const ThreadMetrics& thread : metrics.Threads)
+        {
+            threads.push_back({
+                {"tid", thread.Tid},
+                {"name", thread.Name},
+                {"role", thread.Role},
+                {"cpu_percent", thread.CpuPercent},
+                {"user_seconds", thread.UserSeconds},
+                {"system_seconds", thread.SystemSeconds},
+                {"voluntary_ctx_switches_per_sec", thread.VoluntaryCtxSwitchesPerSec},
+                {"involuntary_ctx_switches_per_sec", thread.InvoluntaryCtxSwitchesPerSec}
+            });
+        }
+
+        json roles = json::object();
+        json api = {{"threads", 0}, {"cpu_percent", 0.0}};
+        for (const ThreadRoleMetrics& role : metrics.Roles)
+        {
+            json roleJson = {
+                {"threads", role.Threads},
+                {"cpu_percent", role.CpuPercent},
+                {"voluntary_ctx_switches_per_sec", role.VoluntaryCtxSwitchesPerSec},
+                {"involuntary_ctx_switches_per_sec", role.InvoluntaryCtxSwitchesPerSec}
+            };
+
+            if (role.Role == "api")
+                api = roleJson;
+
+            roles[role.Role] = std::move(roleJson);
+        }
+
+        json response = {
+            {"api", std::move(api)},
+            {"roles", std::move(roles)},
+            {"threads", std::move(threads)},
+            {"sample_interval_ms", _sampler->GetIntervalMs()},
+            {"sampled_at", metrics.Timestamp},
+            {"timestamp", std::time(nullptr)}
+        };
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting thread info: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleDatabase(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    try
+    {
+        if (!_dbMonitor)
+        {
+            SendErrorResponse(res, "Database monitor is disabled", 404);
+            return;
+        }
+
+        DatabaseMetrics metrics = _dbMonitor->GetMetrics();
+
+        json pools = json::array();
+        for (const DatabasePoolMetrics& pool : metrics.Pools)
+        {
+            const LatencyHistogram& latency = pool.ProbeLatency;
+
+            json buckets = json::array();
+            for (uint32 bucket = 0; bucket <= LatencyHistogram::BUCKET_COUNT; ++bucket)
+            {
+                json le = bucket < LatencyHistogram::BUCKET_COUNT ? json(LatencyHistogram::BOUNDS_MS[bucket]) : json("+Inf");
+                buckets.push_back({{"le_ms", std::move(le)}, {"count", latency.Buckets[bucket]}});
+            }
+
+            pools.push_back({
+                {"pool", pool.Name},
+                {"queue_size", pool.QueueSize},
+                {"peak_queue_size", pool.PeakQueueSize},
+                {"queue_history", pool.QueueHistory},
+                {"probe", {
+                    {"sent", pool.ProbesSent},
+                    {"completed", pool.ProbesCompleted},
+                    {"timed_out", pool.ProbesTimedOut},
+                    {"last_ms", pool.LastProbeMs},
+                    {"mean_ms", latency.MeanMs()},
+                    {"p50_ms", latency.Quantile(0.50)},
+                    {"p99_ms", latency.Quantile(0.99)},
+                    {"max_ms", latency.MaxMs},
+                    {"buckets", std::move(buckets)}
+                }}
+            });
+        }
+
+        json response = {
+            {"pools", std::move(pools)},
+            {"history_timestamps", metrics.HistoryTimestamps},
+            {"probe_interval_ms", _config.DbProbeIntervalMs},
+            {"sampled_at", metrics.Timestamp},
+            {"timestamp", std::time(nullptr)}
+        };
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting database info: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleRequestCpu(const httplib::Request& req, httplib::Response& res)
+{
+    try
+    {
+        uint32 top = GetUIntParam(req, "top", 10);
+
+        auto toJson = [](const std::vector<RequestCost>& costs, const char* keyName) {
+            json result = json::array();
+            for (const RequestCost& cost : costs)
+            {
+                result.push_back({
+                    {keyName, cost.Key},
+                    {"requests", cost.Requests},
+                    {"errors", cost.Errors},
+                    {"cpu_seconds", cost.CpuSeconds()},
+                    {"wall_seconds", cost.WallNs / 1e9},
+                    {"cpu_ms_mean", cost.Requests ? cost.CpuNs / 1e6 / cost.Requests : 0.0},
+                    {"cpu_ms_p99", cost.CpuHistogram.Quantile(0.99)},
+                    {"cpu_ms_max", cost.MaxCpuNs / 1e6},
+                    {"response_bytes", cost.ResponseBytes},
+                    {"allocations", cost.Allocations},
+                    {"allocated_bytes", cost.AllocatedBytes},
+                    {"last_seen", cost.LastSeen}
+                });
+            }
+            return result;
+        };
+
+        json response = {
+            {"routes", toJson(_accounting->GetRoutes(top), "route")},
+            {"clients", toJson(_accounting->GetClients(top), "client")},
+            {"tracked_clients", _accounting->GetClientCount()},
+            {"max_tracked_clients", RequestAccounting::MAX_CLIENTS},
+            {"allocation_tracking", AllocationTracking::IsEnabled()},
+            {"since", _accounting->GetSince()},
+            {"timestamp", std::time(nullptr)}
+        };
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting request cpu stats: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleHistoryList(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    try
+    {
+        if (!_history)
+        {
+            SendErrorResponse(res, "Metric history is disabled", 404);
+            return;
+        }
+
+        json metrics = json::array();
+        for (MetricInfo const& metric : _history->GetMetrics())
+        {
+            metrics.push_back({
+                {"metric", metric.Name},
+                {"unit", metric.Unit},
+                {"kind", MetricKindName(metric.Kind)},
+                {"oldest", metric.OldestTimestamp}
+            });
+        }
+
+        json resolutions = json::array();
+        for (MetricHistory::Resolution const& resolution : MetricHistory::RESOLUTIONS)
+        {
+            resolutions.push_back({
+                {"step", resolution.StepSeconds},
+                {"retention_seconds", uint64(resolution.StepSeconds) * resolution.Retention}
+            });
+        }
+
+        json response = {
+            {"metrics", metrics},
+            {"resolutions", resolutions},
+            {"memory_bytes", _history->GetMemoryBytes()},
+            {"file", _history->GetFile()},
+            {"timestamp", std::time(nullptr)}
+        };
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error listing metric history: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleHistory(const httplib::Request& req, httplib::Response& res)
+{
+    try
+    {
+        if (!_history)
+        {
+            SendErrorResponse(res, "Metric history is disabled", 404);
+            return;
+        }
+
+        static constexpr int64 MAX_POINTS = 10000;
+
+        static constexpr uint64 MAX_TIME = uint64(std::numeric_limits<int64>::max());
+        uint64 toParam = uint64(std::time(nullptr));
+        if (!ParseUInt64Param(req, "to", toParam) || toParam > MAX_TIME)
+        {
+            SendErrorResponse(res, "Parameter 'to' must be a unix time in seconds", 400);
+            return;
+        }
+
+        uint64 fromParam = toParam > 3600 ? toParam - 3600 : 0;
+        if (!ParseUInt64Param(req, "from", fromParam) || fromParam > MAX_TIME)
+        {
+            SendErrorResponse(res, "Parameter 'from' must be a unix time in seconds", 400);
+            return;
+        }
+
+        int64 to = int64(toParam);
+        int64 from = int64(fromParam);
+        if (from > to)
+        {
+            SendErrorResponse(res, "Parameter 'from' must not be after 'to'", 400);
+            return;
+        }
+
+        // By default aim for about 1000 points
+        uint32 step = uint32(std::min<int64>((to - from) / 1000 + 1, std::numeric_limits<uint32>::max()));
+        if (!ParseUIntParam(req, "step", step))
+        {
+            SendErrorResponse(res, "Parameter 'step' must be a number of seconds", 400);
+            return;
+        }
+
+        if (!step || (to - from) / step + 1 > MAX_POINTS)
+        {
+            SendErrorResponse(res, fmt::format("Range of {}s at step {}s exceeds {} points", to - from, step, MAX_POINTS), 400);
+            return;
+        }
+
+        std::string metric = req.matches[1];
+        std::vector<MetricSeriesPoint> points;
+        uint32 resolution = 0;
+        if (!_history->Query(metric, from, to, step, points, resolution))
+        {
+            SendErrorResponse(res, "Unknown metric: " + metric, 404);
+            return;
+        }
+
+        std::string unit;
+        for (MetricInfo const& info : _history->GetMetrics())
+            if (info.Name == metric)
+                unit = info.Unit;
+
+        json timestamps = json::array();
+        json values = json::array();
+        for (MetricSeriesPoint const& point : points)
+        {
+            timestamps.push_back(point.Timestamp);
+            values.push_back(point.Value);
+        }
+
+        json response = {
+            {"metric", metric},
+            {"unit", unit},
+            {"from", from},
+            {"to", to},
+            {"step", step},
+            {"resolution", resolution},
+            {"timestamps", timestamps},
+            {"values", values}
+        };
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting metric history: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleDebugProfile(const httplib::Request& req, httplib::Response& res)
+{
+    uint32 seconds = std::clamp<uint32>(GetUIntParam(req, "seconds", 10), 1, _config.ProfileMaxSeconds);
+    uint32 hz = std::clamp<uint32>(GetUIntParam(req, "hz", 99), 1, _config.ProfileMaxHz);
+
+    if (SamplingProfiler::IsRunning())
+    {
+        SendErrorResponse(res, "A profile is already running", 409);
+        return;
+    }
+
+    LOG_INFO("module.gamestate_api", "Profiling worldserver for {}s at {} Hz", seconds, hz);
+
+    SamplingProfiler::Result result;
+    if (!SamplingProfiler::Run(seconds, hz, result))
+    {
+        SendErrorResponse(res, result.Error, SamplingProfiler::IsRunning() ? 409 : 500);
+        return;
+    }
+
+    LOG_INFO("module.gamestate_api", "Profile finished: {} samples from {} threads, {} dropped",
+        result.Samples, result.Threads, result.Dropped);
+
+    res.set_header("X-Profile-Samples", std::to_string(result.Samples));
+    res.set_header("X-Profile-Dropped", std::to_string(result.Dropped));
+    res.set_header("X-Profile-Threads", std::to_string(result.Threads));
+    res.status = 200;
+    res.set_content(result.Collapsed, "text/plain");
+}
+
+void HttpGameStateServer::HandleDebugMalloc(const httplib::Request& req, httplib::Response& res)
+{
+    try
+    {
+        if (req.has_param("format") && req.get_param_value("format") == "xml")
+        {
+            std::string xml = AllocatorStats::MallocInfoXml();
+            if (xml.empty())
+            {
+                SendErrorResponse(res, "malloc_info is not available with this allocator", 501);
+                return;
+            }
+
+            res.status = 200;
+            res.set_content(xml, "application/xml");
+            return;
+        }
+
+        AllocatorMetrics current = AllocatorStats::Collect();
+        if (!current.Available)
+        {
+            SendErrorResponse(res, "Allocator statistics are not supported on this platform", 501);
+            return;
+        }
+
+        json extra = json::object();
+        for (const auto& [name, value] : current.Extra)
+            extra[name] = value;
+
+        json timestamps = json::array();
+        json inUse = json::array();
+        json freeBytes = json::array();
+        json arena = json::array();
+        json mmap = json::array();
+        for (const AllocatorSample& sample : _sampler->GetAllocatorHistory())
+        {
+            timestamps.push_back(sample.Timestamp);
+            inUse.push_back(sample.InUseBytes);
+            freeBytes.push_back(sample.FreeBytes);
+            arena.push_back(sample.ArenaBytes);
+            mmap.push_back(sample.MmapBytes);
+        }
+
+        json response = {
+            {"allocator", current.Allocator},
+            {"arena_bytes", current.ArenaBytes},
+            {"mmap_bytes", current.MmapBytes},
+            {"in_use_bytes", current.InUseBytes},
+            {"free_bytes", current.FreeBytes},
+            {"releasable_bytes", current.ReleasableBytes},
+            {"mmap_chunks", current.MmapChunks},
+            {"free_chunks", current.FreeChunks},
+            {"fragmentation_ratio", std::round(current.FragmentationRatio() * 10000.0) / 10000.0},
+            {"extra", std::move(extra)},
+            {"history", {
+                {"interval_seconds", _sampler->GetAllocatorIntervalSeconds()},
+                {"timestamps", std::move(timestamps)},
+                {"in_use_bytes", std::move(inUse)},
+                {"free_bytes", std::move(freeBytes)},
+                {"arena_bytes", std::move(arena)},
+                {"mmap_bytes", std::move(mmap)}
+            }},
+            {"timestamp", current.Timestamp}
+        };
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting allocator stats: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleDebugSnapshot(const httplib::Request& req, httplib::Response& res)
+{
+    try
+    {
+        auto capture = std::make_shared<SnapshotCapture>();
+        capture->Anonymize = req.has_param("anonymize") && req.get_param_value("anonymize") == "true";
+        bool anonymize = capture->Anonymize;
+
+        // Players are walked on the world thread at its next update, only the encoding happens here
+        {
+            std::unique_lock<std::mutex> lock(_snapshotMutex);
+            if (_snapshotRequest)
+            {
+                SendErrorResponse(res, "A snapshot is already being captured", 409);
+                return;
+            }
+
+            _snapshotRequest = capture;
+            _snapshotPending.store(true, std::memory_order_release);
+            _snapshotCondition.wait_for(lock, std::chrono::seconds(SNAPSHOT_TIMEOUT_SECONDS),
+                [&capture]() { return capture->Done || capture->Cancelled; });
+            if (!capture->Done)
+            {
+                if (_snapshotRequest == capture)
+                {
+                    _snapshotRequest.reset();
+                    _snapshotPending.store(false, std::memory_order_relaxed);
+                }
+                SendErrorResponse(res, "The world thread did not capture the snapshot", 503);
+                return;
+            }
+        }
+
+        json snapshot = std::move(capture->Data);
+        std::vector<uint8_t> cbor = json::to_cbor(snapshot);
+
+        LOG_INFO("module.gamestate_api", "Captured snapshot of {} players, {} bytes{}",
+            snapshot["players"].size(), cbor.size(), anonymize ? " (anonymized)" : "");
+
+        res.set_header("Content-Disposition", fmt::format("attachment; filename=\"gamestate-snapshot-{}.cbor\"", std::time(nullptr)));
+        res.set_header("X-Snapshot-Players", std::to_string(snapshot["players"].size()));
+        res.status = 200;
+        res.set_content(reinterpret_cast<const char*>(cbor.data()), cbor.size(), "application/cbor");
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error capturing snapshot: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandlePlayerTrail(const httplib::Request& req, httplib::Response& res)
+{
+    try
+    {
+        if (!_trails)
+        {
+            SendErrorResponse(res, "Position trails are disabled", 404);
+            return;
+        }
+
+        std::string playerName = req.matches[1];
+        uint32 seconds = std::min(GetUIntParam(req, "seconds", _trails->GetSeconds()), _trails->GetSeconds());
+
+        // Logged out players keep their trail until it ages out
+        PlayerTrail trail;
+        if (!_trails->GetTrail(playerName, std::time(nullptr) - seconds, trail))
+        {
+            SendErrorResponse(res, "No trail recorded for player", 404);
+            return;
+        }
+
+        json response = {
+            {"player", trail.Name},
+            {"guid", trail.Guid},
+            {"seconds", seconds},
+            {"interval_ms", _trails->GetIntervalMs()},
+            {"coordinate_step", PlayerTrails::COORDINATE_STEP},
+            {"fields", TRAIL_FIELDS},
+            {"points", TrailPointsToJson(trail.Points)}
+        };
+
+        SendJsonResponse(res, response.dump());
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting player trail: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleTrails(const httplib::Request& req, httplib::Response& res)
+{
+    try
+    {
+        if (!_trails)
+        {
+            SendErrorResponse(res, "Position trails are disabled", 404);
+            return;
+        }
+
+        uint32 seconds = std::min(GetUIntParam(req, "seconds", _trails->GetSeconds()), _trails->GetSeconds());
+
+        json players = json::array();
+        for (PlayerTrail const& trail : _trails->GetTrails(std::time(nullptr) - seconds))
+        {
+            players.push_back({
+                {"player", trail.Name},
+                {"guid", trail.Guid},
+                {"points", TrailPointsToJson(trail.Points)}
+            });
+        }
+
+        json response = {
+            {"seconds", seconds},
+            {"interval_ms", _trails->GetIntervalMs()},
+            {"capacity", _trails->GetCapacity()},
+            {"coordinate_step", PlayerTrails::COORDINATE_STEP},
+            {"memory_bytes", _trails->GetMemoryBytes()},
+            {"fields", TRAIL_FIELDS},
+            {"players", players},
+            {"timestamp", std::time(nullptr)}
+        };
+
+        // Bulk exports of busy realms are large, CBOR keeps them smaller
+        if (req.has_param("format") && req.get_param_value("format") == "cbor")
+        {
+            std::vector<uint8_t> cbor = json::to_cbor(response);
+            res.set_content(reinterpret_cast<const char*>(cbor.data()), cbor.size(), "application/cbor");
+            return;
+        }
+
+        SendJsonResponse(res, response.dump());
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error exporting trails: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleHeatmapList(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    try
+    {
+        if (!_heatmaps)
+        {
+            SendErrorResponse(res, "Heatmaps are disabled", 404);
+            return;
+        }
+
+        json maps = json::array();
+        for (HeatmapMapSummary const& summary : _heatmaps->GetMaps(std::time(nullptr)))
+        {
+            maps.push_back({
+                {"map", summary.Map},
+                {"samples_last_hour", summary.Samples},
+                {"cells_last_hour", summary.Cells}
+            });
+        }
+
+        json response = {
+            {"maps", maps},
+            {"cell_size", _heatmaps->GetCellSize()},
+            {"interval_ms", _heatmaps->GetIntervalMs()},
+            {"memory_bytes", _heatmaps->GetMemoryBytes()},
+            {"timestamp", std::time(nullptr)}
+        };
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error listing heatmaps: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleHeatmap(const httplib::Request& req, httplib::Response& res)
+{
+    try
+    {
+        if (!_heatmaps)
+        {
+            SendErrorResponse(res, "Heatmaps are disabled", 404);
+            return;
+        }
+
+        uint32 map = uint32(std::strtoul(req.matches[1].str().c_str(), nullptr, 10));
+        uint32 window = GetUIntParam(req, "window", 3600);
+        if (!window || window > PopulationHeatmaps::MAX_WINDOW)
+        {
+            SendErrorResponse(res, fmt::format("window must be between 1 and {} seconds", PopulationHeatmaps::MAX_WINDOW));
+            return;
+        }
+
+        time_t now = std::time(nullptr);
+        HeatmapWindow heatmap;
+        if (!_heatmaps->Query(map, now, window, heatmap))
+        {
+            SendErrorResponse(res, "No players seen on this map in the last 24 hours", 404);
+            return;
+        }
+
+        // 8 bytes per occupied cell: uint16 column, uint16 row, uint32 samples, little-endian
+        if (req.has_param("format") && req.get_param_value("format") == "binary")
+        {
+            std::string body;
+            body.reserve(heatmap.Cells.size() * 8);
+            auto append = [&body](uint32 value, uint32 bytes)
+            {
+                for (uint32 i = 0; i < bytes; ++i)
+                    body.push_back(char((value >> (i * 8)) & 0xFF));
+            };
+            for (HeatmapCell const& cell : heatmap.Cells)
+            {
+                append(cell.Column, 2);
+                append(cell.Row, 2);
+                append(cell.Samples, 4);
+            }
+
+            res.set_header("X-Heatmap-Columns", std::to_string(_heatmaps->GetColumns()));
+            res.set_header("X-Heatmap-Cell-Size", std::to_string(_heatmaps->GetCellSize()));
+            res.set_header("X-Heatmap-Origin", fmt::format("{}", PopulationHeatmaps::GRID_ORIGIN));
+            res.set_header("X-Heatmap-From", std::to_string(heatmap.From));
+            res.set_header("X-Heatmap-Samples", std::to_string(heatmap.Samples));
+            res.set_content(std::move(body), "application/octet-stream");
+            return;
+        }
+
+        json cells = json::array();
+        for (HeatmapCell const& cell : heatmap.Cells)
+            cells.push_back({ cell.Column, cell.Row, cell.Samples });
+
+        json response = {
+            {"map", map},
+            {"window", window},
+            {"resolution", heatmap.Resolution},
+            {"from", heatmap.From},
+            {"to", now},
+            {"cell_size", _heatmaps->GetCellSize()},
+            {"origin", PopulationHeatmaps::GRID_ORIGIN},
+            {"columns", _heatmaps->GetColumns()},
+            {"rows", _heatmaps->GetColumns()},
+            {"interval_ms", _heatmaps->GetIntervalMs()},
+            {"samples", heatmap.Samples},
+            {"cells", cells}
+        };
+
+        SendJsonResponse(res, response.dump());
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting heatmap: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleEvents(const httplib::Request& req, httplib::Response& res)
+{
+    try
+    {
+        if (!_events)
+        {
+            SendErrorResponse(res, "Event log is disabled", 404);
+            return;
+        }
+
+        static constexpr uint32 MAX_LIMIT = 10000;
+
+        uint32 typeMask = ~0u;
+        if (req.has_param("types") && !req.get_param_value("types").empty())
+        {
+            typeMask = 0;
+            std::istringstream types(req.get_param_value("types"));
+            for (std::string name; std::getline(types, name, ',');)
+            {
+                GameEventType type;
+                if (!GameEventLog::ParseType(name, type))
+                {
+                    SendErrorResponse(res, "Unknown event type: " + name);
+                    return;
+                }
+                typeMask |= 1u << uint32(type);
+            }
+        }
+
+        // A bad cursor must not silently replay the log from the start
+        uint64 after = 0;
+        if (!ParseUInt64Param(req, "after", after))
+        {
+            SendErrorResponse(res, "Parameter 'after' must be an event id", 400);
+            return;
+        }
+
+        uint32 limit = std::clamp<uint32>(GetUIntParam(req, "limit", 1000), 1, MAX_LIMIT);
+
+        uint64 next = 0;
+        json events = json::array();
+        for (GameEvent const& event : _events->Read(after, typeMask, limit, next))
+            events.push_back(GameEventToJson(event));
+
+        // Events between `after` and the oldest one kept were discarded before this consumer read them
+        uint64 first = _events->GetFirstSequence();
+        json response = {
+            {"epoch", _events->GetEpoch()},
+            {"events", events},
+            {"next", next},
+            {"first_seq", first},
+            {"last_seq", _events->GetLastSequence()},
+            {"missed", after + 1 < first && _events->GetLastSequence() >= first},
+            {"dropped", GameEventLog::GetDroppedCount()}
+        };
+
+        SendJsonResponse(res, response.dump());
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error reading events: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleServerInfo(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    try
+    {
+        json serverData = GameStateUtilities::GetServerData();
+
+        LatencyHistogram ticks = SystemMetricsSampler::GetWorldTickHistogram();
+        serverData["world_tick"] = {
+            {"ticks", ticks.Count},
+            {"mean_ms", ticks.MeanMs()},
+            {"p50_ms", ticks.Quantile(0.50)},
+            {"p99_ms", ticks.Quantile(0.99)},
+            {"max_ms", ticks.MaxMs}
+        };
+
+        SendJsonResponse(res, serverData.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting server info: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleOnlinePlayers(const httplib::Request& req, httplib::Response& res)
+{
+    if (req.has_param("at"))
+    {
+        HandlePlayersAt(req, res);
+        return;
+    }
+
+    try
+    {
+        // Check for equipment parameter
+        bool includeEquipment = req.has_param("equipment") && req.get_param_value("equipment") == "true";
+
+        json playersData = GameStateUtilities::GetAllPlayersData(includeEquipment);
+
+        json response = {
+            {"count", playersData.size()},
+            {"players", playersData}
+        };
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting players list: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandlePlayersAt(const httplib::Request& req, httplib::Response& res)
+{
+    // Same order as the EQUIPMENT_SLOT_* values the journal is indexed by
+    static char const* const SLOT_NAMES[SnapshotStream::EQUIPMENT_SLOTS] = {
+        "head", "neck", "shoulders", "body", "chest", "waist", "legs", "feet", "wrists", "hands",
+        "finger1", "finger2", "trinket1", "trinket2", "back", "mainhand", "offhand", "ranged", "tabard"
+    };
+
+    try
+    {
+        if (!_journal)
+        {
+            SendErrorResponse(res, "Snapshot journal is disabled", 404);
+            return;
+        }
+
+        uint64 at = 0;
+        if (!req.has_param("at") || !ParseUInt64Param(req, "at", at) || at > uint64(std::numeric_limits<int64>::max()))
+        {
+            SendErrorResponse(res, "Parameter 'at' must be a unix time in seconds", 400);
+            return;
+        }
+
+        bool filterMap = req.has_param("map");
+        uint32 map = 0;
+        if (!ParseUIntParam(req, "map", map))
+        {
+            SendErrorResponse(res, "Parameter 'map' must be a map id", 400);
+            return;
+        }
+
+        JournalState state;
+        if (!_journal->GetStateAt(int64(at), state))
+        {
+            SendErrorResponse(res, "No snapshot recorded at or before the requested time", 404);
+            return;
+        }
+
+        bool includeEquipment = req.has_param("equipment") && req.get_param_value("equipment") == "true";
+        json players = json::array();
+        for (JournalPlayer const& player : state.Players)
+        {
+            if (filterMap && player.Map != map)
+                continue;
+
+            json data = {
+                {"name", player.Name},
+                {"level", player.Level},
+                {"class", player.Class},
+                {"race", player.Race},
+                {"gender", player.Gender},
+                {"guid", player.Guid},
+                {"zone_id", player.Zone},
+                {"area_id", player.Area},
+                {"map_id", player.Map},
+                {"position", {{"x", player.X}, {"y", player.Y}, {"z", player.Z}}}
+            };
+
+            if (player.GuildId)
+                data["guild"] = {{"id", player.GuildId}, {"name", player.Guild}};
+            else
+                data["guild"] = nullptr;
+
+            if (includeEquipment)
+            {
+                json equipment = json::object();
+                for (uint32 slot = 0; slot < SnapshotStream::EQUIPMENT_SLOTS; ++slot)
+                {
+                    uint32 entry = player.Equipment[slot];
+                    if (!entry)
+                    {
+                        equipment[SLOT_NAMES[slot]] = nullptr;
+                        continue;
+                    }
+
+                    ItemTemplate const* itemTemplate = sObjectMgr->GetItemTemplate(entry);
+                    equipment[SLOT_NAMES[slot]] = {
+                        {"entry", entry},
+                        {"name", itemTemplate ? itemTemplate->Name1 : ""}
+                    };
+                }
+                data["equipment"] = std::move(equipment);
+            }
+
+            players.push_back(std::move(data));
+        }
+
+        json response = {
+            {"at", at},
+            {"generation_time", state.Time},
+            {"count", players.size()},
+            {"players", players}
+        };
+
+        SendJsonResponse(res, response.dump());
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error rebuilding players from journal: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandleJournal(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    try
+    {
+        if (!_journal)
+        {
+            SendErrorResponse(res, "Snapshot journal is disabled", 404);
+            return;
+        }
+
+        json segments = json::array();
+        uint64 bytes = 0;
+        for (JournalSegmentInfo const& segment : _journal->GetSegments())
+        {
+            segments.push_back({
+                {"path", segment.Path},
+                {"from", segment.From},
+                {"to", segment.To},
+                {"bytes", segment.Bytes},
+                {"records", segment.Records}
+            });
+            bytes += segment.Bytes;
+        }
+
+        json response = {
+            {"directory", _journal->GetDirectory()},
+            {"interval_ms", _config.JournalIntervalMs},
+            {"base_every", _config.JournalBaseEvery},
+            {"retention_hours", _config.JournalRetentionHours},
+            {"max_size_mb", _config.JournalMaxSizeMB},
+            {"bytes", bytes},
+            {"segments", segments}
+        };
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error listing journal segments: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandlePush(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    try
+    {
+        if (!_pusher)
+        {
+            SendErrorResponse(res, "Snapshot push is disabled", 404);
+            return;
+        }
+
+        PushStats stats = _pusher->GetStats();
+        json response = {
+            {"endpoint", _pusher->GetEndpoint()},
+            {"interval_ms", _config.PushIntervalMs},
+            {"connected", stats.Connected},
+            {"connects", stats.Connects},
+            {"seq", stats.Sequence},
+            {"sent_records", stats.SentRecords},
+            {"sent_bytes", stats.SentBytes},
+            {"dropped_records", stats.DroppedRecords},
+            {"buffered_records", stats.BufferedRecords},
+            {"buffered_bytes", stats.BufferedBytes},
+            {"buffer_limit_bytes", uint64(_config.PushBufferKB) * 1024},
+            {"last_error", stats.LastError.empty() ? json(nullptr) : json(stats.LastError)}
+        };
+
+        SendJsonResponse(res, response.dump(2));
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("module.gamestate_api", "Error getting push status: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
+    }
+}
+
+void HttpGameStateServer::HandlePlayersStream(const httplib::Request& /*req*/, httplib::Response& res)
+{
+    // Subscribers wake up at least this often to send a heartbeat, which also notices dead connections
+    static constexpr std::chrono::milliseconds HEARTBEAT_INTERVAL(5000);
+
+    if (!_feed->AddSubscriber(_config.StreamMaxSubscribers))
+    {
+        SendErrorResponse(res, "Too many stream subscribers", 503);
+        return;
+    }
+
+    SnapshotFeed* feed = _feed.get();
+    uint64 sent = 0;
+    bool greeted = false;
+    res.set_chunked_content_provider("application/x-ndjson",
+        [feed, sent, greeted](size_t /*offset*/, httplib::DataSink& sink) mutable
+        {
+            if (!greeted)
+            {
+                greeted = true;
+                std::string hello = SnapshotStream::Hello(feed->GetEpoch(), 0);
+                return sink.write(hello.data(), hello.size());
+            }
+
+            std::shared_ptr<SnapshotGeneration const> generation = feed->WaitNewer(sent, HEARTBEAT_INTERVAL);
+            if (feed->IsClosed())
+            {
+                sink.done();
+                return true;
+            }
+
+            if (!generation)
+            {
+                std::string heartbeat = SnapshotStream::Heartbeat(feed->GetEpoch(), sent);
+                return sink.write(heartbeat.data(), heartbeat.size());
+            }
+
+            // Lines are encoded once per generation and shared by all subscribers;
+            // one that missed a generation starts over from a base
+            std::string const& line = sent && generation->GetSequence() == sent + 1 ? generation->GetDeltaLine() : generation->GetBaseLine();
+            sent = generation->GetSequence();
+            return sink.write(line.data(), line.size());
+        },
+        [feed](bool /*success*/) { feed->RemoveSubscriber(); });
+}
+
+std::vector<FederatedRealm> HttpGameStateServer::GetFederatedRealms(bool merged, bool includeServer) const
+{
+    std::vector<FederatedRealm> realms;
 
-    _server->Get("/api/player/([^/]+)/skills-full", [this](const httplib::Request& req, httplib::Response& res) {
-        HandlePlayerSkillsFull(req, res);
-    });
+    FederatedRealm& local = realms.emplace_back();
+    local.Name = _config.FederationRealmName;
+    local.Connected = true;
+    if (std::shared_ptr<SnapshotGeneration const> generation = _feed->GetLatest())
+    {
+        local.Time = generation->GetTime();
+        local.Players = generation->GetPlayersPtr();
+    }
+    if (includeServer)
+        local.Server = std::make_shared<json const>(GameStateUtilities::GetServerData());
 
-    _server->Get("/api/player/([^/]+)/quests", [this](const httplib::Request& req, httplib::Response& res) {
-        HandlePlayerQuests(req, res);
-    });
+    int64 now = int64(std::time(nullptr));
+    for (FederatedRealm& realm : _federation->GetRealms())
+    {
+        if (merged && !realm.Connected && now - realm.DisconnectedSince > int64(RealmFederation::STALE_SECONDS))
+            continue;
 
-    // Set up CORS and error handling
-    _server->set_pre_routing_handler([](const httplib::Request& /*req*/, httplib::Response& res) {
-        res.set_header("Access-Control-Allow-Origin", "*");
-        res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-        res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
-        return httplib::Server::HandlerResponse::Unhandled;
-    });
-}
+        realms.push_back(std::move(realm));
+    }
 
-HttpGameStateServer::~HttpGameStateServer()
-{
-    Stop();
+    return realms;
 }
 
-bool HttpGameStateServer::Start()
+void HttpGameStateServer::HandleFederationPlayers(const httplib::Request& req, httplib::Response& res)
 {
-    if (_running.load())
+    try
     {
-        LOG_WARN("module.gamestate_api", "HTTP server is already running");
-        return false;
-    }
-
-    _serverThread = std::make_unique<std::thread>([this]() {
-        LOG_INFO("module.gamestate_api", "Starting HTTP server on {}:{}", _host, _port);
-        _running.store(true);
+        bool includeEquipment = req.has_param("equipment") && req.get_param_value("equipment") == "true";
+        std::string realmFilter = req.has_param("realm") ? req.get_param_value("realm") : "";
+        bool filterMap = req.has_param("map");
+        uint32 map = 0;
+        if (!ParseUIntParam(req, "map", map))
+        {
+            SendErrorResponse(res, "Parameter 'map' must be a map id", 400);
+            return;
+        }
 
-        if (!_server->listen(_host, _port))
+        json realms = json::array();
+        json players = json::array();
+        for (FederatedRealm const& realm : GetFederatedRealms(true, false))
         {
-            LOG_ERROR("module.gamestate_api", "Failed to start HTTP server on {}:{}", _host, _port);
-            _running.store(false);
+            if (!realmFilter.empty() && realm.Name != realmFilter)
+                continue;
+
+            size_t count = realm.Players ? realm.Players->size() : 0;
+            realms.push_back({
+                {"realm", realm.Name},
+                {"connected", realm.Connected},
+                {"generation_time", realm.Time},
+                {"count", count}
+            });
+
+            if (!realm.Players)
+                continue;
+
+            std::vector<SnapshotStream::Player const*> sorted;
+            sorted.reserve(count);
+            for (auto const& [guid, player] : *realm.Players)
+                if (!filterMap || player.Map == map)
+                    sorted.push_back(&player);
+
+            std::sort(sorted.begin(), sorted.end(), [](SnapshotStream::Player const* a, SnapshotStream::Player const* b) { return a->Name < b->Name; });
+            for (SnapshotStream::Player const* player : sorted)
+                players.push_back(FederatedPlayerToJson(realm.Name, *player, includeEquipment));
         }
-        else
+
+        if (!realmFilter.empty() && realms.empty())
         {
-            LOG_INFO("module.gamestate_api", "HTTP server stopped");
-            _running.store(false);
+            SendErrorResponse(res, fmt::format("No federated realm named '{}'", realmFilter), 404);
+            return;
         }
-    });
 
-    // Give the server a moment to start
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        json response = {
+            {"count", players.size()},
+            {"realms", realms},
+            {"players", players}
+        };
 
-    if (_running.load())
-    {
-        LOG_INFO("module.gamestate_api", "Game State API HTTP server started successfully on {}:{}", _host, _port);
-        return true;
+        SendJsonResponse(res, response.dump());
     }
-    else
+    catch (const std::exception& e)
     {
-        LOG_ERROR("module.gamestate_api", "Failed to start Game State API HTTP server");
-        if (_serverThread && _serverThread->joinable())
-        {
-            _serverThread->join();
-        }
-        return false;
+        LOG_ERROR("module.gamestate_api", "Error getting federated players: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
     }
 }
 
-void HttpGameStateServer::Stop()
+void HttpGameStateServer::HandleFederationServer(const httplib::Request& /*req*/, httplib::Response& res)
 {
-    if (!_running.load())
+    try
     {
-        return;
-    }
+        int64 now = int64(std::time(nullptr));
+        size_t total = 0;
+        json realms = json::array();
+        for (FederatedRealm const& realm : GetFederatedRealms(false, true))
+        {
+            size_t count = realm.Players ? realm.Players->size() : 0;
+            bool stale = !realm.Connected && now - realm.DisconnectedSince > int64(RealmFederation::STALE_SECONDS);
+            if (!stale)
+                total += count;
+
+            realms.push_back({
+                {"realm", realm.Name},
+                {"endpoint", realm.Endpoint.empty() ? json(nullptr) : json(realm.Endpoint)},
+                {"connected", realm.Connected},
+                {"stale", stale},
+                {"connects", realm.Connects},
+                {"last_error", realm.LastError.empty() ? json(nullptr) : json(realm.LastError)},
+                {"generation_time", realm.Time},
+                {"player_count", count},
+                {"server", realm.Server ? *realm.Server : json(nullptr)}
+            });
+        }
 
-    LOG_INFO("module.gamestate_api", "Stopping HTTP server...");
+        json response = {
+            {"realm_count", realms.size()},
+            {"player_count", total},
+            {"realms", realms}
+        };
 
-    if (_server)
-    {
-        _server->stop();
+        SendJsonResponse(res, response.dump(2));
     }
-
-    if (_serverThread && _serverThread->joinable())
+    catch (const std::exception& e)
     {
-        _serverThread->join();
+        LOG_ERROR("module.gamestate_api", "Error getting federated server info: {}", e.what());
+        json error = {{"error", "Internal server error"}, {"status", 500}};
+        SendJsonResponse(res, error.dump(2), 500);
     }
-
-    _running.store(false);
-    LOG_INFO("module.gamestate_api", "HTTP server stopped");
-}
-
-void HttpGameStateServer::HandleHealthCheck(const httplib::Request& /*req*/, httplib::Response& res)
-{
-    json response = {
-        {"status", "ok"},
-        {"timestamp", std::time(nullptr)},
-        {"uptime_seconds", GameTime::GetUptime().count()}
-    };
-
-    SendJsonResponse(res, response.dump(2));
 }
 
-void HttpGameStateServer::HandleHostInfo(const httplib::Request& /*req*/, httplib::Response& res)
+void HttpGameStateServer::HandleFederationSearch(const httplib::Request& req, httplib::Response& res)
 {
-    // Static variables to track peak values since server start
-    static double peakCpuUsage = 0.0;
-    static uint64_t peakMemUsage = 0;
+    static constexpr uint32 MAX_RESULTS = 1000;
 
     try
     {
-        json response;
-        double currentCpuUsage = 0.0;
-        uint64_t currentMemUsage = 0;
-
-#ifdef _WIN32
-        // Windows implementation
-
-        // Host uptime
-        ULONGLONG uptimeMs = GetTickCount64();
-        response["uptime_seconds"] = uptimeMs / 1000;
-
-        // Get current CPU usage using GetSystemTimes
-        FILETIME idleTime, kernelTime, userTime;
-        static FILETIME prevIdleTime = {0}, prevKernelTime = {0}, prevUserTime = {0};
-        static bool firstCall = true;
-
-        if (GetSystemTimes(&idleTime, &kernelTime, &userTime))
-        {
-            if (firstCall)
-            {
-                prevIdleTime = idleTime;
-                prevKernelTime = kernelTime;
-                prevUserTime = userTime;
-                firstCall = false;
-                currentCpuUsage = 0.0;
-            }
-            else
-            {
-                ULONGLONG idle = (((ULONGLONG)idleTime.dwHighDateTime << 32) | idleTime.dwLowDateTime) -
-                                 (((ULONGLONG)prevIdleTime.dwHighDateTime << 32) | prevIdleTime.dwLowDateTime);
-                ULONGLONG kernel = (((ULONGLONG)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime) -
-                                   (((ULONGLONG)prevKernelTime.dwHighDateTime << 32) | prevKernelTime.dwLowDateTime);
-                ULONGLONG user = (((ULONGLONG)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime) -
-                                 (((ULONGLONG)prevUserTime.dwHighDateTime << 32) | prevUserTime.dwLowDateTime);
-
-                ULONGLONG total = kernel + user;
-                currentCpuUsage = (total > 0) ? (1.0 - ((double)idle / (double)total)) * 100.0 : 0.0;
-                currentCpuUsage = std::round(currentCpuUsage * 100.0) / 100.0;
-
-                prevIdleTime = idleTime;
-                prevKernelTime = kernelTime;
-                prevUserTime = userTime;
-            }
-        }
-
-        // Memory information
-        MEMORYSTATUSEX memInfo;
-        memInfo.dwLength = sizeof(MEMORYSTATUSEX);
-        if (GlobalMemoryStatusEx(&memInfo))
+        std::string name = req.has_param("name") ? ToLower(req.get_param_value("name")) : "";
+        if (name.empty())
         {
-            currentMemUsage = memInfo.ullTotalPhys - memInfo.ullAvailPhys;
+            SendErrorResponse(res, "Parameter 'name' is required", 400);
+            return;
         }
 
-#else
-        // Linux implementation
-
-        // Host uptime
-        struct sysinfo si;
-        if (sysinfo(&si) == 0)
-        {
-            response["uptime_seconds"] = si.uptime;
-        }
-        else
-        {
-            response["uptime_seconds"] = 0;
-        }
+        uint32 limit = std::min(GetUIntParam(req, "limit", 50), MAX_RESULTS);
 
-        // Memory usage from /proc/meminfo (container-aware on Proxmox)
+        // Exact matches first, then names starting with the query, then the rest
+        struct Match
         {
-            unsigned long long memTotal = 0, memAvailable = 0;
-            std::ifstream memInfoFile("/proc/meminfo");
-            if (memInfoFile.is_open())
-            {
-                std::string line;
-                while (std::getline(memInfoFile, line))
-                {
-                    unsigned long long value;
-                    if (sscanf(line.c_str(), "MemTotal: %llu kB", &value) == 1)
-                        memTotal = value * 1024ULL;
-                    else if (sscanf(line.c_str(), "MemAvailable: %llu kB", &value) == 1)
-                        memAvailable = value * 1024ULL;
-                }
-                memInfoFile.close();
-            }
-
-            response["total_mem"] = memTotal;
-            currentMemUsage = memTotal - memAvailable;
-        }
-
-        // CPU usage from /proc/stat
-        static unsigned long long prevTotal = 0, prevIdle = 0;
-        static bool firstCall = true;
+            uint32 Rank;
+            std::string const* Realm;
+            SnapshotStream::Player const* Player;
+        };
 
-        std::ifstream statFile("/proc/stat");
-        if (statFile.is_open())
+        std::vector<FederatedRealm> realms = GetFederatedRealms(true, false);
+        std::vector<Match> matches;
+        for (FederatedRealm const& realm : realms)
         {
-            std::string line;
-            std::getline(statFile, line);
-            statFile.close();
+            if (!realm.Players)
+                continue;
 
-            unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
-            if (sscanf(line.c_str(), "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
-                       &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal) >= 4)
+            for (auto const& [guid, player] : *realm.Players)
             {
-                unsigned long long totalIdle = idle + iowait;
-                unsigned long long total = user + nice + system + idle + iowait + irq + softirq + steal;
-
-                if (firstCall)
-                {
-                    prevTotal = total;
-                    prevIdle = totalIdle;
-                    firstCall = false;
-                    currentCpuUsage = 0.0;
-                }
-                else
-                {
-                    unsigned long long totalDiff = total - prevTotal;
-                    unsigned long long idleDiff = totalIdle - prevIdle;
-
-                    currentCpuUsage = (totalDiff > 0) ? (1.0 - ((double)idleDiff / (double)totalDiff)) * 100.0 : 0.0;
-                    currentCpuUsage = std::round(currentCpuUsage * 100.0) / 100.0;
+                std::string lower = ToLower(player.Name);
+                size_t position = lower.find(name);
+                if (position == std::string::npos)
+                    continue;
 
-                    prevTotal = total;
-                    prevIdle = totalIdle;
-                }
+                uint32 rank = lower.size() == name.size() ? 0 : position == 0 ? 1 : 2;
+                matches.push_back({ rank, &realm.Name, &player });
             }
         }
-#endif
 
-        // Update peak values
-        if (currentCpuUsage > peakCpuUsage)
-        {
-            peakCpuUsage = currentCpuUsage;
-        }
-        if (currentMemUsage > peakMemUsage)
+        std::sort(matches.begin(), matches.end(), [](Match const& a, Match const& b)
         {
-            peakMemUsage = currentMemUsage;
-        }
+            if (a.Rank != b.Rank)
+                return a.Rank < b.Rank;
+            if (a.Player->Name != b.Player->Name)
+                return a.Player->Name < b.Player->Name;
+            return *a.Realm < *b.Realm;
+        });
 
-        // Build response
-        response["current_cpu"] = currentCpuUsage;
-        response["max_cpu"] = peakCpuUsage;
-        response["current_mem"] = currentMemUsage;
-        response["max_mem"] = peakMemUsage;
+        json results = json::array();
+        for (size_t i = 0; i < matches.size() && i < limit; ++i)
+            results.push_back(FederatedPlayerToJson(*matches[i].Realm, *matches[i].Player, false));
+
+        json response = {
+            {"query", name},
+            {"total", matches.size()},
+            {"count", results.size()},
+            {"players", results}
+        };
 
-        response["timestamp"] = std::time(nullptr);
         SendJsonResponse(res, response.dump(2));
     }
     catch (const std::exception& e)
     {
-        LOG_ERROR("module.gamestate_api", "Error getting host info: {}", e.what());
+        LOG_ERROR("module.gamestate_api", "Error searching federated players: {}", e.what());
         json error = {{"error", "Internal server error"}, {"status", 500}};
         SendJsonResponse(res, error.dump(2), 500);
     }
 }
 
-void HttpGameStateServer::HandleServerInfo(const httplib::Request& /*req*/, httplib::Response& res)
+void HttpGameStateServer::HandleFederationLeaderboard(const httplib::Request& req, httplib::Response& res)
 {
-    try
-    {
-        json serverData = GameStateUtilities::GetServerData();
-        SendJsonResponse(res, serverData.dump(2));
-    }
-    catch (const std::exception& e)
-    {
-        LOG_ERROR("module.gamestate_api", "Error getting server info: {}", e.what());
-        json error = {{"error", "Internal server error"}, {"status", 500}};
-        SendJsonResponse(res, error.dump(2), 500);
-    }
-}
+    static constexpr uint32 MAX_ENTRIES = 1000;
 
-void HttpGameStateServer::HandleOnlinePlayers(const httplib::Request& req, httplib::Response& res)
-{
     try
     {
-        // Check for equipment parameter
-        bool includeEquipment = req.has_param("equipment") && req.get_param_value("equipment") == "true";
+        std::string by = req.has_param("by") ? req.get_param_value("by") : "level";
+        if (by != "level" && by != "guild")
+        {
+            SendErrorResponse(res, "Parameter 'by' must be 'level' or 'guild'", 400);
+            return;
+        }
 
-        json playersData = GameStateUtilities::GetAllPlayersData(includeEquipment);
+        uint32 limit = std::min(GetUIntParam(req, "limit", 25), MAX_ENTRIES);
+        std::string realmFilter = req.has_param("realm") ? req.get_param_value("realm") : "";
+
+        std::vector<FederatedRealm> realms = GetFederatedRealms(true, false);
+        json entries = json::array();
+
+        if (by == "level")
+        {
+            std::vector<std::pair<std::string const*, SnapshotStream::Player const*>> players;
+            for (FederatedRealm const& realm : realms)
+            {
+                if (!realm.Players || (!realmFilter.empty() && realm.Name != realmFilter))
+                    continue;
+
+                for (auto const& [guid, player] : *realm.Players)
+                    players.emplace_back(&realm.Name, &player);
+            }
+
+            size_t count = std::min<size_t>(limit, players.size());
+            std::partial_sort(players.begin(), players.begin() + count, players.end(), [](auto const& a, auto const& b)
+            {
+                if (a.second->Level != b.second->Level)
+                    return a.second->Level > b.second->Level;
+                return a.second->Name < b.second->Name;
+            });
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                json entry = FederatedPlayerToJson(*players[i].first, *players[i].second, false);
+                entry["rank"] = i + 1;
+                entries.push_back(std::move(entry));
+            }
+        }
+        else
+        {
+            // Guild ids are per realm, so the same id on two realms is two guilds
+            struct GuildEntry
+            {
+                std::string const* Realm;
+                uint32 Id;
+                std::string const* Name;
+                uint32 Online = 0;
+                uint64 Levels = 0;
+            };
+
+            std::vector<GuildEntry> guilds;
+            for (FederatedRealm const& realm : realms)
+            {
+                if (!realm.Players || (!realmFilter.empty() && realm.Name != realmFilter))
+                    continue;
+
+                std::unordered_map<uint32, size_t> index;
+                for (auto const& [guid, player] : *realm.Players)
+                {
+                    if (!player.GuildId)
+                        continue;
+
+                    auto [itr, inserted] = index.emplace(player.GuildId, guilds.size());
+                    if (inserted)
+                        guilds.push_back({ &realm.Name, player.GuildId, &player.Guild });
+
+                    GuildEntry& guild = guilds[itr->second];
+                    ++guild.Online;
+                    guild.Levels += player.Level;
+                }
+            }
+
+            size_t count = std::min<size_t>(limit, guilds.size());
+            std::partial_sort(guilds.begin(), guilds.begin() + count, guilds.end(), [](GuildEntry const& a, GuildEntry const& b)
+            {
+                if (a.Online != b.Online)
+                    return a.Online > b.Online;
+                return *a.Name < *b.Name;
+            });
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                GuildEntry const& guild = guilds[i];
+                entries.push_back({
+                    {"rank", i + 1},
+                    {"realm", *guild.Realm},
+                    {"guild_id", guild.Id},
+                    {"name", *guild.Name},
+                    {"online", guild.Online},
+                    {"average_level", double(guild.Levels) / guild.Online}
+                });
+            }
+        }
 
         json response = {
-            {"count", playersData.size()},
-            {"players", playersData}
+            {"by", by},
+            {"count", entries.size()},
+            {"entries", entries}
         };
 
         SendJsonResponse(res, response.dump(2));
     }
     catch (const std::exception& e)
     {
-        LOG_ERROR("module.gamestate_api", "Error getting players list: {}", e.what());
+        LOG_ERROR("module.gamestate_api", "Error building federated leaderboard: {}", e.what());
         json error = {{"error", "Internal server error"}, {"status", 500}};
         SendJsonResponse(res, error.dump(2), 500);
     }
@@ -513,7 +2991,7 @@ void HttpGameStateServer::HandlePlayerQuests(const httplib::Request& req, httpli
 
 void HttpGameStateServer::SetCorsHeaders(httplib::Response& res)
 {
-    res.set_header("Access-Control-Allow-Origin", _allowedOrigin);
+    res.set_header("Access-Control-Allow-Origin", _config.AllowedOrigin);
     res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
     res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization, X-Requested-With");
     res.set_header("Access-Control-Max-Age", "86400");
@@ -534,3 +3012,43 @@ void HttpGameStateServer::SendErrorResponse(httplib::Response& res, const std::s
     SendJsonResponse(res, error.dump(), status);
 }
 
+uint32 HttpGameStateServer::GetUIntParam(const httplib::Request& req, const char* name, uint32 defaultValue)
+{
+    uint32 value = defaultValue;
+    return ParseUIntParam(req, name, value) ? value : defaultValue;
+}
+
+uint64 HttpGameStateServer::GetUInt64Param(const httplib::Request& req, const char* name, uint64 defaultValue)
+{
+    uint64 value = defaultValue;
+    return ParseUInt64Param(req, name, value) ? value : defaultValue;
+}
+
+bool HttpGameStateServer::ParseUIntParam(const httplib::Request& req, const char* name, uint32& value)
+{
+    uint64 parsed = value;
+    if (!ParseUInt64Param(req, name, parsed) || parsed > std::numeric_limits<uint32>::max())
+        return false;
+
+    value = static_cast<uint32>(parsed);
+    return true;
+}
+
+bool HttpGameStateServer::ParseUInt64Param(const httplib::Request& req, const char* name, uint64& value)
+{
+    if (!req.has_param(name))
+        return true;
+
+    std::string const text = req.get_param_value(name);
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0])))
+        return false;
+
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long parsed = std::strtoull(text.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE)
+        return false;
+
+    value = static_cast<uint64>(parsed);
+    return true;
+}
@@ -6,24 +6,57 @@
 #define HTTP_GAME_STATE_SERVER_H
 
 #include "Define.h"
+#include "GameStateConfig.h"
+#include "RealmFederation.h"
 #include <yhirose/httplib.h>
+#include <nlohmann/json.hpp>
 #include <string>
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+class DatabaseMonitor;
+class GameEventLog;
+class ListenerAccepts;
+class MetricHistory;
+class PlayerTrails;
+class PopulationHeatmaps;
+class RealmFederation;
+class RequestAccounting;
+class RequestRecorder;
+class SnapshotFeed;
+class SnapshotJournal;
+class SnapshotPusher;
+class SystemMetricsSampler;
 
 // Modern HTTP server using httplib.h
 class HttpGameStateServer
 {
 public:
-    HttpGameStateServer(const std::string& host, uint16 port, const std::string& allowedOrigin);
+    explicit HttpGameStateServer(const GameStateAPIConfig& config);
     ~HttpGameStateServer();
 
     bool Start();
     void Stop();
     bool IsRunning() const { return _running.load(); }
 
+    // Called from GameStateAPI::OnUpdate on the world thread
+    void OnWorldUpdate(uint32 diff);
+
 private:
+    void CaptureSnapshot();
+    using RouteHandler = void (HttpGameStateServer::*)(const httplib::Request&, httplib::Response&);
+
+    // Registers a GET route whose handler CPU time is accounted per route and client
+    void Route(const char* pattern, RouteHandler handler);
+    static std::string GetClientKey(const httplib::Request& req);
+    void RegisterHistoryMetrics();
+    // Stops and joins the listeners that are running, then the shared worker pool
+    void StopListeners();
+
     // REST API endpoint handlers
     void HandlePlayerInfo(const httplib::Request& req, httplib::Response& res);
     void HandlePlayerStats(const httplib::Request& req, httplib::Response& res);
@@ -31,22 +64,94 @@ private:
     void HandlePlayerSkills(const httplib::Request& req, httplib::Response& res);
     void HandlePlayerSkillsFull(const httplib::Request& req, httplib::Response& res);
     void HandlePlayerQuests(const httplib::Request& req, httplib::Response& res);
+    void HandlePlayerTrail(const httplib::Request& req, httplib::Response& res);
+    void HandleTrails(const httplib::Request& req, httplib::Response& res);
+    void HandleHeatmapList(const httplib::Request& req, httplib::Response& res);
+    void HandleHeatmap(const httplib::Request& req, httplib::Response& res);
+    void HandleEvents(const httplib::Request& req, httplib::Response& res);
     void HandleServerInfo(const httplib::Request& req, httplib::Response& res);
     void HandleOnlinePlayers(const httplib::Request& req, httplib::Response& res);
+    void HandlePlayersAt(const httplib::Request& req, httplib::Response& res);
+    void HandleJournal(const httplib::Request& req, httplib::Response& res);
+    void HandlePush(const httplib::Request& req, httplib::Response& res);
+    void HandlePlayersStream(const httplib::Request& req, httplib::Response& res);
+    void HandleFederationPlayers(const httplib::Request& req, httplib::Response& res);
+    void HandleFederationServer(const httplib::Request& req, httplib::Response& res);
+    void HandleFederationSearch(const httplib::Request& req, httplib::Response& res);
+    void HandleFederationLeaderboard(const httplib::Request& req, httplib::Response& res);
     void HandleHealthCheck(const httplib::Request& req, httplib::Response& res);
     void HandleHostInfo(const httplib::Request& req, httplib::Response& res);
+    void HandleHostCpu(const httplib::Request& req, httplib::Response& res);
+    void HandleHostIo(const httplib::Request& req, httplib::Response& res);
+    void HandleHostPressure(const httplib::Request& req, httplib::Response& res);
+    void HandleMetrics(const httplib::Request& req, httplib::Response& res);
+    void HandleListeners(const httplib::Request& req, httplib::Response& res);
+    void HandleProcessInfo(const httplib::Request& req, httplib::Response& res);
+    void HandleProcessThreads(const httplib::Request& req, httplib::Response& res);
+    void HandleDatabase(const httplib::Request& req, httplib::Response& res);
+    void HandleRequestCpu(const httplib::Request& req, httplib::Response& res);
+    void HandleHistoryList(const httplib::Request& req, httplib::Response& res);
+    void HandleHistory(const httplib::Request& req, httplib::Response& res);
+    void HandleDebugProfile(const httplib::Request& req, httplib::Response& res);
+    void HandleDebugMalloc(const httplib::Request& req, httplib::Response& res);
+    void HandleDebugSnapshot(const httplib::Request& req, httplib::Response& res);
 
     // Utility methods
     void SetCorsHeaders(httplib::Response& res);
     void SendJsonResponse(httplib::Response& res, const std::string& json, int status = 200);
     void SendErrorResponse(httplib::Response& res, const std::string& message, int status = 400);
+    static uint32 GetUIntParam(const httplib::Request& req, const char* name, uint32 defaultValue);
+    static uint64 GetUInt64Param(const httplib::Request& req, const char* name, uint64 defaultValue);
+    // False when the parameter is present but not a valid number; `value` is left alone when it is absent
+    static bool ParseUIntParam(const httplib::Request& req, const char* name, uint32& value);
+    static bool ParseUInt64Param(const httplib::Request& req, const char* name, uint64& value);
+    // The local realm first, then the peers; `merged` leaves out peers gone for longer than STALE_SECONDS
+    std::vector<FederatedRealm> GetFederatedRealms(bool merged, bool includeServer) const;
+
+    GameStateAPIConfig _config;
+
+    // GameStateAPI.Listeners servers with the same routes, bound to the same
+    // host:port with SO_REUSEPORT so the kernel spreads connections over them
+    struct Listener
+    {
+        std::unique_ptr<httplib::Server> Server;
+        std::unique_ptr<std::thread> Thread;
+        std::unique_ptr<ListenerAccepts> Accepts;
+    };
+
+    std::vector<Listener> _listeners;
+    std::unique_ptr<httplib::ThreadPool> _workers;
+    std::unique_ptr<SystemMetricsSampler> _sampler;
+    std::unique_ptr<DatabaseMonitor> _dbMonitor;
+    std::unique_ptr<RequestAccounting> _accounting;
+    std::unique_ptr<RequestRecorder> _recorder;
+    std::unique_ptr<MetricHistory> _history;
+    std::unique_ptr<PlayerTrails> _trails;
+    std::unique_ptr<PopulationHeatmaps> _heatmaps;
+    std::unique_ptr<GameEventLog> _events;
+    std::unique_ptr<SnapshotJournal> _journal;
+    std::unique_ptr<SnapshotPusher> _pusher;
+    std::unique_ptr<SnapshotFeed> _feed;
+    std::unique_ptr<RealmFederation> _federation;
+    uint32 _trailElapsedMs;
+    uint32 _heatmapElapsedMs;
+    uint32 _journalElapsedMs;
+    uint32 _pushElapsedMs;
+    uint32 _feedElapsedMs;
 
-    std::string _host;
-    uint16 _port;
-    std::string _allowedOrigin;
+    // A /api/debug/snapshot waiting for the world thread to collect it
+    struct SnapshotCapture
+    {
+        bool Anonymize = false;
+        bool Done = false;
+        bool Cancelled = false;
+        nlohmann::json Data;
+    };
 
-    std::unique_ptr<httplib::Server> _server;
-    std::unique_ptr<std::thread> _serverThread;
+    std::mutex _snapshotMutex;
+    std::condition_variable _snapshotCondition;
+    std::shared_ptr<SnapshotCapture> _snapshotRequest;
+    std::atomic<bool> _snapshotPending;
     std::atomic<bool> _running;
 };
 
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "HttpListeners.h"
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    constexpr uint32 COUNT_BITS = 24;
+    constexpr uint64 COUNT_MASK = (uint64(1) << COUNT_BITS) - 1;
+}
+
+ListenerAccepts::ListenerAccepts() : _total(0)
+{
+    for (std::atomic<uint64>& second : _seconds)
+        second.store(0, std::memory_order_relaxed);
+}
+
+uint64 ListenerAccepts::NowSeconds()
+{
+    return uint64(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void ListenerAccepts::Record()
+{
+    _total.fetch_add(1, std::memory_order_relaxed);
+
+    uint64 now = NowSeconds();
+    std::atomic<uint64>& slot = _seconds[now % _seconds.size()];
+    uint64 value = slot.load(std::memory_order_relaxed);
+    // A single writer, so a plain store is enough to start the slot over for a new second
+    if ((value >> COUNT_BITS) != now)
+        value = now << COUNT_BITS;
+    if ((value & COUNT_MASK) != COUNT_MASK)
+        ++value;
+    slot.store(value, std::memory_order_relaxed);
+}
+
+double ListenerAccepts::GetRate(uint32 seconds) const
+{
+    seconds = std::clamp<uint32>(seconds, 1, WINDOW_SECONDS);
+
+    // The current second is still counting, so the window ends with the one before
+    uint64 now = NowSeconds();
+    uint64 accepts = 0;
+    for (std::atomic<uint64> const& slot : _seconds)
+    {
+        uint64 value = slot.load(std::memory_order_relaxed);
+        uint64 second = value >> COUNT_BITS;
+        if (second < now && second + seconds >= now)
+            accepts += value & COUNT_MASK;
+    }
+
+    return double(accepts) / seconds;
+}
+
+bool ListenerTaskQueue::enqueue(std::function<void()> fn)
+{
+    _accepts.Record();
+    return _workers.enqueue(std::move(fn));
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_HTTPLISTENERS_H
+#define GAMESTATEAPI_HTTPLISTENERS_H
+
+#include "Define.h"
+#include <yhirose/httplib.h>
+#include <array>
+#include <atomic>
+#include <functional>
+
+// Connections accepted by one listener, counted per second over the last
+// minute. Only the listener thread records; any thread may read.
+class ListenerAccepts
+{
+public:
+    static constexpr uint32 WINDOW_SECONDS = 60;
+
+    ListenerAccepts();
+
+    void Record();
+
+    uint64 GetTotal() const { return _total.load(std::memory_order_relaxed); }
+    // Accepts per second over the last `seconds` whole seconds, at most WINDOW_SECONDS
+    double GetRate(uint32 seconds) const;
+
+private:
+    static uint64 NowSeconds();
+
+    std::atomic<uint64> _total;
+    // Second in the high 40 bits, accepts during that second in the low 24
+    std::array<std::atomic<uint64>, WINDOW_SECONDS + 1> _seconds;
+};
+
+// Task queue of one listener: counts the connections it accepts and hands
+// them to the worker pool shared by every listener. httplib creates one per
+// listen loop and shuts it down when the loop ends, but the shared pool
+// outlives the listeners and is shut down once they are all gone.
+class ListenerTaskQueue : public httplib::TaskQueue
+{
+public:
+    ListenerTaskQueue(httplib::TaskQueue& workers, ListenerAccepts& accepts) : _workers(workers), _accepts(accepts) { }
+
+    bool enqueue(std::function<void()> fn) override;
+    void shutdown() override { }
+
+private:
+    httplib::TaskQueue& _workers;
+    ListenerAccepts& _accepts;
+};
+
+#endif // GAMESTATEAPI_HTTPLISTENERS_H
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_LATENCYHISTOGRAM_H
+#define GAMESTATEAPI_LATENCYHISTOGRAM_H
+
+#include "Define.h"
+#include <array>
+
+// Fixed-bucket millisecond histogram, cumulative since creation.
+// Bucket bounds match the usual Prometheus latency buckets.
+struct LatencyHistogram
+{
+    static constexpr uint32 BUCKET_COUNT = 13;
+    static constexpr std::array<double, BUCKET_COUNT> BOUNDS_MS = { 1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000 };
+
+    std::array<uint64, BUCKET_COUNT + 1> Buckets = {};  // last bucket is +Inf
+    uint64 Count = 0;
+    double SumMs = 0.0;
+    double MaxMs = 0.0;
+
+    void Record(double ms)
+    {
+        uint32 bucket = 0;
+        while (bucket < BUCKET_COUNT && ms > BOUNDS_MS[bucket])
+            ++bucket;
+
+        ++Buckets[bucket];
+        ++Count;
+        SumMs += ms;
+        if (ms > MaxMs)
+            MaxMs = ms;
+    }
+
+    // Upper bound of the bucket holding the given quantile (0..1)
+    double Quantile(double q) const
+    {
+        if (!Count)
+            return 0.0;
+
+        uint64 rank = static_cast<uint64>(q * Count + 0.5);
+        uint64 seen = 0;
+        for (uint32 bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+        {
+            seen += Buckets[bucket];
+            if (seen >= rank)
+                return BOUNDS_MS[bucket];
+        }
+
+        return MaxMs;
+    }
+
+    double MeanMs() const { return Count ? SumMs / Count : 0.0; }
+};
+
+#endif // GAMESTATEAPI_LATENCYHISTOGRAM_H
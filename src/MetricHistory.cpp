@@ -0,0 +1,619 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "MetricHistory.h"
+#include "Log.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace
+{
+    // Marks "no previous XOR window" so the first value takes the long form
+    constexpr uint32 NO_WINDOW = 64;
+
+    constexpr char FILE_MAGIC[8] = { 'G', 'S', 'H', 'I', 'S', 'T', '0', '1' };
+
+    // Reads back what GorillaBlock::Append wrote, tracking the same state
+    class BlockReader
+    {
+    public:
+        BlockReader(std::vector<uint8> const& data, uint64 bitCount) : _data(data), _bitCount(bitCount) { }
+
+        bool Next(bool first, int64 firstTimestamp, int64& timestamp, double& value)
+        {
+            if (first)
+            {
+                uint64 bits;
+                if (!Read(64, bits))
+                    return false;
+
+                Timestamp = firstTimestamp;
+                Value = bits;
+            }
+            else
+            {
+                int64 dod = 0;
+                uint64 flag, raw;
+                if (!Read(1, flag))
+                    return false;
+                if (flag)
+                {
+                    uint32 prefix = 1;
+                    while (prefix < 4)
+                    {
+                        if (!Read(1, flag))
+                            return false;
+                        if (!flag)
+                            break;
+                        ++prefix;
+                    }
+
+                    static constexpr uint32 widths[] = { 0, 7, 9, 12, 32 };
+                    uint32 width = widths[prefix];
+                    if (!Read(width, raw))
+                        return false;
+
+                    dod = int64(raw);
+                    if (width == 32)
+                        dod = int32(uint32(raw));
+                    else if (dod > (int64(1) << (width - 1)))
+                        dod -= int64(1) << width;
+                }
+
+                Delta += dod;
+                Timestamp += Delta;
+
+                if (!Read(1, flag))
+                    return false;
+                if (flag)
+                {
+                    if (!Read(1, flag))
+                        return false;
+                    if (flag)
+                    {
+                        uint64 leading, length;
+                        if (!Read(5, leading) || !Read(6, length))
+                            return false;
+
+                        Leading = uint32(leading);
+                        uint32 meaningful = length ? uint32(length) : 64;
+                        if (Leading + meaningful > 64)
+                            return false;
+                        Trailing = 64 - Leading - meaningful;
+                    }
+                    else if (Leading == NO_WINDOW)
+                        return false;
+
+                    uint64 bits;
+                    if (!Read(64 - Leading - Trailing, bits))
+                        return false;
+
+                    Value ^= bits << Trailing;
+                }
+            }
+
+            timestamp = Timestamp;
+            value = std::bit_cast<double>(Value);
+            return true;
+        }
+
+        int64 Timestamp = 0;
+        int64 Delta = 0;
+        uint64 Value = 0;
+        uint32 Leading = NO_WINDOW;
+        uint32 Trailing = 0;
+
+    private:
+        bool Read(uint32 bits, uint64& out)
+        {
+            if (_position + bits > _bitCount)
+                return false;
+
+            out = 0;
+            for (uint32 i = 0; i < bits; ++i, ++_position)
+                out = (out << 1) | ((_data[_position >> 3] >> (7 - (_position & 7))) & 1);
+
+            return true;
+        }
+
+        std::vector<uint8> const& _data;
+        uint64 _bitCount;
+        uint64 _position = 0;
+    };
+
+    template <class T>
+    void WritePod(std::string& out, T const& value)
+    {
+        out.append(reinterpret_cast<char const*>(&value), sizeof(value));
+    }
+
+    template <class T>
+    bool ReadPod(std::ifstream& in, T& value)
+    {
+        return bool(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+    }
+}
+
+void GorillaBlock::WriteBits(uint64 value, uint32 bits)
+{
+    for (uint32 i = bits; i > 0; --i, ++_bitCount)
+    {
+        if ((_bitCount & 7) == 0)
+            _data.push_back(0);
+
+        if ((value >> (i - 1)) & 1)
+            _data.back() |= uint8(0x80 >> (_bitCount & 7));
+    }
+}
+
+void GorillaBlock::Append(int64 timestamp, double value)
+{
+    uint64 bits = std::bit_cast<uint64>(value);
+
+    if (!_count)
+    {
+        _firstTimestamp = _prevTimestamp = timestamp;
+        _prevDelta = 0;
+        _prevValue = bits;
+        _prevLeading = NO_WINDOW;
+        WriteBits(bits, 64);
+        _count = 1;
+        return;
+    }
+
+    int64 delta = timestamp - _prevTimestamp;
+    int64 dod = delta - _prevDelta;
+    if (dod == 0)
+        WriteBits(0, 1);
+    else if (dod >= -63 && dod <= 64)
+        WriteBits((uint64(0b10) << 7) | (uint64(dod) & 0x7F), 9);
+    else if (dod >= -255 && dod <= 256)
+        WriteBits((uint64(0b110) << 9) | (uint64(dod) & 0x1FF), 12);
+    else if (dod >= -2047 && dod <= 2048)
+        WriteBits((uint64(0b1110) << 12) | (uint64(dod) & 0xFFF), 16);
+    else
+    {
+        WriteBits(0b1111, 4);
+        WriteBits(uint64(dod) & 0xFFFFFFFF, 32);
+    }
+
+    _prevDelta = delta;
+    _prevTimestamp = timestamp;
+
+    uint64 xored = bits ^ _prevValue;
+    _prevValue = bits;
+    if (!xored)
+    {
+        WriteBits(0, 1);
+    }
+    else
+    {
+        uint32 leading = std::min<uint32>(std::countl_zero(xored), 31);
+        uint32 trailing = std::countr_zero(xored);
+
+        if (_prevLeading != NO_WINDOW && leading >= _prevLeading && trailing >= _prevTrailing)
+        {
+            WriteBits(0b10, 2);
+            WriteBits(xored >> _prevTrailing, 64 - _prevLeading - _prevTrailing);
+        }
+        else
+        {
+            uint32 meaningful = 64 - leading - trailing;
+            WriteBits(0b11, 2);
+            WriteBits(leading, 5);
+            WriteBits(meaningful & 63, 6);  // 64 is stored as 0
+            WriteBits(xored >> trailing, meaningful);
+            _prevLeading = leading;
+            _prevTrailing = trailing;
+        }
+    }
+
+    ++_count;
+}
+
+void GorillaBlock::Decode(std::function<void(int64, double)> const& fn) const
+{
+    BlockReader reader(_data, _bitCount);
+    int64 timestamp;
+    double value;
+    for (uint32 i = 0; i < _count && reader.Next(i == 0, _firstTimestamp, timestamp, value); ++i)
+        fn(timestamp, value);
+}
+
+bool GorillaBlock::Restore(uint32 count, int64 firstTimestamp, uint64 bitCount, std::vector<uint8> const& data, GorillaBlock& block)
+{
+    block = GorillaBlock();
+    if (bitCount > data.size() * 8)
+        return false;
+
+    // Re-encoding is cheap and rebuilds the encoder state for appending,
+    // which is not part of the persisted bytes
+    BlockReader reader(data, bitCount);
+    int64 timestamp;
+    double value;
+    for (uint32 i = 0; i < count && reader.Next(i == 0, firstTimestamp, timestamp, value); ++i)
+        block.Append(timestamp, value);
+
+    return block._count > 0;
+}
+
+MetricHistory::MetricHistory(std::string file, uint32 checkpointSeconds)
+    : _file(std::move(file)), _checkpointSeconds(std::max<uint32>(checkpointSeconds, 10)), _stopping(false)
+{
+}
+
+MetricHistory::~MetricHistory()
+{
+    Stop();
+}
+
+void MetricHistory::AddMetric(std::string name, std::string unit, MetricKind kind, std::function<double()> source)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto series = std::make_unique<Series>();
+    series->Info.Name = std::move(name);
+    series->Info.Unit = std::move(unit);
+    series->Info.Kind = kind;
+    series->Source = std::move(source);
+    _series.push_back(std::move(series));
+}
+
+void MetricHistory::Start()
+{
+    if (_thread.joinable())
+        return;
+
+    if (!_file.empty() && Load())
+        LOG_INFO("module.gamestate_api", "Loaded metric history from {}", _file);
+
+    _stopping = false;
+    _thread = std::thread([this]()
+    {
+#ifndef _WIN32
+        pthread_setname_np(pthread_self(), "gsapi-history");
+#endif
+        Run();
+    });
+}
+
+void MetricHistory::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_stopMutex);
+        _stopping = true;
+    }
+    _stopCondition.notify_all();
+
+    if (!_thread.joinable())
+        return;
+
+    _thread.join();
+
+    if (!_file.empty() && !Save())
+        LOG_ERROR("module.gamestate_api", "Failed to save metric history to {}", _file);
+}
+
+void MetricHistory::Run()
+{
+    int64 lastSample = 0;
+    auto nextCheckpoint = std::chrono::steady_clock::now() + std::chrono::seconds(_checkpointSeconds);
+
+    std::unique_lock<std::mutex> lock(_stopMutex);
+    while (!_stopping)
+    {
+        lock.unlock();
+
+        int64 now = std::time(nullptr);
+        if (now != lastSample)
+        {
+            Sample(now);
+            lastSample = now;
+        }
+
+        if (!_file.empty() && std::chrono::steady_clock::now() >= nextCheckpoint)
+        {
+            if (!Save())
+                LOG_ERROR("module.gamestate_api", "Failed to save metric history to {}", _file);
+            nextCheckpoint = std::chrono::steady_clock::now() + std::chrono::seconds(_checkpointSeconds);
+        }
+
+        // Wake up just after the next wall-clock second
+        auto sinceEpoch = std::chrono::system_clock::now().time_since_epoch();
+        auto untilNextSecond = std::chrono::seconds(1) - (sinceEpoch % std::chrono::seconds(1)) + std::chrono::milliseconds(5);
+
+        lock.lock();
+        _stopCondition.wait_for(lock, untilNextSecond, [this]() { return _stopping; });
+    }
+}
+
+void MetricHistory::Sample(int64 now)
+{
+    // Sources may take locks of their own, so read them before taking ours
+    std::vector<std::pair<bool, double>> values;
+    values.reserve(_series.size());
+    for (auto const& series : _series)
+    {
+        try
+        {
+            values.emplace_back(true, series->Source());
+        }
+        catch (std::exception const& e)
+        {
+            LOG_ERROR("module.gamestate_api", "Metric {} failed: {}", series->Info.Name, e.what());
+            values.emplace_back(false, 0.0);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (size_t i = 0; i < _series.size(); ++i)
+    {
+        if (!values[i].first)
+            continue;
+
+        Series& series = *_series[i];
+        double value = values[i].second;
+        if (series.Info.Kind == MetricKind::Counter)
+        {
+            bool hadCounter = series.HasCounter;
+            double previous = series.LastCounter;
+            int64 elapsed = now - series.LastCounterTime;
+            series.LastCounter = value;
+            series.LastCounterTime = now;
+            series.HasCounter = true;
+
+            // Counters reset when their owner restarts; skip that interval
+            if (!hadCounter || elapsed <= 0 || value < previous)
+                continue;
+
+            value = (value - previous) / double(elapsed);
+        }
+
+        Append(series, 0, now, value);
+    }
+}
+
+void MetricHistory::Append(Series& series, uint32 tier, int64 timestamp, double value)
+{
+    Tier& target = series.Tiers[tier];
+    Resolution const& resolution = RESOLUTIONS[tier];
+
+    if (!target.Blocks.empty() && timestamp <= target.Blocks.back().LastTimestamp())
+        return;
+
+    if (target.Blocks.empty() || target.Blocks.back().Count() >= resolution.PointsPerBlock)
+    {
+        target.Blocks.emplace_back();
+        while (target.Blocks.size() > resolution.Retention / resolution.PointsPerBlock + 1)
+            target.Blocks.pop_front();
+    }
+
+    target.Blocks.back().Append(timestamp, value);
+
+    if (tier + 1 >= RESOLUTION_COUNT)
+        return;
+
+    // Roll up into the next resolution once its bucket is complete
+    Tier& next = series.Tiers[tier + 1];
+    uint32 step = RESOLUTIONS[tier + 1].StepSeconds;
+    int64 bucket = timestamp - ((timestamp % step) + step) % step;
+    if (next.PendingStart != bucket)
+    {
+        if (next.PendingCount)
+        {
+            double rolled = series.Info.Kind == MetricKind::Peak ? next.PendingMax : next.PendingSum / next.PendingCount;
+            Append(series, tier + 1, next.PendingStart, rolled);
+        }
+
+        next.PendingStart = bucket;
+        next.PendingSum = 0.0;
+        next.PendingMax = value;
+        next.PendingCount = 0;
+    }
+
+    next.PendingSum += value;
+    next.PendingMax = std::max(next.PendingMax, value);
+    next.PendingCount++;
+}
+
+std::vector<MetricInfo> MetricHistory::GetMetrics() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::vector<MetricInfo> metrics;
+    for (auto const& series : _series)
+    {
+        MetricInfo info = series->Info;
+        for (Tier const& tier : series->Tiers)
+            if (!tier.Blocks.empty() && (!info.OldestTimestamp || tier.Blocks.front().FirstTimestamp() < info.OldestTimestamp))
+                info.OldestTimestamp = tier.Blocks.front().FirstTimestamp();
+
+        metrics.push_back(std::move(info));
+    }
+
+    return metrics;
+}
+
+bool MetricHistory::Query(std::string const& name, int64 from, int64 to, uint32 step, std::vector<MetricSeriesPoint>& points, uint32& resolution) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto itr = std::find_if(_series.begin(), _series.end(), [&name](auto const& series) { return series->Info.Name == name; });
+    if (itr == _series.end())
+        return false;
+
+    Series const& series = **itr;
+    step = std::max<uint32>(step, 1);
+
+    // Finest resolution that still reaches back to `from`, otherwise the
+    // coarsest one allowed by `step`
+    uint32 tier = 0;
+    for (uint32 i = 0; i < RESOLUTION_COUNT && RESOLUTIONS[i].StepSeconds <= step; ++i)
+    {
+        tier = i;
+        Tier const& candidate = series.Tiers[i];
+        if (!candidate.Blocks.empty() && candidate.Blocks.front().FirstTimestamp() <= from)
+            break;
+    }
+
+    resolution = RESOLUTIONS[tier].StepSeconds;
+    points.clear();
+
+    // Bucket start -> sum/max and count
+    std::map<int64, std::pair<double, uint32>> buckets;
+    bool peak = series.Info.Kind == MetricKind::Peak;
+    for (GorillaBlock const& block : series.Tiers[tier].Blocks)
+    {
+        if (!block.Count() || block.LastTimestamp() < from || block.FirstTimestamp() > to)
+            continue;
+
+        block.Decode([&](int64 timestamp, double value)
+        {
+            if (timestamp < from || timestamp > to)
+                return;
+
+            auto [bucket, inserted] = buckets.try_emplace(from + (timestamp - from) / step * step, value, 0);
+            if (!inserted)
+                bucket->second.first = peak ? std::max(bucket->second.first, value) : bucket->second.first + value;
+            bucket->second.second++;
+        });
+    }
+
+    points.reserve(buckets.size());
+    for (auto const& [timestamp, aggregate] : buckets)
+        points.push_back({ timestamp, peak ? aggregate.first : aggregate.first / aggregate.second });
+
+    return true;
+}
+
+size_t MetricHistory::GetMemoryBytes() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t bytes = 0;
+    for (auto const& series : _series)
+        for (Tier const& tier : series->Tiers)
+            for (GorillaBlock const& block : tier.Blocks)
+                bytes += block.MemoryBytes();
+
+    return bytes;
+}
+
+bool MetricHistory::Save() const
+{
+    // Encoded under the lock, written after it so queries and samples do not wait on the disk
+    std::string encoded;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        encoded.append(FILE_MAGIC, sizeof(FILE_MAGIC));
+        WritePod(encoded, uint32(_series.size()));
+        for (auto const& series : _series)
+        {
+            WritePod(encoded, uint32(series->Info.Name.size()));
+            encoded.append(series->Info.Name);
+
+            for (Tier const& tier : series->Tiers)
+            {
+                WritePod(encoded, tier.PendingStart);
+                WritePod(encoded, tier.PendingSum);
+                WritePod(encoded, tier.PendingMax);
+                WritePod(encoded, tier.PendingCount);
+                WritePod(encoded, uint32(tier.Blocks.size()));
+                for (GorillaBlock const& block : tier.Blocks)
+                {
+                    WritePod(encoded, block.Count());
+                    WritePod(encoded, block.FirstTimestamp());
+                    WritePod(encoded, block.BitCount());
+                    WritePod(encoded, uint32(block.Data().size()));
+                    encoded.append(reinterpret_cast<char const*>(block.Data().data()), block.Data().size());
+                }
+            }
+        }
+    }
+
+    std::string temporary = _file + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out || !out.write(encoded.data(), encoded.size()) || !out.flush())
+            return false;
+    }
+
+    // Replace the previous checkpoint only once the new one is complete. rename()
+    // replaces it atomically on POSIX; Windows refuses to rename over an existing file
+#ifdef _WIN32
+    std::remove(_file.c_str());
+#endif
+    return std::rename(temporary.c_str(), _file.c_str()) == 0;
+}
+
+bool MetricHistory::Load()
+{
+    std::ifstream in(_file, std::ios::binary);
+    if (!in)
+        return false;
+
+    char magic[sizeof(FILE_MAGIC)];
+    uint32 seriesCount;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0 || !ReadPod(in, seriesCount))
+    {
+        LOG_WARN("module.gamestate_api", "{} is not a metric history file, starting empty", _file);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (uint32 s = 0; s < seriesCount; ++s)
+    {
+        uint32 nameLength;
+        if (!ReadPod(in, nameLength) || nameLength > 256)
+            return false;
+
+        std::string name(nameLength, '\0');
+        if (!in.read(name.data(), nameLength))
+            return false;
+
+        // Metrics that are no longer registered are read and dropped
+        auto itr = std::find_if(_series.begin(), _series.end(), [&name](auto const& series) { return series->Info.Name == name; });
+        Series discarded;
+        Series& series = itr != _series.end() ? **itr : discarded;
+
+        for (uint32 t = 0; t < RESOLUTION_COUNT; ++t)
+        {
+            Tier& tier = series.Tiers[t];
+            uint32 blockCount;
+            if (!ReadPod(in, tier.PendingStart) || !ReadPod(in, tier.PendingSum) || !ReadPod(in, tier.PendingMax)
+                || !ReadPod(in, tier.PendingCount) || !ReadPod(in, blockCount))
+                return false;
+
+            tier.Blocks.clear();
+            for (uint32 b = 0; b < blockCount; ++b)
+            {
+                uint32 count, size;
+                int64 firstTimestamp;
+                uint64 bitCount;
+                if (!ReadPod(in, count) || !ReadPod(in, firstTimestamp) || !ReadPod(in, bitCount) || !ReadPod(in, size) || size > (1u << 20))
+                    return false;
+
+                std::vector<uint8> data(size);
+                if (!in.read(reinterpret_cast<char*>(data.data()), size))
+                    return false;
+
+                GorillaBlock block;
+                if (GorillaBlock::Restore(count, firstTimestamp, bitCount, data, block))
+                    tier.Blocks.push_back(std::move(block));
+            }
+        }
+    }
+
+    return true;
+}
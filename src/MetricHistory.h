@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_METRICHISTORY_H
+#define GAMESTATEAPI_METRICHISTORY_H
+
+#include "Define.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Timestamp/value pairs compressed as in Facebook's Gorilla paper: timestamps
+// as delta-of-delta, values as the XOR with the previous value. A constant
+// 1s series costs 2 bits per point, a slowly changing one a few more.
+class GorillaBlock
+{
+public:
+    void Append(int64 timestamp, double value);
+
+    // Calls fn(timestamp, value) for every point, oldest first
+    void Decode(std::function<void(int64, double)> const& fn) const;
+
+    // Rebuilds a block from persisted bytes, ready for further appends
+    static bool Restore(uint32 count, int64 firstTimestamp, uint64 bitCount, std::vector<uint8> const& data, GorillaBlock& block);
+
+    uint32 Count() const { return _count; }
+    int64 FirstTimestamp() const { return _firstTimestamp; }
+    int64 LastTimestamp() const { return _prevTimestamp; }
+    uint64 BitCount() const { return _bitCount; }
+    std::vector<uint8> const& Data() const { return _data; }
+    size_t MemoryBytes() const { return sizeof(*this) + _data.capacity(); }
+
+private:
+    void WriteBits(uint64 value, uint32 bits);
+
+    std::vector<uint8> _data;
+    uint64 _bitCount = 0;
+    uint32 _count = 0;
+
+    // Encoder state, i.e. the previous point
+    int64 _firstTimestamp = 0;
+    int64 _prevTimestamp = 0;
+    int64 _prevDelta = 0;
+    uint64 _prevValue = 0;
+    uint32 _prevLeading = 0;
+    uint32 _prevTrailing = 0;
+};
+
+// How a metric is sampled and rolled up into coarser resolutions
+enum class MetricKind
+{
+    Gauge,      // stored as read, rolled up by mean
+    Peak,       // stored as read, rolled up by max (latency quantiles, queue peaks)
+    Counter     // source is cumulative, stored as a per-second rate, rolled up by mean
+};
+
+struct MetricSeriesPoint
+{
+    int64 Timestamp;
+    double Value;
+};
+
+struct MetricInfo
+{
+    std::string Name;
+    std::string Unit;
+    MetricKind Kind;
+    int64 OldestTimestamp = 0;  // 0 = no data yet
+};
+
+// Per-second samples of registered metrics, kept at three fixed-size
+// resolutions: 1s for an hour, 1m for a day and 1h for 30 days. Each
+// resolution is a ring of Gorilla blocks, so memory is bounded per metric no
+// matter how long the server runs. With a file configured the blocks are
+// checkpointed periodically and reloaded at startup.
+class MetricHistory
+{
+public:
+    struct Resolution
+    {
+        uint32 StepSeconds;
+        uint32 Retention;       // points
+        uint32 PointsPerBlock;
+    };
+
+    static constexpr Resolution RESOLUTIONS[] = {
+        { 1, 3600, 120 },
+        { 60, 1440, 60 },
+        { 3600, 720, 24 }
+    };
+    static constexpr uint32 RESOLUTION_COUNT = 3;
+
+    MetricHistory(std::string file, uint32 checkpointSeconds);
+    ~MetricHistory();
+
+    // Register every metric before Start(); the source runs on the history thread
+    void AddMetric(std::string name, std::string unit, MetricKind kind, std::function<double()> source);
+
+    void Start();
+    void Stop();
+
+    std::vector<MetricInfo> GetMetrics() const;
+
+    // Points in [from, to] at the finest resolution, no coarser than `step`,
+    // that still covers `from`, resampled into `step` buckets. Returns false
+    // for an unknown metric.
+    bool Query(std::string const& name, int64 from, int64 to, uint32 step, std::vector<MetricSeriesPoint>& points, uint32& resolution) const;
+
+    size_t GetMemoryBytes() const;
+    std::string const& GetFile() const { return _file; }
+
+private:
+    struct Tier
+    {
+        std::deque<GorillaBlock> Blocks;
+
+        // Bucket of this tier being accumulated from the finer one
+        int64 PendingStart = -1;
+        double PendingSum = 0.0;
+        double PendingMax = 0.0;
+        uint32 PendingCount = 0;
+    };
+
+    struct Series
+    {
+        MetricInfo Info;
+        std::function<double()> Source;
+        double LastCounter = 0.0;
+        int64 LastCounterTime = 0;
+        bool HasCounter = false;
+        Tier Tiers[RESOLUTION_COUNT];
+    };
+
+    void Run();
+    void Sample(int64 now);
+    void Append(Series& series, uint32 tier, int64 timestamp, double value);
+
+    bool Load();
+    bool Save() const;
+
+    std::string _file;
+    uint32 _checkpointSeconds;
+
+    mutable std::mutex _mutex;
+    std::vector<std::unique_ptr<Series>> _series;
+
+    std::thread _thread;
+    std::mutex _stopMutex;
+    std::condition_variable _stopCondition;
+    bool _stopping;
+};
+
+#endif // GAMESTATEAPI_METRICHISTORY_H
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "PlayerTrails.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    constexpr double TWO_PI = 6.283185307179586;
+
+    int16 QuantizeCoordinate(float value)
+    {
+        double steps = std::round(value / PlayerTrails::COORDINATE_STEP);
+        return int16(std::clamp<double>(steps, std::numeric_limits<int16>::min(), std::numeric_limits<int16>::max()));
+    }
+
+    bool EqualsIgnoreCase(std::string const& a, std::string const& b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y)
+        {
+            return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+        });
+    }
+}
+
+PlayerTrails::PlayerTrails(uint32 intervalMs, uint32 seconds)
+    : _intervalMs(std::max<uint32>(intervalMs, 1000)), _seconds(std::max<uint32>(seconds, 1))
+{
+    _capacity = std::max<size_t>(uint64(_seconds) * 1000 / _intervalMs, 1);
+}
+
+TrailPoint PlayerTrails::Quantize(time_t now, PlayerPosition const& position)
+{
+    double turns = position.Orientation / TWO_PI;
+    turns -= std::floor(turns);
+
+    TrailPoint point;
+    point.Time = uint32(now);
+    point.Map = uint16(std::min<uint32>(position.Map, std::numeric_limits<uint16>::max()));
+    point.Zone = uint16(std::min<uint32>(position.Zone, std::numeric_limits<uint16>::max()));
+    point.X = QuantizeCoordinate(position.X);
+    point.Y = QuantizeCoordinate(position.Y);
+    point.Z = QuantizeCoordinate(position.Z);
+    point.Orientation = uint8(uint32(std::lround(turns * 256.0)) & 0xFF);
+    point.Flags = position.Flags;
+    return point;
+}
+
+double PlayerTrails::Orientation(uint8 value)
+{
+    return value * TWO_PI / 256.0;
+}
+
+void PlayerTrails::Record(time_t now, std::vector<PlayerPosition> const& positions)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (PlayerPosition const& position : positions)
+    {
+        Ring& ring = _rings[position.Guid];
+        if (ring.Name != position.Name)
+            ring.Name = position.Name;
+        ring.LastSeen = now;
+
+        TrailPoint point = Quantize(now, position);
+        if (ring.Points.size() < _capacity)
+        {
+            if (ring.Points.empty())
+                ring.Points.reserve(_capacity);
+            ring.Points.push_back(point);
+        }
+        else
+        {
+            ring.Points[ring.Head] = point;
+            ring.Head = (ring.Head + 1) % _capacity;
+        }
+    }
+
+    // Players offline for the whole retention have nothing left to show
+    for (auto itr = _rings.begin(); itr != _rings.end();)
+    {
+        if (itr->second.LastSeen + time_t(_seconds) < now)
+            itr = _rings.erase(itr);
+        else
+            ++itr;
+    }
+}
+
+void PlayerTrails::CopyPoints(Ring const& ring, time_t since, std::vector<TrailPoint>& points) const
+{
+    points.clear();
+    points.reserve(ring.Points.size());
+    for (size_t i = 0; i < ring.Points.size(); ++i)
+    {
+        TrailPoint const& point = ring.Points[(ring.Head + i) % ring.Points.size()];
+        if (time_t(point.Time) >= since)
+            points.push_back(point);
+    }
+}
+
+bool PlayerTrails::GetTrail(std::string const& name, time_t since, PlayerTrail& trail) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto const& [guid, ring] : _rings)
+    {
+        if (!EqualsIgnoreCase(ring.Name, name))
+            continue;
+
+        trail.Guid = guid;
+        trail.Name = ring.Name;
+        CopyPoints(ring, since, trail.Points);
+        return true;
+    }
+
+    return false;
+}
+
+std::vector<PlayerTrail> PlayerTrails::GetTrails(time_t since) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::vector<PlayerTrail> trails;
+    trails.reserve(_rings.size());
+    for (auto const& [guid, ring] : _rings)
+    {
+        PlayerTrail& trail = trails.emplace_back();
+        trail.Guid = guid;
+        trail.Name = ring.Name;
+        CopyPoints(ring, since, trail.Points);
+    }
+
+    std::sort(trails.begin(), trails.end(), [](PlayerTrail const& a, PlayerTrail const& b) { return a.Name < b.Name; });
+    return trails;
+}
+
+size_t PlayerTrails::GetPlayerCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _rings.size();
+}
+
+size_t PlayerTrails::GetMemoryBytes() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t bytes = 0;
+    for (auto const& [guid, ring] : _rings)
+        bytes += sizeof(guid) + sizeof(ring) + ring.Points.capacity() * sizeof(TrailPoint);
+
+    return bytes;
+}
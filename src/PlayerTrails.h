@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_PLAYERTRAILS_H
+#define GAMESTATEAPI_PLAYERTRAILS_H
+
+#include "Define.h"
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Position of an in-world player, read on the world thread
+struct PlayerPosition
+{
+    uint32 Guid = 0;
+    std::string Name;
+    uint32 Map = 0;
+    uint32 Zone = 0;
+    float X = 0.0f;
+    float Y = 0.0f;
+    float Z = 0.0f;
+    float Orientation = 0.0f;
+    uint8 Flags = 0;    // TrailFlags
+};
+
+enum TrailFlags : uint8
+{
+    TRAIL_FLAG_DEAD         = 0x01,
+    TRAIL_FLAG_IN_COMBAT    = 0x02,
+    TRAIL_FLAG_MOUNTED      = 0x04
+};
+
+// One quantized trail sample, 16 bytes
+struct TrailPoint
+{
+    uint32 Time;        // unix seconds
+    uint16 Map;
+    uint16 Zone;
+    int16 X;            // multiples of COORDINATE_STEP yards
+    int16 Y;
+    int16 Z;
+    uint8 Orientation;  // 1/256 of a full turn
+    uint8 Flags;
+};
+
+struct PlayerTrail
+{
+    uint32 Guid = 0;
+    std::string Name;
+    std::vector<TrailPoint> Points;     // oldest first
+};
+
+// Fixed-size ring of recent positions per player, fed from the world thread
+// every interval. A player's ring is dropped once they have been offline for
+// the whole retention, so memory is bounded by capacity * 16 bytes per player
+// seen during the retention.
+class PlayerTrails
+{
+public:
+    // Half a yard keeps all of the 34133 yard map grid but its outermost
+    // ~680 yards within int16; positions out there are clamped
+    static constexpr float COORDINATE_STEP = 0.5f;
+
+    PlayerTrails(uint32 intervalMs, uint32 seconds);
+
+    static TrailPoint Quantize(time_t now, PlayerPosition const& position);
+    static double Coordinate(int16 value) { return value * COORDINATE_STEP; }
+    static double Orientation(uint8 value);
+
+    void Record(time_t now, std::vector<PlayerPosition> const& positions);
+
+    // Points recorded at or after `since`; the name is case-insensitive
+    bool GetTrail(std::string const& name, time_t since, PlayerTrail& trail) const;
+    std::vector<PlayerTrail> GetTrails(time_t since) const;
+
+    uint32 GetIntervalMs() const { return _intervalMs; }
+    uint32 GetSeconds() const { return _seconds; }
+    size_t GetCapacity() const { return _capacity; }
+    size_t GetPlayerCount() const;
+    size_t GetMemoryBytes() const;
+
+private:
+    struct Ring
+    {
+        std::string Name;
+        std::vector<TrailPoint> Points;
+        size_t Head = 0;    // oldest point once the ring is full
+        time_t LastSeen = 0;
+    };
+
+    void CopyPoints(Ring const& ring, time_t since, std::vector<TrailPoint>& points) const;
+
+    uint32 _intervalMs;
+    uint32 _seconds;
+    size_t _capacity;
+
+    mutable std::mutex _mutex;
+    std::unordered_map<uint32, Ring> _rings;
+};
+
+#endif // GAMESTATEAPI_PLAYERTRAILS_H
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "PopulationHeatmap.h"
+#include <algorithm>
+#include <cmath>
+
+PopulationHeatmaps::PopulationHeatmaps(uint32 cellSize, uint32 intervalMs)
+    : _cellSize(std::clamp<uint32>(cellSize, 10, uint32(GRID_SIZE))), _intervalMs(std::max<uint32>(intervalMs, 1000))
+{
+    _columns = uint32(std::ceil(GRID_SIZE / _cellSize));
+}
+
+PopulationHeatmaps::Bucket& PopulationHeatmaps::CurrentBucket(std::deque<Bucket>& buckets, time_t now, uint32 width, uint32 count)
+{
+    time_t start = now - now % width;
+    if (buckets.empty() || buckets.back().Start != start)
+    {
+        buckets.emplace_back().Start = start;
+        Expire(buckets, now, width, count);
+    }
+
+    return buckets.back();
+}
+
+void PopulationHeatmaps::Expire(std::deque<Bucket>& buckets, time_t now, uint32 width, uint32 count)
+{
+    while (!buckets.empty() && buckets.front().Start + time_t(width) * count <= now)
+        buckets.pop_front();
+}
+
+void PopulationHeatmaps::Record(time_t now, std::vector<PlayerPosition> const& positions)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (PlayerPosition const& position : positions)
+    {
+        uint32 column = uint32(std::clamp<double>(std::floor((position.X - GRID_ORIGIN) / _cellSize), 0, _columns - 1));
+        uint32 row = uint32(std::clamp<double>(std::floor((position.Y - GRID_ORIGIN) / _cellSize), 0, _columns - 1));
+        uint32 cell = row * _columns + column;
+
+        MapHeat& heat = _maps[position.Map];
+        Bucket& minute = CurrentBucket(heat.Minutes, now, 60, MINUTE_BUCKETS);
+        ++minute.Cells[cell];
+        ++minute.Samples;
+
+        Bucket& hour = CurrentBucket(heat.Hours, now, 3600, HOUR_BUCKETS);
+        ++hour.Cells[cell];
+        ++hour.Samples;
+    }
+
+    // Maps nobody visits any more age out completely
+    for (auto itr = _maps.begin(); itr != _maps.end();)
+    {
+        Expire(itr->second.Minutes, now, 60, MINUTE_BUCKETS);
+        Expire(itr->second.Hours, now, 3600, HOUR_BUCKETS);
+        if (itr->second.Hours.empty())
+            itr = _maps.erase(itr);
+        else
+            ++itr;
+    }
+}
+
+bool PopulationHeatmaps::Query(uint32 map, time_t now, uint32 window, HeatmapWindow& result) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto itr = _maps.find(map);
+    if (itr == _maps.end())
+        return false;
+
+    window = std::clamp<uint32>(window, 1, MAX_WINDOW);
+    bool minutes = window <= MINUTE_BUCKETS * 60;
+    std::deque<Bucket> const& buckets = minutes ? itr->second.Minutes : itr->second.Hours;
+    result.Resolution = minutes ? 60 : 3600;
+    result.From = now;
+    result.Samples = 0;
+
+    std::unordered_map<uint32, uint32> cells;
+    for (Bucket const& bucket : buckets)
+    {
+        // Any bucket overlapping the window counts in full
+        if (bucket.Start + time_t(result.Resolution) <= now - time_t(window))
+            continue;
+
+        result.From = std::min(result.From, bucket.Start);
+        result.Samples += bucket.Samples;
+        for (auto const& [cell, samples] : bucket.Cells)
+            cells[cell] += samples;
+    }
+
+    result.Cells.clear();
+    result.Cells.reserve(cells.size());
+    for (auto const& [cell, samples] : cells)
+        result.Cells.push_back({ uint16(cell % _columns), uint16(cell / _columns), samples });
+
+    std::sort(result.Cells.begin(), result.Cells.end(), [](HeatmapCell const& a, HeatmapCell const& b)
+    {
+        return a.Row != b.Row ? a.Row < b.Row : a.Column < b.Column;
+    });
+
+    return true;
+}
+
+std::vector<HeatmapMapSummary> PopulationHeatmaps::GetMaps(time_t now) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::vector<HeatmapMapSummary> maps;
+    for (auto const& [map, heat] : _maps)
+    {
+        HeatmapMapSummary& summary = maps.emplace_back();
+        summary.Map = map;
+
+        // Same window as Query(map, now, 3600)
+        std::unordered_map<uint32, uint32> cells;
+        for (Bucket const& bucket : heat.Minutes)
+        {
+            if (bucket.Start + 60 <= now - 3600)
+                continue;
+
+            summary.Samples += bucket.Samples;
+            for (auto const& [cell, samples] : bucket.Cells)
+                cells[cell] += samples;
+        }
+        summary.Cells = cells.size();
+    }
+
+    return maps;
+}
+
+size_t PopulationHeatmaps::GetMemoryBytes() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Approximate: unordered_map nodes cost about the entry plus two pointers
+    size_t bytes = 0;
+    for (auto const& [map, heat] : _maps)
+    {
+        for (std::deque<Bucket> const* buckets : { &heat.Minutes, &heat.Hours })
+        {
+            for (Bucket const& bucket : *buckets)
+            {
+                bytes += sizeof(Bucket) + bucket.Cells.bucket_count() * sizeof(void*)
+                    + bucket.Cells.size() * (sizeof(std::pair<uint32, uint32>) + 2 * sizeof(void*));
+            }
+        }
+    }
+
+    return bytes;
+}
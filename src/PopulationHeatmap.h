@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_POPULATIONHEATMAP_H
+#define GAMESTATEAPI_POPULATIONHEATMAP_H
+
+#include "Define.h"
+#include "PlayerTrails.h"
+#include <ctime>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct HeatmapCell
+{
+    uint16 Column;
+    uint16 Row;
+    uint32 Samples;
+};
+
+struct HeatmapWindow
+{
+    uint32 Resolution = 0;      // bucket width used, 60 or 3600 seconds
+    time_t From = 0;            // start of the oldest bucket included
+    uint64 Samples = 0;
+    std::vector<HeatmapCell> Cells; // row-major order
+};
+
+struct HeatmapMapSummary
+{
+    uint32 Map = 0;
+    uint64 Samples = 0;         // over the last hour
+    size_t Cells = 0;
+};
+
+// Per-map player density grids, updated from the positions sampled on the
+// world thread. Counts are kept in sparse per-minute buckets for the last
+// hour and per-hour buckets for the last day, so a window is the sum of a
+// few buckets and memory grows with occupied cells, not with the grid size.
+class PopulationHeatmaps
+{
+public:
+    // The ADT grid every map lives in: 64 tiles of 533.33 yards around the origin
+    static constexpr double GRID_ORIGIN = -17066.666;
+    static constexpr double GRID_SIZE = 34133.333;
+
+    static constexpr uint32 MINUTE_BUCKETS = 60;
+    static constexpr uint32 HOUR_BUCKETS = 24;
+    static constexpr uint32 MAX_WINDOW = HOUR_BUCKETS * 3600;
+
+    PopulationHeatmaps(uint32 cellSize, uint32 intervalMs);
+
+    void Record(time_t now, std::vector<PlayerPosition> const& positions);
+
+    // Cells with samples in the last `window` seconds, per-minute buckets up
+    // to an hour and per-hour buckets beyond. Returns false for a map nobody
+    // has been seen on during the last day.
+    bool Query(uint32 map, time_t now, uint32 window, HeatmapWindow& result) const;
+    std::vector<HeatmapMapSummary> GetMaps(time_t now) const;
+
+    uint32 GetCellSize() const { return _cellSize; }
+    uint32 GetColumns() const { return _columns; }
+    uint32 GetIntervalMs() const { return _intervalMs; }
+    size_t GetMemoryBytes() const;
+
+private:
+    struct Bucket
+    {
+        time_t Start = 0;
+        uint64 Samples = 0;
+        std::unordered_map<uint32, uint32> Cells;   // row * columns + column
+    };
+
+    struct MapHeat
+    {
+        std::deque<Bucket> Minutes;
+        std::deque<Bucket> Hours;
+    };
+
+    static Bucket& CurrentBucket(std::deque<Bucket>& buckets, time_t now, uint32 width, uint32 count);
+    static void Expire(std::deque<Bucket>& buckets, time_t now, uint32 width, uint32 count);
+
+    uint32 _cellSize;
+    uint32 _columns;
+    uint32 _intervalMs;
+
+    mutable std::mutex _mutex;
+    std::map<uint32, MapHeat> _maps;
+};
+
+#endif // GAMESTATEAPI_POPULATIONHEATMAP_H
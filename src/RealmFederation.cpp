@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "RealmFederation.h"
+#include "Log.h"
+#include <yhirose/httplib.h>
+#include <algorithm>
+#include <ctime>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace
+{
+    // A base line of a very large realm stays far below this
+    constexpr size_t MAX_LINE_BYTES = 64 * 1024 * 1024;
+
+    std::string Trim(std::string const& value)
+    {
+        size_t first = value.find_first_not_of(" \t");
+        if (first == std::string::npos)
+            return "";
+
+        size_t last = value.find_last_not_of(" \t");
+        return value.substr(first, last - first + 1);
+    }
+}
+
+RealmFederation::RealmFederation(uint32 serverIntervalMs)
+    : _serverIntervalMs(std::max<uint32>(serverIntervalMs, 1000)), _stopping(false)
+{
+}
+
+RealmFederation::~RealmFederation()
+{
+    Stop();
+}
+
+bool RealmFederation::Open(std::string const& peers, std::string& error)
+{
+    size_t start = 0;
+    while (start <= peers.size())
+    {
+        size_t end = peers.find(',', start);
+        if (end == std::string::npos)
+            end = peers.size();
+
+        std::string entry = Trim(peers.substr(start, end - start));
+        start = end + 1;
+        if (entry.empty())
+            continue;
+
+        size_t equals = entry.find('=');
+        std::string name = equals == std::string::npos ? "" : Trim(entry.substr(0, equals));
+        std::string endpoint = equals == std::string::npos ? "" : Trim(entry.substr(equals + 1));
+        if (name.empty() || endpoint.rfind("http://", 0) != 0 || endpoint.size() <= 7)
+        {
+            error = "peer \"" + entry + "\" is not Name=http://host:port";
+            return false;
+        }
+
+        if (std::any_of(_peers.begin(), _peers.end(), [&name](std::unique_ptr<Peer> const& peer) { return peer->Name == name; }))
+        {
+            error = "peer name \"" + name + "\" is used twice";
+            return false;
+        }
+
+        while (endpoint.back() == '/')
+            endpoint.pop_back();
+
+        auto peer = std::make_unique<Peer>();
+        peer->Name = name;
+        peer->Endpoint = endpoint;
+        peer->State.Name = name;
+        peer->State.Endpoint = endpoint;
+        _peers.push_back(std::move(peer));
+    }
+
+    if (_peers.empty())
+    {
+        error = "no peers configured";
+        return false;
+    }
+
+    return true;
+}
+
+void RealmFederation::Start()
+{
+    _stopping = false;
+
+    int64 now = int64(std::time(nullptr));
+    for (std::unique_ptr<Peer>& peer : _peers)
+    {
+        if (peer->Thread.joinable())
+            continue;
+
+        {
+            std::lock_guard<std::mutex> lock(peer->Mutex);
+            peer->State.DisconnectedSince = now;
+        }
+
+        Peer* target = peer.get();
+        peer->Thread = std::thread([this, target]()
+        {
+#ifndef _WIN32
+            pthread_setname_np(pthread_self(), "gsapi-federate");
+#endif
+            Run(*target);
+        });
+    }
+}
+
+void RealmFederation::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_stopMutex);
+        _stopping = true;
+    }
+    _stopCondition.notify_all();
+
+    // Requests in flight would otherwise only notice at their read timeout
+    for (std::unique_ptr<Peer>& peer : _peers)
+    {
+        std::lock_guard<std::mutex> lock(peer->Mutex);
+        if (peer->StreamClient)
+            peer->StreamClient->stop();
+        if (peer->ServerClient)
+            peer->ServerClient->stop();
+    }
+
+    for (std::unique_ptr<Peer>& peer : _peers)
+        if (peer->Thread.joinable())
+            peer->Thread.join();
+}
+
+bool RealmFederation::IsStopping()
+{
+    std::lock_guard<std::mutex> lock(_stopMutex);
+    return _stopping;
+}
+
+bool RealmFederation::WaitForRetry(uint32 milliseconds)
+{
+    std::unique_lock<std::mutex> lock(_stopMutex);
+    return !_stopCondition.wait_for(lock, std::chrono::milliseconds(milliseconds), [this]() { return _stopping; });
+}
+
+void RealmFederation::Run(Peer& peer)
+{
+    uint32 backoffMs = MIN_RECONNECT_MS;
+    while (!IsStopping())
+    {
+        RefreshServer(peer);
+        if (Subscribe(peer))
+            backoffMs = MIN_RECONNECT_MS;
+
+        if (!WaitForRetry(backoffMs))
+            break;
+
+        backoffMs = std::min(backoffMs * 2, MAX_RECONNECT_MS);
+    }
+}
+
+bool RealmFederation::Subscribe(Peer& peer)
+{
+    httplib::Client client(peer.Endpoint);
+    client.set_connection_timeout(CONNECT_TIMEOUT_SECONDS);
+    client.set_read_timeout(READ_TIMEOUT_SECONDS);
+
+    {
+        std::lock_guard<std::mutex> lock(peer.Mutex);
+        if (IsStopping())
+            return false;
+        peer.StreamClient = &client;
+    }
+
+    std::string buffer;
+    std::string error;
+    bool answered = false;
+    SnapshotStream::PlayerMap players;
+    uint64 sequence = 0;
+    bool synchronized = false;
+    auto nextServerRefresh = std::chrono::steady_clock::now() + std::chrono::milliseconds(_serverIntervalMs);
+
+    auto onResponse = [&error](httplib::Response const& response)
+    {
+        if (response.status == 200)
+            return true;
+
+        error = "HTTP " + std::to_string(response.status);
+        return false;
+    };
+
+    auto onData = [&](char const* data, size_t length)
+    {
+        buffer.append(data, length);
+
+        try
+        {
+            size_t start = 0;
+            size_t end;
+            while ((end = buffer.find('\n', start)) != std::string::npos)
+            {
+                json record = json::parse(buffer.begin() + start, buffer.begin() + end);
+                start = end + 1;
+
+                std::string type = record.at("type").get<std::string>();
+                if (type == "hello")
+                {
+                    answered = true;
+                    LOG_INFO("module.gamestate_api", "Federation: subscribed to realm {} at {}", peer.Name, peer.Endpoint);
+
+                    std::lock_guard<std::mutex> lock(peer.Mutex);
+                    peer.State.Connected = true;
+                    peer.State.DisconnectedSince = 0;
+                    peer.State.LastError.clear();
+                    ++peer.State.Connects;
+                    continue;
+                }
+
+                if (type != "base" && type != "delta")
+                    continue;
+
+                // Peers send a base whenever a subscriber missed a generation, so a gap is a broken stream
+                uint64 recordSequence = record.at("seq").get<uint64>();
+                if (type == "delta" && (!synchronized || recordSequence != sequence + 1))
+                {
+                    error = "delta " + std::to_string(recordSequence) + " does not follow " + std::to_string(sequence);
+                    return false;
+                }
+
+                SnapshotStream::Apply(record, players);
+                sequence = recordSequence;
+                synchronized = true;
+
+                auto published = std::make_shared<SnapshotStream::PlayerMap const>(players);
+                std::lock_guard<std::mutex> lock(peer.Mutex);
+                peer.State.Players = std::move(published);
+                peer.State.Time = record.at("time").get<int64>();
+            }
+
+            buffer.erase(0, start);
+        }
+        catch (json::exception const& e)
+        {
+            error = std::string("malformed stream: ") + e.what();
+            return false;
+        }
+
+        if (buffer.size() > MAX_LINE_BYTES)
+        {
+            error = "stream line too long";
+            return false;
+        }
+
+        if (std::chrono::steady_clock::now() >= nextServerRefresh)
+        {
+            RefreshServer(peer);
+            nextServerRefresh = std::chrono::steady_clock::now() + std::chrono::milliseconds(_serverIntervalMs);
+        }
+
+        return !IsStopping();
+    };
+
+    httplib::Result result = client.Get("/api/players/stream", onResponse, onData);
+    if (error.empty())
+        error = result ? "stream closed by peer" : httplib::to_string(result.error());
+
+    bool stopping = IsStopping();
+    {
+        std::lock_guard<std::mutex> lock(peer.Mutex);
+        peer.StreamClient = nullptr;
+
+        bool wasConnected = peer.State.Connected;
+        peer.State.Connected = false;
+        if (!peer.State.DisconnectedSince)
+            peer.State.DisconnectedSince = int64(std::time(nullptr));
+        if (!stopping)
+            peer.State.LastError = error;
+
+        if (wasConnected && !stopping)
+            LOG_WARN("module.gamestate_api", "Federation: lost realm {} at {}: {}", peer.Name, peer.Endpoint, error);
+    }
+
+    return answered;
+}
+
+void RealmFederation::RefreshServer(Peer& peer)
+{
+    httplib::Client client(peer.Endpoint);
+    client.set_connection_timeout(CONNECT_TIMEOUT_SECONDS);
+    client.set_read_timeout(CONNECT_TIMEOUT_SECONDS);
+
+    {
+        std::lock_guard<std::mutex> lock(peer.Mutex);
+        if (IsStopping())
+            return;
+        peer.ServerClient = &client;
+    }
+
+    std::shared_ptr<json const> server;
+    httplib::Result result = client.Get("/api/server");
+    if (result && result->status == 200)
+    {
+        json data = json::parse(result->body, nullptr, false);
+        if (!data.is_discarded())
+            server = std::make_shared<json const>(std::move(data));
+    }
+
+    std::lock_guard<std::mutex> lock(peer.Mutex);
+    peer.ServerClient = nullptr;
+    if (server)
+        peer.State.Server = std::move(server);
+}
+
+std::vector<FederatedRealm> RealmFederation::GetRealms() const
+{
+    std::vector<FederatedRealm> realms;
+    realms.reserve(_peers.size());
+    for (std::unique_ptr<Peer> const& peer : _peers)
+    {
+        std::lock_guard<std::mutex> lock(peer->Mutex);
+        realms.push_back(peer->State);
+    }
+
+    return realms;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_REALMFEDERATION_H
+#define GAMESTATEAPI_REALMFEDERATION_H
+
+#include "Define.h"
+#include "SnapshotStreamFormat.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace httplib
+{
+    class Client;
+}
+
+// What the federation knows about one realm, copied out for readers
+struct FederatedRealm
+{
+    std::string Name;
+    std::string Endpoint;           // empty for the local realm
+    bool Connected = false;
+    int64 Time = 0;                 // of the newest generation received, unix seconds
+    int64 DisconnectedSince = 0;    // unix seconds, 0 while connected
+    uint64 Connects = 0;
+    std::string LastError;
+    std::shared_ptr<SnapshotStream::PlayerMap const> Players;
+    std::shared_ptr<nlohmann::json const> Server;   // latest /api/server answer
+};
+
+// Keeps a /api/players/stream subscription open to every peer realm and
+// mirrors each peer's players in memory, so merged views are answered
+// without asking the peers. Each peer has its own thread that applies the
+// base and delta lines as they arrive, polls the peer's /api/server now and
+// then, and reconnects with a backoff when the stream breaks.
+class RealmFederation
+{
+public:
+    static constexpr uint32 CONNECT_TIMEOUT_SECONDS = 5;
+    // Peers send a heartbeat at least every 5 seconds
+    static constexpr uint32 READ_TIMEOUT_SECONDS = 15;
+    static constexpr uint32 MIN_RECONNECT_MS = 1000;
+    static constexpr uint32 MAX_RECONNECT_MS = 30000;
+    // Players of a peer that has been unreachable this long are left out of merged views
+    static constexpr uint32 STALE_SECONDS = 60;
+
+    explicit RealmFederation(uint32 serverIntervalMs);
+    ~RealmFederation();
+
+    RealmFederation(RealmFederation const&) = delete;
+    RealmFederation& operator=(RealmFederation const&) = delete;
+
+    // Parses "Name=http://host:port,Other=http://host:port"
+    bool Open(std::string const& peers, std::string& error);
+
+    void Start();
+    void Stop();
+
+    std::vector<FederatedRealm> GetRealms() const;
+
+private:
+    struct Peer
+    {
+        std::string Name;
+        std::string Endpoint;
+        std::thread Thread;
+
+        // Guards the fields below; Stop() interrupts the clients in flight
+        mutable std::mutex Mutex;
+        httplib::Client* StreamClient = nullptr;
+        httplib::Client* ServerClient = nullptr;
+        FederatedRealm State;
+    };
+
+    void Run(Peer& peer);
+    // Returns true when the peer answered, so the backoff starts over
+    bool Subscribe(Peer& peer);
+    void RefreshServer(Peer& peer);
+    bool IsStopping();
+    // False when stopped while waiting
+    bool WaitForRetry(uint32 milliseconds);
+
+    uint32 _serverIntervalMs;
+    std::vector<std::unique_ptr<Peer>> _peers;
+
+    std::mutex _stopMutex;
+    std::condition_variable _stopCondition;
+    bool _stopping;
+};
+
+#endif // GAMESTATEAPI_REALMFEDERATION_H
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "RequestAccounting.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+RequestAccounting::RequestAccounting()
+    : _since(std::time(nullptr))
+{
+}
+
+uint64 RequestAccounting::ThreadCpuNs()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0;
+
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (k.QuadPart + u.QuadPart) * 100;
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+
+    return uint64(ts.tv_sec) * 1000000000ull + uint64(ts.tv_nsec);
+#endif
+}
+
+void RequestAccounting::Record(std::string const& route, std::string const& client, RequestSample const& sample)
+{
+    time_t now = std::time(nullptr);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    RequestCost& routeCost = _routes[route];
+    if (routeCost.Key.empty())
+        routeCost.Key = route;
+    Add(routeCost, sample, now);
+
+    auto itr = _clients.find(client);
+    if (itr == _clients.end())
+    {
+        // Bound memory against clients cycling through addresses or keys
+        std::string key = _clients.size() < MAX_CLIENTS ? client : "other";
+        itr = _clients.try_emplace(key).first;
+        itr->second.Key = key;
+    }
+    Add(itr->second, sample, now);
+}
+
+std::vector<RequestCost> RequestAccounting::GetRoutes(size_t limit) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return TopByCpu(_routes, limit);
+}
+
+std::vector<RequestCost> RequestAccounting::GetClients(size_t limit) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return TopByCpu(_clients, limit);
+}
+
+size_t RequestAccounting::GetClientCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _clients.size();
+}
+
+void RequestAccounting::Add(RequestCost& cost, RequestSample const& sample, time_t now)
+{
+    cost.Requests++;
+    if (sample.Status >= 400)
+        cost.Errors++;
+    cost.CpuNs += sample.CpuNs;
+    cost.WallNs += sample.WallNs;
+    cost.MaxCpuNs = std::max(cost.MaxCpuNs, sample.CpuNs);
+    cost.ResponseBytes += sample.ResponseBytes;
+    cost.Allocations += sample.Allocations;
+    cost.AllocatedBytes += sample.AllocatedBytes;
+    cost.LastSeen = now;
+    cost.CpuHistogram.Record(sample.CpuNs / 1e6);
+}
+
+std::vector<RequestCost> RequestAccounting::TopByCpu(std::unordered_map<std::string, RequestCost> const& costs, size_t limit)
+{
+    std::vector<RequestCost> result;
+    result.reserve(costs.size());
+    for (auto const& [key, cost] : costs)
+        result.push_back(cost);
+
+    std::sort(result.begin(), result.end(), [](RequestCost const& a, RequestCost const& b) { return a.CpuNs > b.CpuNs; });
+    if (limit && result.size() > limit)
+        result.resize(limit);
+
+    return result;
+}
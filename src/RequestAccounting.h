@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_REQUESTACCOUNTING_H
+#define GAMESTATEAPI_REQUESTACCOUNTING_H
+
+#include "Define.h"
+#include "LatencyHistogram.h"
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Cumulative cost of the requests attributed to one route or client
+struct RequestCost
+{
+    std::string Key;
+    uint64 Requests = 0;
+    uint64 Errors = 0;          // status >= 400
+    uint64 CpuNs = 0;           // thread CPU time spent in the handler
+    uint64 WallNs = 0;
+    uint64 MaxCpuNs = 0;
+    uint64 ResponseBytes = 0;
+    uint64 Allocations = 0;     // only with GAMESTATE_API_ALLOC_TRACKING
+    uint64 AllocatedBytes = 0;
+    time_t LastSeen = 0;
+    LatencyHistogram CpuHistogram; // per-request CPU time in ms
+
+    double CpuSeconds() const { return CpuNs / 1e9; }
+};
+
+// Cost of a single handled request
+struct RequestSample
+{
+    uint64 CpuNs = 0;
+    uint64 WallNs = 0;
+    uint64 Allocations = 0;
+    uint64 AllocatedBytes = 0;
+    int Status = 0;
+    size_t ResponseBytes = 0;
+};
+
+// Per-route and per-client CPU accounting of the HTTP handlers
+class RequestAccounting
+{
+public:
+    // Clients beyond this many distinct keys are folded into "other"
+    static constexpr size_t MAX_CLIENTS = 1024;
+
+    RequestAccounting();
+
+    // CPU time consumed so far by the calling thread
+    static uint64 ThreadCpuNs();
+
+    void Record(std::string const& route, std::string const& client, RequestSample const& sample);
+
+    // Sorted by CPU time, most expensive first; limit 0 returns everything
+    std::vector<RequestCost> GetRoutes(size_t limit = 0) const;
+    std::vector<RequestCost> GetClients(size_t limit = 0) const;
+
+    size_t GetClientCount() const;
+    time_t GetSince() const { return _since; }
+
+private:
+    static void Add(RequestCost& cost, RequestSample const& sample, time_t now);
+    static std::vector<RequestCost> TopByCpu(std::unordered_map<std::string, RequestCost> const& costs, size_t limit);
+
+    time_t _since;
+
+    mutable std::mutex _mutex;
+    std::unordered_map<std::string, RequestCost> _routes;
+    std::unordered_map<std::string, RequestCost> _clients;
+};
+
+#endif // GAMESTATEAPI_REQUESTACCOUNTING_H
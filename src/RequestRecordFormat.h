@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_REQUESTRECORDFORMAT_H
+#define GAMESTATEAPI_REQUESTRECORDFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// On-disk layout of the request recording ring, shared by the module's
+// RequestRecorder and gamestate-loadgen --replay. Only standard headers here,
+// the tools build without AzerothCore.
+//
+// The file is a FileHeader followed by Capacity bytes of ring. Head and Tail
+// are absolute byte counts: entries live in [Tail, Head), at position
+// offset % Capacity. Entries are 8-byte aligned and never wrap; the space left
+// at the end of the ring is covered by a filler entry instead.
+namespace RequestRecord
+{
+    constexpr char MAGIC[8] = { 'G', 'S', 'R', 'E', 'C', 'O', 'R', 'D' };
+    constexpr uint32_t VERSION = 1;
+    constexpr uint16_t FILLER = 0xFFFF;     // TargetLength of a filler entry
+    constexpr size_t MAX_TARGET_LENGTH = 4096;
+
+    struct FileHeader
+    {
+        char Magic[8];
+        uint32_t Version;
+        uint32_t HeaderSize;    // the ring starts at this file offset
+        uint64_t Capacity;      // ring size in bytes, a multiple of 8
+        uint64_t Head;          // bytes ever written
+        uint64_t Tail;          // absolute offset of the oldest entry
+        uint64_t Entries;       // entries ever written, fillers excluded
+        uint64_t CreatedUs;     // unix time in microseconds
+        uint64_t Reserved;
+    };
+
+    // Followed by TargetLength bytes of request target ("/api/players?equipment=true").
+    // A filler only has Size and TargetLength.
+    struct EntryHeader
+    {
+        uint32_t Size;          // whole entry including padding
+        uint16_t TargetLength;
+        uint16_t Status;
+        uint64_t TimestampUs;   // unix time the request arrived, in microseconds
+        uint32_t WallUs;        // time spent in the handler
+        uint32_t ClientId;      // hash of the client key, stable within a recording
+    };
+
+    static_assert(sizeof(FileHeader) == 64, "FileHeader layout changed");
+    static_assert(sizeof(EntryHeader) == 24, "EntryHeader layout changed");
+
+    constexpr uint32_t EntrySize(size_t targetLength)
+    {
+        return uint32_t((sizeof(EntryHeader) + targetLength + 7) & ~size_t(7));
+    }
+}
+
+#endif // GAMESTATEAPI_REQUESTRECORDFORMAT_H
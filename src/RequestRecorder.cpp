@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "RequestRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace RequestRecord;
+
+RequestRecorder::RequestRecorder(std::string path, uint64 capacityBytes)
+    : _path(std::move(path)), _capacity(std::max<uint64>(capacityBytes & ~uint64(7), 64 * 1024))
+{
+}
+
+RequestRecorder::~RequestRecorder()
+{
+    Close();
+}
+
+bool RequestRecorder::Open(std::string& error)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _mappingSize = sizeof(FileHeader) + _capacity;
+
+#ifdef _WIN32
+    _file = CreateFileA(_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+    {
+        _file = nullptr;
+        error = "cannot open " + _path + ": error " + std::to_string(GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    size.QuadPart = LONGLONG(_mappingSize);
+    _fileMapping = CreateFileMappingA(_file, nullptr, PAGE_READWRITE, size.HighPart, size.LowPart, nullptr);
+    _mapping = _fileMapping ? MapViewOfFile(_fileMapping, FILE_MAP_WRITE, 0, 0, _mappingSize) : nullptr;
+    if (!_mapping)
+    {
+        error = "cannot map " + _path + ": error " + std::to_string(GetLastError());
+        if (_fileMapping)
+            CloseHandle(_fileMapping);
+        CloseHandle(_file);
+        _fileMapping = _file = nullptr;
+        return false;
+    }
+#else
+    int fd = open(_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0640);
+    if (fd < 0)
+    {
+        error = "cannot open " + _path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    if (ftruncate(fd, off_t(_mappingSize)) != 0)
+    {
+        error = "cannot resize " + _path + ": " + std::strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    _mapping = mmap(nullptr, _mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (_mapping == MAP_FAILED)
+    {
+        _mapping = nullptr;
+        error = "cannot map " + _path + ": " + std::strerror(errno);
+        return false;
+    }
+#endif
+
+    _header = static_cast<FileHeader*>(_mapping);
+    _ring = static_cast<uint8*>(_mapping) + sizeof(FileHeader);
+
+    // Keep appending to a previous recording unless its layout differs
+    bool reuse = std::memcmp(_header->Magic, MAGIC, sizeof(MAGIC)) == 0 && _header->Version == VERSION
+        && _header->HeaderSize == sizeof(FileHeader) && _header->Capacity == _capacity
+        && _header->Tail <= _header->Head && _header->Head - _header->Tail <= _capacity;
+    if (!reuse)
+    {
+        std::memset(_header, 0, sizeof(FileHeader));
+        std::memcpy(_header->Magic, MAGIC, sizeof(MAGIC));
+        _header->Version = VERSION;
+        _header->HeaderSize = sizeof(FileHeader);
+        _header->Capacity = _capacity;
+        _header->CreatedUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    return true;
+}
+
+void RequestRecorder::Close()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_mapping)
+        return;
+
+#ifdef _WIN32
+    FlushViewOfFile(_mapping, 0);
+    UnmapViewOfFile(_mapping);
+    CloseHandle(_fileMapping);
+    CloseHandle(_file);
+    _fileMapping = _file = nullptr;
+#else
+    msync(_mapping, _mappingSize, MS_ASYNC);
+    munmap(_mapping, _mappingSize);
+#endif
+
+    _mapping = nullptr;
+    _header = nullptr;
+    _ring = nullptr;
+}
+
+void RequestRecorder::Reserve(uint64 size)
+{
+    while (_header->Head + size - _header->Tail > _header->Capacity)
+    {
+        uint32 entrySize = reinterpret_cast<EntryHeader*>(At(_header->Tail))->Size;
+        if (entrySize == 0 || entrySize > _header->Capacity)
+        {
+            // Corrupted, e.g. a torn write before a crash: start over
+            _header->Tail = _header->Head;
+            return;
+        }
+
+        _header->Tail += entrySize;
+    }
+}
+
+void RequestRecorder::Append(std::string const& target, int status, uint64 timestampUs, uint32 wallUs, uint32 clientId)
+{
+    size_t length = std::min(target.size(), MAX_TARGET_LENGTH);
+    uint32 size = EntrySize(length);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_mapping)
+        return;
+
+    uint64 position = _header->Head % _header->Capacity;
+    if (position + size > _header->Capacity)
+    {
+        uint32 fillerSize = uint32(_header->Capacity - position);
+        Reserve(fillerSize);
+
+        EntryHeader* filler = reinterpret_cast<EntryHeader*>(At(_header->Head));
+        filler->Size = fillerSize;
+        filler->TargetLength = FILLER;
+        _header->Head += fillerSize;
+    }
+
+    Reserve(size);
+
+    EntryHeader* entry = reinterpret_cast<EntryHeader*>(At(_header->Head));
+    entry->Size = size;
+    entry->TargetLength = uint16(length);
+    entry->Status = uint16(status);
+    entry->TimestampUs = timestampUs;
+    entry->WallUs = wallUs;
+    entry->ClientId = clientId;
+    std::memcpy(entry + 1, target.data(), length);
+
+    _header->Head += size;
+    _header->Entries++;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_REQUESTRECORDER_H
+#define GAMESTATEAPI_REQUESTRECORDER_H
+
+#include "Define.h"
+#include "RequestRecordFormat.h"
+#include <mutex>
+#include <string>
+
+// Appends every handled request to a memory-mapped ring file (see
+// RequestRecordFormat.h), oldest entries are overwritten once it is full.
+// An append is a lock plus a memcpy into the mapping; the kernel writes the
+// pages back, so recordings survive a worldserver crash.
+class RequestRecorder
+{
+public:
+    RequestRecorder(std::string path, uint64 capacityBytes);
+    ~RequestRecorder();
+
+    RequestRecorder(RequestRecorder const&) = delete;
+    RequestRecorder& operator=(RequestRecorder const&) = delete;
+
+    // Maps the file, continuing an existing recording of the same capacity
+    bool Open(std::string& error);
+    void Close();
+
+    void Append(std::string const& target, int status, uint64 timestampUs, uint32 wallUs, uint32 clientId);
+
+    std::string const& GetPath() const { return _path; }
+
+private:
+    // Drops the oldest entries until `size` bytes fit in front of Head
+    void Reserve(uint64 size);
+    uint8* At(uint64 offset) const { return _ring + offset % _header->Capacity; }
+
+    std::string _path;
+    uint64 _capacity;
+
+    std::mutex _mutex;
+    void* _mapping = nullptr;
+    size_t _mappingSize = 0;
+    RequestRecord::FileHeader* _header = nullptr;
+    uint8* _ring = nullptr;
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _fileMapping = nullptr;
+#endif
+};
+
+#endif // GAMESTATEAPI_REQUESTRECORDER_H
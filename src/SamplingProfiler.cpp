@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "SamplingProfiler.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#ifndef _WIN32
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+#endif
+
+namespace
+{
+    std::atomic<bool> _running{false};
+}
+
+#ifdef _WIN32
+
+namespace SamplingProfiler
+{
+    bool Run(uint32 /*seconds*/, uint32 /*hz*/, Result& result)
+    {
+        result.Error = "Sampling profiler is not supported on this platform";
+        return false;
+    }
+
+    bool IsRunning() { return false; }
+}
+
+#else
+
+namespace
+{
+    constexpr uint32 MAX_FRAMES = 64;
+
+    // Hard cap on memory used by a single profile (~8.5 MB)
+    constexpr uint32 MAX_BUFFERED_SAMPLES = 16384;
+
+    // The handler frame and the kernel's sigreturn trampoline
+    constexpr int SKIPPED_FRAMES = 2;
+
+    struct Sample
+    {
+        pid_t Tid;
+        int Depth;
+        void* Frames[MAX_FRAMES];
+    };
+
+    // Shared with the signal handler. A handler counts itself in _inHandler
+    // before it looks at _armed, so once Run() has cleared _armed and seen
+    // _inHandler drop to 0, no handler can touch the buffer any more.
+    std::atomic<Sample*> _samples{nullptr};
+    std::atomic<uint32> _capacity{0};
+    std::atomic<uint32> _cursor{0};
+    std::atomic<uint64> _dropped{0};
+    std::atomic<uint32> _inHandler{0};
+    std::atomic<bool> _armed{false};
+    // Only lock-free atomics may be used from a signal handler
+    static_assert(std::atomic<Sample*>::is_always_lock_free && std::atomic<uint64>::is_always_lock_free, "signal-safe atomics");
+
+    void ProfSignalHandler(int /*sig*/, siginfo_t* /*info*/, void* /*context*/)
+    {
+        int savedErrno = errno;
+        // Sequentially consistent with the store to _armed and the load of _inHandler in Run()
+        _inHandler.fetch_add(1);
+
+        if (_armed.load())
+        {
+            uint32 index = _cursor.fetch_add(1, std::memory_order_relaxed);
+            if (index < _capacity.load(std::memory_order_relaxed))
+            {
+                Sample& sample = _samples.load(std::memory_order_relaxed)[index];
+                sample.Tid = static_cast<pid_t>(syscall(SYS_gettid));
+                sample.Depth = backtrace(sample.Frames, MAX_FRAMES);
+            }
+            else
+            {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        _inHandler.fetch_sub(1, std::memory_order_release);
+        errno = savedErrno;
+    }
+
+    std::string ThreadName(pid_t tid)
+    {
+        std::ifstream commFile(fmt::format("/proc/self/task/{}/comm", tid));
+        std::string name;
+        if (commFile.is_open() && std::getline(commFile, name) && !name.empty())
+        {
+            std::replace(name.begin(), name.end(), ' ', '_');
+            return name;
+        }
+
+        return fmt::format("tid-{}", tid);
+    }
+
+    std::string SymbolizeFrame(void* address, bool isLeaf)
+    {
+        // Return addresses point past the call instruction, step back into it
+        uintptr_t lookup = reinterpret_cast<uintptr_t>(address) - (isLeaf ? 0 : 1);
+
+        Dl_info info;
+        if (!dladdr(reinterpret_cast<void*>(lookup), &info))
+            return fmt::format("0x{:x}", lookup);
+
+        std::string frame;
+        if (info.dli_sname)
+        {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            frame = (status == 0 && demangled) ? demangled : info.dli_sname;
+            std::free(demangled);
+        }
+        else
+        {
+            char const* module = info.dli_fname ? info.dli_fname : "??";
+            if (char const* slash = std::strrchr(module, '/'))
+                module = slash + 1;
+
+            frame = fmt::format("{}+0x{:x}", module, lookup - reinterpret_cast<uintptr_t>(info.dli_fbase));
+        }
+
+        // ';' separates frames in the collapsed format
+        std::replace(frame.begin(), frame.end(), ';', ':');
+        return frame;
+    }
+
+    std::string Collapse(uint32 count)
+    {
+        std::unordered_map<void*, std::string> symbols;
+        std::unordered_map<pid_t, std::string> threadNames;
+        std::map<std::string, uint64> stacks;
+
+        for (uint32 i = 0; i < count; ++i)
+        {
+            Sample const& sample = _samples.load(std::memory_order_relaxed)[i];
+            if (sample.Depth <= SKIPPED_FRAMES)
+                continue;
+
+            auto nameItr = threadNames.find(sample.Tid);
+            if (nameItr == threadNames.end())
+                nameItr = threadNames.emplace(sample.Tid, ThreadName(sample.Tid)).first;
+
+            // Root first: thread;outermost;...;leaf
+            std::string stack = nameItr->second;
+            for (int frame = sample.Depth - 1; frame >= SKIPPED_FRAMES; --frame)
+            {
+                void* address = sample.Frames[frame];
+                auto symbolItr = symbols.find(address);
+                if (symbolItr == symbols.end())
+                    symbolItr = symbols.emplace(address, SymbolizeFrame(address, frame == SKIPPED_FRAMES)).first;
+
+                stack += ';';
+                stack += symbolItr->second;
+            }
+
+            ++stacks[stack];
+        }
+
+        std::string output;
+        for (auto const& [stack, samples] : stacks)
+        {
+            output += stack;
+            output += ' ';
+            output += std::to_string(samples);
+            output += '\n';
+        }
+
+        return output;
+    }
+}
+
+namespace SamplingProfiler
+{
+    bool Run(uint32 seconds, uint32 hz, Result& result)
+    {
+        if (seconds == 0 || hz == 0 || hz > 1000000)
+        {
+            result.Error = "Invalid profile duration or frequency";
+            return false;
+        }
+
+        bool expected = false;
+        if (!_running.compare_exchange_strong(expected, true))
+        {
+            result.Error = "A profile is already running";
+            return false;
+        }
+
+        // backtrace() lazily loads libgcc_s on first use; do that here and not
+        // inside the signal handler
+        void* warmup[4];
+        backtrace(warmup, 4);
+
+        uint64 expectedSamples = uint64(seconds) * hz * std::max(1u, std::thread::hardware_concurrency());
+        std::unique_ptr<Sample[]> buffer(new Sample[std::min<uint64>(expectedSamples, MAX_BUFFERED_SAMPLES)]);
+
+        _samples.store(buffer.get());
+        _capacity.store(static_cast<uint32>(std::min<uint64>(expectedSamples, MAX_BUFFERED_SAMPLES)));
+        _cursor.store(0);
+        _dropped.store(0);
+        _armed.store(true);
+
+        struct sigaction action = {};
+        struct sigaction previous = {};
+        action.sa_sigaction = ProfSignalHandler;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, &previous) != 0)
+        {
+            result.Error = fmt::format("sigaction failed: {}", std::strerror(errno));
+            _armed.store(false);
+            while (_inHandler.load(std::memory_order_acquire) != 0)
+                std::this_thread::yield();
+            _samples.store(nullptr);
+            _capacity.store(0);
+            _running.store(false);
+            return false;
+        }
+
+        struct itimerval timer = {};
+        timer.it_interval.tv_sec = 0;
+        timer.it_interval.tv_usec = std::max<suseconds_t>(1, 1000000 / hz);
+        timer.it_value = timer.it_interval;
+        if (setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+        {
+            result.Error = fmt::format("setitimer failed: {}", std::strerror(errno));
+            sigaction(SIGPROF, &previous, nullptr);
+            _armed.store(false);
+            while (_inHandler.load(std::memory_order_acquire) != 0)
+                std::this_thread::yield();
+            _samples.store(nullptr);
+            _capacity.store(0);
+            _running.store(false);
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+        struct itimerval disarm = {};
+        setitimer(ITIMER_PROF, &disarm, nullptr);
+
+        // A SIGPROF delivered from here on, even to the handler below, leaves the buffer alone
+        _armed.store(false);
+
+        // A SIGPROF still pending under the default disposition would terminate
+        // the worldserver, so ignore it rather than restoring SIG_DFL
+        if (!(previous.sa_flags & SA_SIGINFO) && previous.sa_handler == SIG_DFL)
+            previous.sa_handler = SIG_IGN;
+        sigaction(SIGPROF, &previous, nullptr);
+
+        // Let handlers that saw _armed set finish writing their sample
+        while (_inHandler.load(std::memory_order_acquire) != 0)
+            std::this_thread::yield();
+
+        uint32 collected = std::min(_cursor.load(), _capacity.load());
+
+        std::unordered_map<pid_t, bool> threads;
+        for (uint32 i = 0; i < collected; ++i)
+            threads[buffer[i].Tid] = true;
+
+        result.Collapsed = Collapse(collected);
+        result.Samples = collected;
+        result.Dropped = _dropped.load();
+        result.Threads = static_cast<uint32>(threads.size());
+        result.Seconds = seconds;
+        result.Hz = hz;
+
+        _samples.store(nullptr);
+        _capacity.store(0);
+        _running.store(false);
+        return true;
+    }
+
+    bool IsRunning()
+    {
+        return _running.load();
+    }
+}
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_SAMPLINGPROFILER_H
+#define GAMESTATEAPI_SAMPLINGPROFILER_H
+
+#include "Define.h"
+#include <string>
+
+// In-process CPU sampling profiler.
+// Uses ITIMER_PROF so SIGPROF is delivered to whichever worldserver thread is
+// burning CPU, captures the stack with backtrace() and symbolizes it with dladdr.
+// Only needs glibc, no perf or debug tooling on the host.
+namespace SamplingProfiler
+{
+    struct Result
+    {
+        std::string Error;
+        std::string Collapsed;   // flamegraph.pl / speedscope "collapsed" format
+        uint64 Samples = 0;
+        uint64 Dropped = 0;      // samples lost because the buffer was full
+        uint32 Threads = 0;
+        uint32 Seconds = 0;
+        uint32 Hz = 0;
+    };
+
+    // Profile the whole process for `seconds` at `hz` samples per CPU-second.
+    // Blocks the caller for the duration. Only one profile may run at a time.
+    bool Run(uint32 seconds, uint32 hz, Result& result);
+
+    // True while a profile is being collected
+    bool IsRunning();
+}
+
+#endif // GAMESTATEAPI_SAMPLINGPROFILER_H
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "SnapshotFeed.h"
+
+SnapshotGeneration::SnapshotGeneration(int64 epoch, uint64 sequence, int64 time, std::shared_ptr<SnapshotStream::PlayerMap const> players,
+    std::shared_ptr<SnapshotStream::PlayerMap const> previous)
+    : _epoch(epoch), _sequence(sequence), _time(time), _players(std::move(players)), _previous(std::move(previous))
+{
+}
+
+std::string const& SnapshotGeneration::GetBaseLine() const
+{
+    std::call_once(_baseOnce, [this]() { _baseLine = SnapshotStream::Base(_epoch, _sequence, _time, *_players); });
+    return _baseLine;
+}
+
+std::string const& SnapshotGeneration::GetDeltaLine() const
+{
+    if (!_previous)
+        return GetBaseLine();
+
+    std::call_once(_deltaOnce, [this]() { _deltaLine = SnapshotStream::Delta(_epoch, _sequence, _time, *_previous, *_players); });
+    return _deltaLine;
+}
+
+SnapshotFeed::SnapshotFeed()
+    : _epoch(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count()),
+    _nextSequence(1), _subscribers(0), _closed(false)
+{
+}
+
+void SnapshotFeed::Publish(int64 time, std::vector<SnapshotStream::Player> players)
+{
+    auto map = std::make_shared<SnapshotStream::PlayerMap>();
+    map->reserve(players.size());
+    for (SnapshotStream::Player& player : players)
+        map->emplace(player.Guid, std::move(player));
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        // Only the previous players are kept, not the previous generation, so history does not pile up
+        std::shared_ptr<SnapshotStream::PlayerMap const> previous = _latest ? _latest->GetPlayersPtr() : nullptr;
+        _latest = std::make_shared<SnapshotGeneration>(_epoch, _nextSequence++, time, std::move(map), std::move(previous));
+    }
+    _condition.notify_all();
+}
+
+std::shared_ptr<SnapshotGeneration const> SnapshotFeed::GetLatest() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _latest;
+}
+
+std::shared_ptr<SnapshotGeneration const> SnapshotFeed::WaitNewer(uint64 after, std::chrono::milliseconds timeout) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    bool ready = _condition.wait_for(lock, timeout, [this, after]()
+    {
+        return _closed || (_latest && _latest->GetSequence() > after);
+    });
+
+    if (!ready || _closed)
+        return nullptr;
+
+    return _latest;
+}
+
+void SnapshotFeed::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closed = true;
+    }
+    _condition.notify_all();
+}
+
+bool SnapshotFeed::IsClosed() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _closed;
+}
+
+bool SnapshotFeed::AddSubscriber(uint32 limit)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_subscribers >= limit)
+        return false;
+
+    ++_subscribers;
+    return true;
+}
+
+void SnapshotFeed::RemoveSubscriber()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    --_subscribers;
+}
+
+uint32 SnapshotFeed::GetSubscriberCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _subscribers;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_SNAPSHOTFEED_H
+#define GAMESTATEAPI_SNAPSHOTFEED_H
+
+#include "Define.h"
+#include "SnapshotStreamFormat.h"
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One published generation of online players. The base and delta lines are
+// encoded by the first subscriber that needs them and shared by the rest.
+class SnapshotGeneration
+{
+public:
+    SnapshotGeneration(int64 epoch, uint64 sequence, int64 time, std::shared_ptr<SnapshotStream::PlayerMap const> players,
+        std::shared_ptr<SnapshotStream::PlayerMap const> previous);
+
+    uint64 GetSequence() const { return _sequence; }
+    int64 GetTime() const { return _time; }
+    SnapshotStream::PlayerMap const& GetPlayers() const { return *_players; }
+    std::shared_ptr<SnapshotStream::PlayerMap const> const& GetPlayersPtr() const { return _players; }
+
+    std::string const& GetBaseLine() const;
+    // Changes since generation Sequence - 1; a base for the first generation
+    std::string const& GetDeltaLine() const;
+
+private:
+    int64 _epoch;
+    uint64 _sequence;
+    int64 _time;
+    std::shared_ptr<SnapshotStream::PlayerMap const> _players;
+    std::shared_ptr<SnapshotStream::PlayerMap const> _previous;
+
+    mutable std::once_flag _baseOnce;
+    mutable std::once_flag _deltaOnce;
+    mutable std::string _baseLine;
+    mutable std::string _deltaLine;
+};
+
+// Latest generation captured by the world thread, for /api/players/stream
+// subscribers and the local realm of the federation. Only the latest is
+// kept: a subscriber that falls behind by more than one generation gets a
+// base instead of the deltas it missed.
+class SnapshotFeed
+{
+public:
+    SnapshotFeed();
+
+    // Called on the world thread
+    void Publish(int64 time, std::vector<SnapshotStream::Player> players);
+
+    std::shared_ptr<SnapshotGeneration const> GetLatest() const;
+    // Latest generation once it is newer than `after`; null on timeout or after Close()
+    std::shared_ptr<SnapshotGeneration const> WaitNewer(uint64 after, std::chrono::milliseconds timeout) const;
+
+    // Wakes every waiting subscriber so the HTTP server can stop
+    void Close();
+    bool IsClosed() const;
+
+    // False when `limit` subscribers are already connected
+    bool AddSubscriber(uint32 limit);
+    void RemoveSubscriber();
+    uint32 GetSubscriberCount() const;
+
+    int64 GetEpoch() const { return _epoch; }
+
+private:
+    int64 _epoch;       // ms, changes on every restart as sequences start over
+
+    mutable std::mutex _mutex;
+    mutable std::condition_variable _condition;
+    std::shared_ptr<SnapshotGeneration const> _latest;
+    uint64 _nextSequence;
+    uint32 _subscribers;
+    bool _closed;
+};
+
+#endif // GAMESTATEAPI_SNAPSHOTFEED_H
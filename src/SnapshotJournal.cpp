@@ -0,0 +1,537 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "SnapshotJournal.h"
+#include "Log.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace
+{
+    constexpr char MAGIC[8] = { 'G', 'S', 'J', 'O', 'U', 'R', 'N', 'L' };
+    constexpr uint32 VERSION = 1;
+
+    enum RecordType : uint8
+    {
+        RECORD_BASE     = 1,
+        RECORD_DELTA    = 2
+    };
+
+    struct SegmentHeader
+    {
+        char Magic[8];
+        uint32 Version;
+        uint32 HeaderSize;
+        uint64 Used;        // header included
+        int64 Created;
+        uint8 Reserved[32];
+    };
+    static_assert(sizeof(SegmentHeader) == 64, "segment header layout");
+
+    struct RecordHeader
+    {
+        uint32 Size;
+        uint8 Type;
+        uint8 Reserved[3];
+        int64 Time;
+    };
+    static_assert(sizeof(RecordHeader) == 16, "record header layout");
+
+    // Positional rows keep journal records smaller than the stream's keyed objects
+    json PlayerToRow(JournalPlayer const& player)
+    {
+        return json::array({ player.Guid, player.Name, player.Level, player.Class, player.Race, player.Gender,
+            player.Map, player.Zone, player.Area, player.X, player.Y, player.Z, player.GuildId, player.Guild, player.Equipment });
+    }
+
+    JournalPlayer PlayerFromRow(json const& data)
+    {
+        JournalPlayer player;
+        player.Guid = data.at(0).get<uint32>();
+        player.Name = data.at(1).get<std::string>();
+        player.Level = data.at(2).get<uint8>();
+        player.Class = data.at(3).get<uint8>();
+        player.Race = data.at(4).get<uint8>();
+        player.Gender = data.at(5).get<uint8>();
+        player.Map = data.at(6).get<uint32>();
+        player.Zone = data.at(7).get<uint32>();
+        player.Area = data.at(8).get<uint32>();
+        player.X = data.at(9).get<float>();
+        player.Y = data.at(10).get<float>();
+        player.Z = data.at(11).get<float>();
+        player.GuildId = data.at(12).get<uint32>();
+        player.Guild = data.at(13).get<std::string>();
+        json const& equipment = data.at(14);
+        for (size_t slot = 0; slot < player.Equipment.size() && slot < equipment.size(); ++slot)
+            player.Equipment[slot] = equipment[slot].get<uint32>();
+        return player;
+    }
+}
+
+SnapshotJournal::SnapshotJournal(std::string directory, uint32 baseEvery, uint32 segmentSizeMB, uint32 retentionHours, uint32 maxSizeMB)
+    : _directory(std::move(directory)), _baseEvery(std::max<uint32>(baseEvery, 1)),
+    _segmentSize(uint64(std::max<uint32>(segmentSizeMB, 1)) * 1024 * 1024), _retentionSeconds(int64(std::max<uint32>(retentionHours, 1)) * 3600),
+    _maxBytes(uint64(std::max<uint32>(maxSizeMB, 1)) * 1024 * 1024), _sinceBase(0), _stopping(false), _hasPending(false), _pendingTime(0)
+{
+}
+
+SnapshotJournal::~SnapshotJournal()
+{
+    Stop();
+}
+
+bool SnapshotJournal::Open(std::string& error)
+{
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    fs::create_directories(_directory, ec);
+    if (ec)
+    {
+        error = "cannot create " + _directory + ": " + ec.message();
+        return false;
+    }
+
+    std::vector<Segment> segments;
+    for (fs::directory_entry const& entry : fs::directory_iterator(_directory, ec))
+    {
+        std::string name = entry.path().filename().string();
+        if (!entry.is_regular_file() || name.rfind("journal-", 0) != 0 || entry.path().extension() != ".gsj")
+            continue;
+
+        Segment segment;
+        if (!IndexSegment(entry.path().string(), segment))
+        {
+            LOG_WARN("module.gamestate_api", "Ignoring unreadable journal segment {}", segment.Path);
+            continue;
+        }
+
+        // Segments still preallocated from a crash get their unused tail back
+        if (entry.file_size(ec) > segment.Used)
+            fs::resize_file(entry.path(), segment.Used, ec);
+
+        segments.push_back(std::move(segment));
+    }
+
+    std::sort(segments.begin(), segments.end(), [](Segment const& a, Segment const& b)
+    {
+        return a.Records.front().Time < b.Records.front().Time;
+    });
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _segments.assign(std::make_move_iterator(segments.begin()), std::make_move_iterator(segments.end()));
+    return true;
+}
+
+bool SnapshotJournal::IndexSegment(std::string const& path, Segment& segment)
+{
+    segment.Path = path;
+
+    std::ifstream file(path, std::ios::binary);
+    SegmentHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.Magic, MAGIC, sizeof(MAGIC)) != 0
+        || header.Version != VERSION || header.HeaderSize != sizeof(SegmentHeader))
+        return false;
+
+    uint64 offset = sizeof(SegmentHeader);
+    while (offset + sizeof(RecordHeader) <= header.Used)
+    {
+        RecordHeader record;
+        file.seekg(std::streamoff(offset));
+        if (!file.read(reinterpret_cast<char*>(&record), sizeof(record)) || offset + sizeof(record) + record.Size > header.Used)
+            break;
+
+        segment.Records.push_back({ record.Time, offset, record.Size, record.Type == RECORD_BASE });
+        offset += sizeof(record) + record.Size;
+    }
+
+    segment.Used = offset;
+    return !segment.Records.empty() && segment.Records.front().Base;
+}
+
+void SnapshotJournal::Start()
+{
+    if (_thread.joinable())
+        return;
+
+    _stopping = false;
+    _thread = std::thread([this]()
+    {
+#ifndef _WIN32
+        pthread_setname_np(pthread_self(), "gsapi-journal");
+#endif
+        Run();
+    });
+}
+
+void SnapshotJournal::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _stopping = true;
+    }
+    _queueCondition.notify_all();
+
+    if (_thread.joinable())
+        _thread.join();
+
+    CloseSegment();
+}
+
+void SnapshotJournal::Submit(int64 time, std::vector<JournalPlayer> players)
+{
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _pendingTime = time;
+        _pending = std::move(players);
+        _hasPending = true;
+    }
+    _queueCondition.notify_one();
+}
+
+void SnapshotJournal::Run()
+{
+    std::unique_lock<std::mutex> lock(_queueMutex);
+    while (true)
+    {
+        _queueCondition.wait(lock, [this]() { return _stopping || _hasPending; });
+
+        // The last generation handed over before shutdown is still written
+        if (!_hasPending)
+            break;
+
+        int64 time = _pendingTime;
+        std::vector<JournalPlayer> players = std::move(_pending);
+        _hasPending = false;
+
+        lock.unlock();
+        Write(time, std::move(players));
+        lock.lock();
+    }
+}
+
+void SnapshotJournal::Write(int64 time, std::vector<JournalPlayer> players)
+{
+    std::unordered_map<uint32, JournalPlayer> current;
+    current.reserve(players.size());
+    for (JournalPlayer& player : players)
+        current.emplace(player.Guid, std::move(player));
+
+    auto encodeBase = [&current]()
+    {
+        json list = json::array();
+        for (auto const& [guid, player] : current)
+            list.push_back(PlayerToRow(player));
+        return json::to_cbor(json{ {"players", list} });
+    };
+
+    bool base = !_mapping || _sinceBase >= _baseEvery;
+    std::vector<uint8> payload;
+    if (base)
+    {
+        payload = encodeBase();
+    }
+    else
+    {
+        json changed = json::array();
+        json removed = json::array();
+        for (auto const& [guid, player] : current)
+        {
+            auto itr = _last.find(guid);
+            if (itr == _last.end() || !(itr->second == player))
+                changed.push_back(PlayerToRow(player));
+        }
+        for (auto const& [guid, player] : _last)
+            if (!current.count(guid))
+                removed.push_back(guid);
+
+        payload = json::to_cbor(json{ {"changed", changed}, {"removed", removed} });
+    }
+
+    // A full segment is closed and the next one starts with a base
+    if (_mapping && _segments.back().Used + sizeof(RecordHeader) + payload.size() > _mappingSize)
+    {
+        CloseSegment();
+        if (!base)
+        {
+            payload = encodeBase();
+            base = true;
+        }
+    }
+
+    if (!_mapping)
+    {
+        std::string error;
+        if (!OpenSegment(time, sizeof(SegmentHeader) + sizeof(RecordHeader) + payload.size(), error))
+        {
+            LOG_ERROR("module.gamestate_api", "Snapshot journal: {}", error);
+            return;
+        }
+    }
+
+    uint8* data = static_cast<uint8*>(_mapping);
+    SegmentHeader* header = reinterpret_cast<SegmentHeader*>(data);
+
+    RecordHeader record = {};
+    record.Size = uint32(payload.size());
+    record.Type = base ? RECORD_BASE : RECORD_DELTA;
+    record.Time = time;
+
+    uint64 offset = header->Used;
+    std::memcpy(data + offset, &record, sizeof(record));
+    std::memcpy(data + offset + sizeof(record), payload.data(), payload.size());
+    header->Used = offset + sizeof(record) + payload.size();
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Segment& segment = _segments.back();
+        segment.Records.push_back({ time, offset, record.Size, base });
+        segment.Used = header->Used;
+    }
+
+    _last = std::move(current);
+    _sinceBase = base ? 1 : _sinceBase + 1;
+
+    EnforceRetention(time);
+}
+
+bool SnapshotJournal::OpenSegment(int64 time, uint64 minimumSize, std::string& error)
+{
+    std::string path = _directory + "/journal-" + std::to_string(time) + ".gsj";
+    for (uint32 suffix = 1; std::filesystem::exists(path); ++suffix)
+        path = _directory + "/journal-" + std::to_string(time) + "-" + std::to_string(suffix) + ".gsj";
+
+    _mappingSize = size_t(std::max(_segmentSize, minimumSize));
+
+#ifdef _WIN32
+    _file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+    {
+        _file = nullptr;
+        error = "cannot create " + path + ": error " + std::to_string(GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    size.QuadPart = LONGLONG(_mappingSize);
+    _fileMapping = CreateFileMappingA(_file, nullptr, PAGE_READWRITE, size.HighPart, size.LowPart, nullptr);
+    _mapping = _fileMapping ? MapViewOfFile(_fileMapping, FILE_MAP_WRITE, 0, 0, _mappingSize) : nullptr;
+    if (!_mapping)
+    {
+        error = "cannot map " + path + ": error " + std::to_string(GetLastError());
+        if (_fileMapping)
+            CloseHandle(_fileMapping);
+        CloseHandle(_file);
+        _fileMapping = _file = nullptr;
+        return false;
+    }
+#else
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0640);
+    if (fd < 0)
+    {
+        error = "cannot create " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    if (ftruncate(fd, off_t(_mappingSize)) != 0)
+    {
+        error = "cannot resize " + path + ": " + std::strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    _mapping = mmap(nullptr, _mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (_mapping == MAP_FAILED)
+    {
+        _mapping = nullptr;
+        error = "cannot map " + path + ": " + std::strerror(errno);
+        return false;
+    }
+#endif
+
+    SegmentHeader* header = static_cast<SegmentHeader*>(_mapping);
+    std::memset(header, 0, sizeof(SegmentHeader));
+    std::memcpy(header->Magic, MAGIC, sizeof(MAGIC));
+    header->Version = VERSION;
+    header->HeaderSize = sizeof(SegmentHeader);
+    header->Used = sizeof(SegmentHeader);
+    header->Created = time;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    Segment& segment = _segments.emplace_back();
+    segment.Path = path;
+    segment.Used = header->Used;
+    return true;
+}
+
+void SnapshotJournal::CloseSegment()
+{
+    if (!_mapping)
+        return;
+
+    std::string path;
+    uint64 used;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        path = _segments.back().Path;
+        used = _segments.back().Used;
+    }
+
+#ifdef _WIN32
+    FlushViewOfFile(_mapping, 0);
+    UnmapViewOfFile(_mapping);
+    CloseHandle(_fileMapping);
+    LARGE_INTEGER size;
+    size.QuadPart = LONGLONG(used);
+    SetFilePointerEx(_file, size, nullptr, FILE_BEGIN);
+    SetEndOfFile(_file);
+    CloseHandle(_file);
+    _fileMapping = _file = nullptr;
+#else
+    msync(_mapping, _mappingSize, MS_ASYNC);
+    munmap(_mapping, _mappingSize);
+
+    // Give back the preallocated space that was not needed
+    if (truncate(path.c_str(), off_t(used)) != 0)
+        LOG_WARN("module.gamestate_api", "Snapshot journal: cannot truncate {}: {}", path, std::strerror(errno));
+#endif
+
+    _mapping = nullptr;
+    _mappingSize = 0;
+
+    // A segment without a single record is of no use to readers
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_segments.back().Records.empty())
+    {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        _segments.pop_back();
+    }
+}
+
+void SnapshotJournal::EnforceRetention(int64 now)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    uint64 total = 0;
+    for (Segment const& segment : _segments)
+        total += segment.Used;
+
+    // Never the segment being written
+    while (_segments.size() > 1)
+    {
+        Segment const& oldest = _segments.front();
+        if (oldest.Records.back().Time >= now - _retentionSeconds && total <= _maxBytes)
+            break;
+
+        std::error_code ec;
+        std::filesystem::remove(oldest.Path, ec);
+        if (ec)
+            LOG_WARN("module.gamestate_api", "Snapshot journal: cannot remove {}: {}", oldest.Path, ec.message());
+
+        total -= oldest.Used;
+        _segments.pop_front();
+    }
+}
+
+bool SnapshotJournal::GetStateAt(int64 at, JournalState& state) const
+{
+    std::string path;
+    std::vector<RecordRef> records;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto segment = std::find_if(_segments.rbegin(), _segments.rend(), [at](Segment const& candidate)
+        {
+            return !candidate.Records.empty() && candidate.Records.front().Time <= at;
+        });
+        if (segment == _segments.rend())
+            return false;
+
+        auto last = std::upper_bound(segment->Records.begin(), segment->Records.end(), at,
+            [](int64 time, RecordRef const& record) { return time < record.Time; });
+        auto base = std::find_if(std::make_reverse_iterator(last), segment->Records.rend(), [](RecordRef const& record) { return record.Base; });
+
+        path = segment->Path;
+        records.assign(std::prev(base.base()), last);
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    std::unordered_map<uint32, JournalPlayer> players;
+    std::vector<uint8> payload;
+    for (RecordRef const& record : records)
+    {
+        payload.resize(record.Size);
+        file.seekg(std::streamoff(record.Offset + sizeof(RecordHeader)));
+        if (!file.read(reinterpret_cast<char*>(payload.data()), payload.size()))
+            return false;
+
+        json data = json::from_cbor(payload);
+        if (record.Base)
+        {
+            players.clear();
+            for (json const& player : data.at("players"))
+                players[player.at(0).get<uint32>()] = PlayerFromRow(player);
+        }
+        else
+        {
+            for (json const& player : data.at("changed"))
+                players[player.at(0).get<uint32>()] = PlayerFromRow(player);
+            for (json const& guid : data.at("removed"))
+                players.erase(guid.get<uint32>());
+        }
+    }
+
+    state.Time = records.back().Time;
+    state.Players.clear();
+    state.Players.reserve(players.size());
+    for (auto& [guid, player] : players)
+        state.Players.push_back(std::move(player));
+
+    std::sort(state.Players.begin(), state.Players.end(), [](JournalPlayer const& a, JournalPlayer const& b) { return a.Name < b.Name; });
+    return true;
+}
+
+std::vector<JournalSegmentInfo> SnapshotJournal::GetSegments() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::vector<JournalSegmentInfo> segments;
+    for (Segment const& segment : _segments)
+    {
+        if (segment.Records.empty())
+            continue;
+
+        JournalSegmentInfo& info = segments.emplace_back();
+        info.Path = segment.Path;
+        info.From = segment.Records.front().Time;
+        info.To = segment.Records.back().Time;
+        info.Bytes = segment.Used;
+        info.Records = uint32(segment.Records.size());
+    }
+
+    return segments;
+}
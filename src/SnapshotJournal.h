@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_SNAPSHOTJOURNAL_H
+#define GAMESTATEAPI_SNAPSHOTJOURNAL_H
+
+#include "Define.h"
+#include "SnapshotStreamFormat.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// What the journal remembers of an online player
+using JournalPlayer = SnapshotStream::Player;
+
+struct JournalState
+{
+    int64 Time = 0;     // unix seconds of the generation the state was rebuilt to
+    std::vector<JournalPlayer> Players;
+};
+
+struct JournalSegmentInfo
+{
+    std::string Path;
+    int64 From = 0;
+    int64 To = 0;
+    uint64 Bytes = 0;
+    uint32 Records = 0;
+};
+
+// Append-only journal of player snapshot generations. The world thread hands
+// each generation to a writer thread, which stores either the full state
+// (base) or the players changed and removed since the previous generation
+// (delta) as a CBOR record in a memory-mapped segment file. Every segment
+// starts with a base, so whole segments can be deleted for retention and any
+// moment is rebuilt from one base plus the deltas after it.
+//
+// Segment: 64 byte header (magic "GSJOURNL", version, header size, bytes
+// used, creation time), then records of a 16 byte header (payload size,
+// type, time) followed by the payload. "Used" only advances once a record is
+// complete, so a crash loses at most the record being written.
+class SnapshotJournal
+{
+public:
+    SnapshotJournal(std::string directory, uint32 baseEvery, uint32 segmentSizeMB, uint32 retentionHours, uint32 maxSizeMB);
+    ~SnapshotJournal();
+
+    SnapshotJournal(SnapshotJournal const&) = delete;
+    SnapshotJournal& operator=(SnapshotJournal const&) = delete;
+
+    // Creates the directory and indexes the segments already in it
+    bool Open(std::string& error);
+
+    void Start();
+    void Stop();
+
+    // Called on the world thread; replaces a generation the writer has not picked up yet
+    void Submit(int64 time, std::vector<JournalPlayer> players);
+
+    // State as of the newest generation at or before `at`. False when the
+    // journal does not reach back that far.
+    bool GetStateAt(int64 at, JournalState& state) const;
+
+    std::vector<JournalSegmentInfo> GetSegments() const;
+    std::string const& GetDirectory() const { return _directory; }
+
+private:
+    struct RecordRef
+    {
+        int64 Time;
+        uint64 Offset;      // of the record header
+        uint32 Size;        // payload bytes
+        bool Base;
+    };
+
+    struct Segment
+    {
+        std::string Path;
+        uint64 Used = 0;
+        std::vector<RecordRef> Records;
+    };
+
+    void Run();
+    void Write(int64 time, std::vector<JournalPlayer> players);
+    bool OpenSegment(int64 time, uint64 minimumSize, std::string& error);
+    void CloseSegment();
+    void EnforceRetention(int64 now);
+    static bool IndexSegment(std::string const& path, Segment& segment);
+
+    std::string _directory;
+    uint32 _baseEvery;
+    uint64 _segmentSize;
+    int64 _retentionSeconds;
+    uint64 _maxBytes;
+
+    // Segments oldest first; the last one is being written while _mapping is set
+    mutable std::mutex _mutex;
+    std::deque<Segment> _segments;
+
+    // Writer thread only
+    std::unordered_map<uint32, JournalPlayer> _last;
+    uint32 _sinceBase;
+    void* _mapping = nullptr;
+    size_t _mappingSize = 0;
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _fileMapping = nullptr;
+#endif
+
+    std::thread _thread;
+    std::mutex _queueMutex;
+    std::condition_variable _queueCondition;
+    bool _stopping;
+    bool _hasPending;
+    int64 _pendingTime;
+    std::vector<JournalPlayer> _pending;
+};
+
+#endif // GAMESTATEAPI_SNAPSHOTJOURNAL_H
@@ -0,0 +1,464 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "SnapshotPusher.h"
+#include "Log.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    int64 NowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+SnapshotPusher::SnapshotPusher(std::string endpoint, uint32 baseEvery, uint32 bufferKB, uint32 batchKB)
+    : _endpoint(std::move(endpoint)), _unix(false), _port(0), _baseEvery(std::max<uint32>(baseEvery, 1)),
+    _bufferBytes(uint64(std::max<uint32>(bufferKB, 64)) * 1024), _batchBytes(uint64(std::max<uint32>(batchKB, 4)) * 1024),
+    _epoch(NowMs()), _sinceBase(0), _socket(-1), _frontOffset(0), _reconnectMs(MIN_RECONNECT_MS), _queuedBytes(0),
+    _nextSequence(1), _forceBase(true), _stopping(false), _hasPending(false), _pendingTime(0)
+{
+}
+
+SnapshotPusher::~SnapshotPusher()
+{
+    Stop();
+}
+
+bool SnapshotPusher::Open(std::string& error)
+{
+#ifdef _WIN32
+    error = "Push mode is not supported on this platform";
+    return false;
+#else
+    if (_endpoint.rfind("unix:", 0) == 0)
+    {
+        _unix = true;
+        _path = _endpoint.substr(5);
+        if (_path.empty() || _path.size() >= sizeof(sockaddr_un::sun_path))
+        {
+            error = "invalid unix socket path in " + _endpoint;
+            return false;
+        }
+        return true;
+    }
+
+    if (_endpoint.rfind("tcp://", 0) == 0)
+    {
+        std::string address = _endpoint.substr(6);
+        size_t colon = address.rfind(':');
+        if (colon != std::string::npos && colon > 0)
+        {
+            _host = address.substr(0, colon);
+            // [::1]:9400
+            if (_host.front() == '[' && _host.back() == ']')
+                _host = _host.substr(1, _host.size() - 2);
+
+            uint32 port = 0;
+            std::string digits = address.substr(colon + 1);
+            if (!digits.empty() && digits.size() <= 5 && std::all_of(digits.begin(), digits.end(), ::isdigit))
+                port = uint32(std::stoul(digits));
+            if (port > 0 && port <= 65535)
+            {
+                _port = uint16(port);
+                return true;
+            }
+        }
+    }
+
+    error = "endpoint must be tcp://host:port or unix:/path, got \"" + _endpoint + "\"";
+    return false;
+#endif
+}
+
+void SnapshotPusher::Start()
+{
+    if (_thread.joinable())
+        return;
+
+    _stopping = false;
+    _thread = std::thread([this]()
+    {
+#ifndef _WIN32
+        pthread_setname_np(pthread_self(), "gsapi-push");
+#endif
+        Run();
+    });
+}
+
+void SnapshotPusher::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_workMutex);
+        _stopping = true;
+    }
+    _workCondition.notify_all();
+
+    if (_thread.joinable())
+        _thread.join();
+
+    if (_socket >= 0)
+        Disconnect("");
+}
+
+void SnapshotPusher::Submit(int64 time, std::vector<JournalPlayer> players)
+{
+    {
+        std::lock_guard<std::mutex> lock(_workMutex);
+        _pendingTime = time;
+        _pending = std::move(players);
+        _hasPending = true;
+    }
+    _workCondition.notify_one();
+}
+
+void SnapshotPusher::Run()
+{
+    std::unique_lock<std::mutex> lock(_workMutex);
+    while (!_stopping)
+    {
+        if (_hasPending)
+        {
+            int64 time = _pendingTime;
+            std::vector<JournalPlayer> players = std::move(_pending);
+            _hasPending = false;
+
+            lock.unlock();
+            Encode(time, std::move(players));
+            lock.lock();
+            continue;
+        }
+
+        bool queued;
+        {
+            std::lock_guard<std::mutex> queueLock(_mutex);
+            queued = !_queue.empty();
+        }
+
+        lock.unlock();
+        if (_socket < 0 && queued && std::chrono::steady_clock::now() >= _nextConnect)
+            Connect();
+
+        // Keep writing while the collector keeps up, but let a new generation in between batches
+        SendResult result = SendResult::Stalled;
+        while (_socket >= 0 && queued)
+        {
+            result = SendBatch();
+            if (result != SendResult::Progress)
+                break;
+
+            {
+                std::lock_guard<std::mutex> queueLock(_mutex);
+                queued = !_queue.empty();
+            }
+
+            std::lock_guard<std::mutex> workLock(_workMutex);
+            if (_hasPending || _stopping)
+                break;
+        }
+        lock.lock();
+
+        if (_stopping || _hasPending)
+            continue;
+
+        // Nothing queued: sleep until the next generation. Otherwise retry
+        // the stalled write or the reconnect shortly.
+        if (!queued)
+            _workCondition.wait(lock);
+        else if (_socket >= 0 && result == SendResult::Progress)
+            continue;
+        else if (_socket >= 0)
+            _workCondition.wait_for(lock, std::chrono::milliseconds(100));
+        else
+            _workCondition.wait_until(lock, _nextConnect);
+    }
+}
+
+void SnapshotPusher::Encode(int64 time, std::vector<JournalPlayer> players)
+{
+    std::unordered_map<uint32, JournalPlayer> current;
+    current.reserve(players.size());
+    for (JournalPlayer& player : players)
+        current.emplace(player.Guid, std::move(player));
+
+    uint64 sequence;
+    bool base;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        sequence = _nextSequence++;
+        base = _forceBase || _sinceBase >= _baseEvery;
+        _forceBase = false;
+    }
+
+    std::string line = base ? SnapshotStream::Base(_epoch, sequence, time, current)
+        : SnapshotStream::Delta(_epoch, sequence, time, _last, current);
+
+    _last = std::move(current);
+    _sinceBase = base ? 1 : _sinceBase + 1;
+
+    Enqueue(sequence, std::move(line));
+}
+
+void SnapshotPusher::Enqueue(uint64 sequence, std::string line)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _queuedBytes += line.size();
+    _queue.push_back({ sequence, std::move(line) });
+    _stats.Sequence = sequence;
+
+    // Drop the oldest lines, but never the newest one or one that is half written
+    size_t keep = _frontOffset > 0 ? 1 : 0;
+    bool dropped = false;
+    while (_queuedBytes > _bufferBytes && _queue.size() > keep + 1)
+    {
+        auto victim = _queue.begin() + keep;
+        _queuedBytes -= victim->Line.size();
+        _queue.erase(victim);
+        ++_stats.DroppedRecords;
+        dropped = true;
+    }
+
+    // Deltas after a gap are useless until the next base
+    if (dropped)
+        _forceBase = true;
+
+    _stats.BufferedRecords = _queue.size();
+    _stats.BufferedBytes = _queuedBytes;
+}
+
+bool SnapshotPusher::Connect()
+{
+#ifdef _WIN32
+    return false;
+#else
+    std::string error;
+    int fd = -1;
+
+    if (_unix)
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, _path.c_str(), _path.size() + 1);
+
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            error = std::strerror(errno);
+            close(fd);
+            fd = -1;
+        }
+    }
+    else
+    {
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* addresses = nullptr;
+        int status = getaddrinfo(_host.c_str(), std::to_string(_port).c_str(), &hints, &addresses);
+        if (status != 0)
+            error = gai_strerror(status);
+
+        for (addrinfo* address = addresses; address && fd < 0; address = address->ai_next)
+        {
+            fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, address->ai_protocol);
+            if (fd < 0)
+                continue;
+
+            // Bounded connect, so an unreachable collector does not hold the writer for minutes
+            int result = connect(fd, address->ai_addr, address->ai_addrlen);
+            if (result != 0 && errno == EINPROGRESS)
+            {
+                pollfd pfd = { fd, POLLOUT, 0 };
+                int socketError = ETIMEDOUT;
+                socklen_t length = sizeof(socketError);
+                if (poll(&pfd, 1, SEND_TIMEOUT_MS) == 1)
+                    getsockopt(fd, SOL_SOCKET, SO_ERROR, &socketError, &length);
+                result = socketError == 0 ? 0 : -1;
+                errno = socketError;
+            }
+
+            if (result != 0)
+            {
+                error = std::strerror(errno);
+                close(fd);
+                fd = -1;
+                continue;
+            }
+
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        if (addresses)
+            freeaddrinfo(addresses);
+    }
+
+    if (fd < 0)
+    {
+        bool first = _reconnectMs == MIN_RECONNECT_MS;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.LastError = error;
+        }
+        if (first)
+            LOG_WARN("module.gamestate_api", "Snapshot push: cannot connect to {}: {}", _endpoint, error);
+
+        _nextConnect = std::chrono::steady_clock::now() + std::chrono::milliseconds(_reconnectMs);
+        _reconnectMs = std::min(_reconnectMs * 2, MAX_RECONNECT_MS);
+        return false;
+    }
+
+    // A collector that stops reading makes send() return EAGAIN instead of blocking the writer
+    timeval timeout = { SEND_TIMEOUT_MS / 1000, (SEND_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    _socket = fd;
+    _frontOffset = 0;
+    _reconnectMs = MIN_RECONNECT_MS;
+
+    uint64 first;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        first = _queue.empty() ? _nextSequence : _queue.front().Sequence;
+        // A collector that lost its state resynchronizes on the next generation
+        _forceBase = true;
+        _stats.Connected = true;
+        ++_stats.Connects;
+        _stats.LastError.clear();
+    }
+
+    LOG_INFO("module.gamestate_api", "Snapshot push: connected to {}", _endpoint);
+
+    std::string line = SnapshotStream::Hello(_epoch, first);
+
+    size_t sent = 0;
+    while (sent < line.size())
+    {
+        ssize_t written = send(_socket, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+        if (written <= 0)
+        {
+            Disconnect(std::strerror(errno));
+            return false;
+        }
+        sent += size_t(written);
+    }
+
+    return true;
+#endif
+}
+
+void SnapshotPusher::Disconnect(std::string const& error)
+{
+#ifndef _WIN32
+    close(_socket);
+#endif
+    _socket = -1;
+    // The collector never saw the rest of the line; it is sent whole on the next connection
+    _frontOffset = 0;
+    _nextConnect = std::chrono::steady_clock::now() + std::chrono::milliseconds(_reconnectMs);
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.Connected = false;
+        if (!error.empty())
+            _stats.LastError = error;
+    }
+
+    if (!error.empty())
+        LOG_WARN("module.gamestate_api", "Snapshot push: lost connection to {}: {}", _endpoint, error);
+}
+
+SnapshotPusher::SendResult SnapshotPusher::SendBatch()
+{
+#ifdef _WIN32
+    return SendResult::Lost;
+#else
+    // Lines are only removed from the queue by this thread, so the gathered
+    // pointers stay valid without holding the lock during send()
+    std::vector<iovec> parts;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        uint64 bytes = 0;
+        size_t offset = _frontOffset;
+        for (Record& record : _queue)
+        {
+            if (!parts.empty() && bytes + record.Line.size() - offset > _batchBytes)
+                break;
+            if (parts.size() >= IOV_MAX)
+                break;
+
+            parts.push_back({ record.Line.data() + offset, record.Line.size() - offset });
+            bytes += record.Line.size() - offset;
+            offset = 0;
+        }
+    }
+
+    if (parts.empty())
+        return SendResult::Stalled;
+
+    msghdr message = {};
+    message.msg_iov = parts.data();
+    message.msg_iovlen = parts.size();
+    ssize_t written = sendmsg(_socket, &message, MSG_NOSIGNAL);
+    if (written < 0)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            return SendResult::Stalled;
+
+        Disconnect(std::strerror(errno));
+        return SendResult::Lost;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t remaining = size_t(written);
+    _stats.SentBytes += remaining;
+    while (remaining > 0)
+    {
+        Record& front = _queue.front();
+        size_t left = front.Line.size() - _frontOffset;
+        if (remaining < left)
+        {
+            _frontOffset += remaining;
+            break;
+        }
+
+        remaining -= left;
+        _queuedBytes -= front.Line.size();
+        _queue.pop_front();
+        _frontOffset = 0;
+        ++_stats.SentRecords;
+    }
+
+    _stats.BufferedRecords = _queue.size();
+    _stats.BufferedBytes = _queuedBytes;
+    return SendResult::Progress;
+#endif
+}
+
+PushStats SnapshotPusher::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
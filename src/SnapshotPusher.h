@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_SNAPSHOTPUSHER_H
+#define GAMESTATEAPI_SNAPSHOTPUSHER_H
+
+#include "Define.h"
+#include "SnapshotJournal.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct PushStats
+{
+    bool Connected = false;
+    uint64 Sequence = 0;        // of the newest record queued
+    uint64 SentRecords = 0;
+    uint64 SentBytes = 0;
+    uint64 DroppedRecords = 0;
+    uint64 BufferedRecords = 0;
+    uint64 BufferedBytes = 0;
+    uint64 Connects = 0;
+    std::string LastError;
+};
+
+// Streams player snapshot generations to one collector, so consumers read
+// from the aggregation tier instead of polling the worldserver. Each
+// generation is encoded once, as one NDJSON line holding either the full
+// state (base) or the players changed and removed since the previous one
+// (delta), and queued for a writer thread that sends as many queued lines
+// as fit in a batch per write.
+//
+// The queue is bounded in bytes. Lines that could not be sent stay queued
+// across reconnects; when the queue is full the oldest are dropped, and the
+// next generation is a base so the collector can resynchronize. Every
+// connection also starts with a "hello" line and gets a base soon after.
+// Collectors detect gaps from the consecutive "seq" numbers.
+class SnapshotPusher
+{
+public:
+    static constexpr uint32 MIN_RECONNECT_MS = 1000;
+    static constexpr uint32 MAX_RECONNECT_MS = 30000;
+    static constexpr uint32 SEND_TIMEOUT_MS = 5000;
+
+    SnapshotPusher(std::string endpoint, uint32 baseEvery, uint32 bufferKB, uint32 batchKB);
+    ~SnapshotPusher();
+
+    SnapshotPusher(SnapshotPusher const&) = delete;
+    SnapshotPusher& operator=(SnapshotPusher const&) = delete;
+
+    // Parses "tcp://host:port" or "unix:/path"
+    bool Open(std::string& error);
+
+    void Start();
+    void Stop();
+
+    // Called on the world thread; encoding happens on the writer thread
+    void Submit(int64 time, std::vector<JournalPlayer> players);
+
+    PushStats GetStats() const;
+    std::string const& GetEndpoint() const { return _endpoint; }
+
+private:
+    enum class SendResult
+    {
+        Progress,
+        Stalled,    // the collector is not reading; lines stay queued
+        Lost
+    };
+
+    struct Record
+    {
+        uint64 Sequence;
+        std::string Line;
+    };
+
+    void Run();
+    void Encode(int64 time, std::vector<JournalPlayer> players);
+    void Enqueue(uint64 sequence, std::string line);
+    bool Connect();
+    void Disconnect(std::string const& error);
+    // Sends up to one batch of queued lines in a single write
+    SendResult SendBatch();
+
+    std::string _endpoint;
+    bool _unix;
+    std::string _host;
+    uint16 _port;
+    std::string _path;
+    uint32 _baseEvery;
+    uint64 _bufferBytes;
+    uint64 _batchBytes;
+    int64 _epoch;
+
+    // Writer thread only
+    std::unordered_map<uint32, JournalPlayer> _last;
+    uint32 _sinceBase;
+    int _socket;
+    size_t _frontOffset;    // bytes of the oldest queued line already sent
+    uint32 _reconnectMs;
+    std::chrono::steady_clock::time_point _nextConnect;
+
+    mutable std::mutex _mutex;
+    std::deque<Record> _queue;
+    uint64 _queuedBytes;
+    uint64 _nextSequence;
+    bool _forceBase;
+    PushStats _stats;
+
+    std::thread _thread;
+    std::mutex _workMutex;
+    std::condition_variable _workCondition;
+    bool _stopping;
+    bool _hasPending;
+    int64 _pendingTime;
+    std::vector<JournalPlayer> _pending;
+};
+
+#endif // GAMESTATEAPI_SNAPSHOTPUSHER_H
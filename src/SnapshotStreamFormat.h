@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_SNAPSHOTSTREAMFORMAT_H
+#define GAMESTATEAPI_SNAPSHOTSTREAMFORMAT_H
+
+#include <nlohmann/json.hpp>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Newline-delimited JSON snapshot stream, shared by the snapshot push, the
+// /api/players/stream feed, the federation client and gamestate-peer. Only
+// standard headers and nlohmann here, the tools build without AzerothCore.
+//
+// A stream starts with a "hello" line. Each generation of online players is
+// then either a "base" line with all of them or a "delta" line with the
+// players changed and the guids removed since the previous generation.
+// "seq" increases by one per generation; a delta only applies on top of
+// seq - 1. "epoch" changes whenever the sender restarts.
+namespace SnapshotStream
+{
+    constexpr uint32_t EQUIPMENT_SLOTS = 19;
+
+    // Item entry per equipment slot, in EQUIPMENT_SLOT_* order, 0 when empty
+    struct Player
+    {
+        uint32_t Guid = 0;
+        std::string Name;
+        uint8_t Level = 0;
+        uint8_t Class = 0;
+        uint8_t Race = 0;
+        uint8_t Gender = 0;
+        uint32_t Map = 0;
+        uint32_t Zone = 0;
+        uint32_t Area = 0;
+        float X = 0.0f;
+        float Y = 0.0f;
+        float Z = 0.0f;
+        uint32_t GuildId = 0;
+        std::string Guild;
+        std::array<uint32_t, EQUIPMENT_SLOTS> Equipment = {};
+
+        bool operator==(Player const& other) const = default;
+    };
+
+    using PlayerMap = std::unordered_map<uint32_t, Player>;
+
+    inline nlohmann::json PlayerToJson(Player const& player)
+    {
+        nlohmann::json data = {
+            {"guid", player.Guid},
+            {"name", player.Name},
+            {"level", player.Level},
+            {"class", player.Class},
+            {"race", player.Race},
+            {"gender", player.Gender},
+            {"map_id", player.Map},
+            {"zone_id", player.Zone},
+            {"area_id", player.Area},
+            {"position", {{"x", player.X}, {"y", player.Y}, {"z", player.Z}}},
+            {"equipment", player.Equipment}
+        };
+
+        if (player.GuildId)
+            data["guild"] = {{"id", player.GuildId}, {"name", player.Guild}};
+        else
+            data["guild"] = nullptr;
+
+        return data;
+    }
+
+    // Throws nlohmann::json::exception on a malformed player
+    inline Player PlayerFromJson(nlohmann::json const& data)
+    {
+        Player player;
+        player.Guid = data.at("guid").get<uint32_t>();
+        player.Name = data.at("name").get<std::string>();
+        player.Level = data.at("level").get<uint8_t>();
+        player.Class = data.at("class").get<uint8_t>();
+        player.Race = data.at("race").get<uint8_t>();
+        player.Gender = data.at("gender").get<uint8_t>();
+        player.Map = data.at("map_id").get<uint32_t>();
+        player.Zone = data.at("zone_id").get<uint32_t>();
+        player.Area = data.at("area_id").get<uint32_t>();
+
+        nlohmann::json const& position = data.at("position");
+        player.X = position.at("x").get<float>();
+        player.Y = position.at("y").get<float>();
+        player.Z = position.at("z").get<float>();
+
+        nlohmann::json const& guild = data.at("guild");
+        if (guild.is_object())
+        {
+            player.GuildId = guild.at("id").get<uint32_t>();
+            player.Guild = guild.at("name").get<std::string>();
+        }
+
+        nlohmann::json const& equipment = data.at("equipment");
+        for (size_t slot = 0; slot < EQUIPMENT_SLOTS && slot < equipment.size(); ++slot)
+            player.Equipment[slot] = equipment[slot].get<uint32_t>();
+
+        return player;
+    }
+
+    inline std::string Hello(int64_t epoch, uint64_t seq)
+    {
+        return nlohmann::json{ {"type", "hello"}, {"epoch", epoch}, {"seq", seq} }.dump() + "\n";
+    }
+
+    inline std::string Heartbeat(int64_t epoch, uint64_t seq)
+    {
+        return nlohmann::json{ {"type", "heartbeat"}, {"epoch", epoch}, {"seq", seq} }.dump() + "\n";
+    }
+
+    inline std::string Base(int64_t epoch, uint64_t seq, int64_t time, PlayerMap const& players)
+    {
+        nlohmann::json list = nlohmann::json::array();
+        for (auto const& [guid, player] : players)
+            list.push_back(PlayerToJson(player));
+
+        nlohmann::json record = {
+            {"type", "base"},
+            {"seq", seq},
+            {"epoch", epoch},
+            {"time", time},
+            {"players", std::move(list)}
+        };
+        return record.dump() + "\n";
+    }
+
+    inline std::string Delta(int64_t epoch, uint64_t seq, int64_t time, PlayerMap const& previous, PlayerMap const& players)
+    {
+        nlohmann::json changed = nlohmann::json::array();
+        nlohmann::json removed = nlohmann::json::array();
+        for (auto const& [guid, player] : players)
+        {
+            auto itr = previous.find(guid);
+            if (itr == previous.end() || !(itr->second == player))
+                changed.push_back(PlayerToJson(player));
+        }
+        for (auto const& [guid, player] : previous)
+            if (!players.count(guid))
+                removed.push_back(guid);
+
+        nlohmann::json record = {
+            {"type", "delta"},
+            {"seq", seq},
+            {"epoch", epoch},
+            {"time", time},
+            {"changed", std::move(changed)},
+            {"removed", std::move(removed)}
+        };
+        return record.dump() + "\n";
+    }
+
+    // Applies a parsed base or delta line to `players`
+    inline void Apply(nlohmann::json const& record, PlayerMap& players)
+    {
+        if (record.at("type") == "base")
+        {
+            players.clear();
+            for (nlohmann::json const& data : record.at("players"))
+            {
+                Player player = PlayerFromJson(data);
+                players[player.Guid] = std::move(player);
+            }
+            return;
+        }
+
+        for (nlohmann::json const& data : record.at("changed"))
+        {
+            Player player = PlayerFromJson(data);
+            players[player.Guid] = std::move(player);
+        }
+        for (nlohmann::json const& guid : record.at("removed"))
+            players.erase(guid.get<uint32_t>());
+    }
+}
+
+#endif // GAMESTATEAPI_SNAPSHOTSTREAMFORMAT_H
@@ -0,0 +1,1102 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#include "SystemMetrics.h"
+#include "AllocatorStats.h"
+#include "Log.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#endif
+
+namespace
+{
+    // smaps_rollup walks every mapping, so PSS is refreshed less often
+    constexpr uint32 PSS_SAMPLE_EVERY = 10;
+
+    std::atomic<uint32> _worldTickMaxMs{0};
+
+    // Distribution of world update diffs since startup
+    std::array<std::atomic<uint64>, LatencyHistogram::BUCKET_COUNT + 1> _worldTickBuckets{};
+    std::atomic<uint64> _worldTickSumMs{0};
+    std::atomic<uint32> _worldTickPeakMs{0};
+
+    std::mutex _threadRolesMutex;
+    std::unordered_map<uint32, std::string> _threadRoles;
+
+    // Fallback for threads that never registered, based on their comm name
+    std::string GuessThreadRole(std::string const& name)
+    {
+        static std::pair<char const*, char const*> const patterns[] =
+        {
+            { "Map", "map_updater" },
+            { "Network", "network" },
+            { "asio", "network" },
+            { "DB", "database" },
+            { "Database", "database" },
+            { "mysql", "database" },
+            { "gsapi", "api" }
+        };
+
+        for (auto const& [pattern, role] : patterns)
+        {
+            if (name.find(pattern) != std::string::npos)
+                return role;
+        }
+
+        return "other";
+    }
+
+    // Counter delta per second, 0 if the counter went backwards (device reset)
+    double Rate(uint64 current, uint64 previous, double elapsedSeconds)
+    {
+        if (current < previous || elapsedSeconds <= 0.0)
+            return 0.0;
+
+        return std::round((current - previous) / elapsedSeconds * 100.0) / 100.0;
+    }
+
+#ifndef _WIN32
+    uint32 CountOpenFds()
+    {
+        DIR* dir = opendir("/proc/self/fd");
+        if (!dir)
+            return 0;
+
+        uint32 count = 0;
+        while (struct dirent* entry = readdir(dir))
+        {
+            if (entry->d_name[0] != '.')
+                ++count;
+        }
+        closedir(dir);
+
+        // Don't count the descriptor opendir() itself is holding
+        return count > 0 ? count - 1 : 0;
+    }
+
+    uint64 ReadPssBytes()
+    {
+        std::ifstream rollup("/proc/self/smaps_rollup");
+        std::string line;
+        while (std::getline(rollup, line))
+        {
+            unsigned long long value;
+            if (sscanf(line.c_str(), "Pss: %llu kB", &value) == 1)
+                return value * 1024ULL;
+        }
+        return 0;
+    }
+
+    bool ReadFirstLine(std::string const& path, std::string& line)
+    {
+        std::ifstream file(path);
+        return file.is_open() && std::getline(file, line);
+    }
+
+    // Reads a single-value cgroup file; "max" yields 0
+    uint64 ReadCgroupValue(std::string const& path)
+    {
+        std::string line;
+        if (!ReadFirstLine(path, line) || line == "max")
+            return 0;
+
+        return std::strtoull(line.c_str(), nullptr, 10);
+    }
+
+    PressureStats ReadPressure(std::string const& path)
+    {
+        PressureStats stats;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            char kind[8] = {};
+            PressureLine parsed;
+            unsigned long long total = 0;
+            if (sscanf(line.c_str(), "%7s avg10=%lf avg60=%lf avg300=%lf total=%llu",
+                       kind, &parsed.Avg10, &parsed.Avg60, &parsed.Avg300, &total) != 5)
+                continue;
+
+            parsed.TotalUsec = total;
+            if (std::strcmp(kind, "some") == 0)
+                stats.Some = parsed;
+            else if (std::strcmp(kind, "full") == 0)
+                stats.Full = parsed;
+            stats.Available = true;
+        }
+        return stats;
+    }
+#endif
+}
+
+SystemMetricsSampler::SystemMetricsSampler(uint32 intervalMs, uint32 historySize)
+    : _intervalMs(std::max<uint32>(intervalMs, 100)), _historySize(std::max<uint32>(historySize, 1)),
+    _sampleCount(0), _stopping(false), _pressureEventHistorySize(256), _pressureEventCount(0),
+    _allocatorIntervalSeconds(0)
+{
+}
+
+SystemMetricsSampler::~SystemMetricsSampler()
+{
+    Stop();
+}
+
+void SystemMetricsSampler::RegisterCurrentThread(char const* role)
+{
+#ifndef _WIN32
+    thread_local bool registered = false;
+    if (registered)
+        return;
+
+    registered = true;
+    uint32 tid = static_cast<uint32>(syscall(SYS_gettid));
+
+    std::lock_guard<std::mutex> lock(_threadRolesMutex);
+    _threadRoles[tid] = role;
+#else
+    (void)role;
+#endif
+}
+
+void SystemMetricsSampler::RecordWorldTick(uint32 diffMs)
+{
+    uint32 previous = _worldTickMaxMs.load(std::memory_order_relaxed);
+    while (diffMs > previous && !_worldTickMaxMs.compare_exchange_weak(previous, diffMs, std::memory_order_relaxed))
+    {
+    }
+
+    // Only the world thread writes these, relaxed increments are enough
+    uint32 bucket = 0;
+    while (bucket < LatencyHistogram::BUCKET_COUNT && diffMs > LatencyHistogram::BOUNDS_MS[bucket])
+        ++bucket;
+    _worldTickBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    _worldTickSumMs.fetch_add(diffMs, std::memory_order_relaxed);
+    if (diffMs > _worldTickPeakMs.load(std::memory_order_relaxed))
+        _worldTickPeakMs.store(diffMs, std::memory_order_relaxed);
+}
+
+LatencyHistogram SystemMetricsSampler::GetWorldTickHistogram()
+{
+    LatencyHistogram histogram;
+    for (uint32 bucket = 0; bucket <= LatencyHistogram::BUCKET_COUNT; ++bucket)
+    {
+        histogram.Buckets[bucket] = _worldTickBuckets[bucket].load(std::memory_order_relaxed);
+        histogram.Count += histogram.Buckets[bucket];
+    }
+    histogram.SumMs = double(_worldTickSumMs.load(std::memory_order_relaxed));
+    histogram.MaxMs = double(_worldTickPeakMs.load(std::memory_order_relaxed));
+    return histogram;
+}
+
+void SystemMetricsSampler::SetPressureTriggers(std::string const& specs, uint32 eventHistorySize)
+{
+    _pressureTriggers.clear();
+    _pressureEventHistorySize = std::max<uint32>(eventHistorySize, 1);
+
+    std::istringstream stream(specs);
+    std::string spec;
+    while (std::getline(stream, spec, ','))
+    {
+        spec.erase(std::remove(spec.begin(), spec.end(), ' '), spec.end());
+        if (spec.empty())
+            continue;
+
+        // [host.|cgroup.]<cpu|memory|io>.<some|full>.<avg10|avg60|avg300>><threshold>
+        PressureTrigger trigger;
+        trigger.Name = spec;
+
+        std::string::size_type gt = spec.find('>');
+        std::vector<std::string> parts;
+        std::istringstream path(spec.substr(0, gt));
+        for (std::string part; std::getline(path, part, '.');)
+            parts.push_back(part);
+
+        if (!parts.empty() && (parts[0] == "host" || parts[0] == "cgroup"))
+        {
+            trigger.Cgroup = parts[0] == "cgroup";
+            parts.erase(parts.begin());
+        }
+
+        bool valid = gt != std::string::npos && parts.size() == 3;
+        if (valid)
+        {
+            if (parts[0] == "cpu")
+                trigger.Res = PressureTrigger::CPU;
+            else if (parts[0] == "memory")
+                trigger.Res = PressureTrigger::MEMORY;
+            else if (parts[0] == "io")
+                trigger.Res = PressureTrigger::IO;
+            else
+                valid = false;
+
+            if (parts[1] == "some" || parts[1] == "full")
+                trigger.Full = parts[1] == "full";
+            else
+                valid = false;
+
+            if (parts[2] == "avg10")
+                trigger.Avg = PressureTrigger::AVG10;
+            else if (parts[2] == "avg60")
+                trigger.Avg = PressureTrigger::AVG60;
+            else if (parts[2] == "avg300")
+                trigger.Avg = PressureTrigger::AVG300;
+            else
+                valid = false;
+
+            char* end = nullptr;
+            std::string threshold = spec.substr(gt + 1);
+            trigger.Threshold = std::strtod(threshold.c_str(), &end);
+            valid = valid && !threshold.empty() && *end == '\0';
+        }
+
+        if (!valid)
+        {
+            LOG_ERROR("module.gamestate_api", "Ignoring invalid PSI trigger '{}'", spec);
+            continue;
+        }
+
+        _pressureTriggers.push_back(trigger);
+    }
+}
+
+void SystemMetricsSampler::SetAllocatorSampling(uint32 intervalSeconds)
+{
+    _allocatorIntervalSeconds = intervalSeconds;
+}
+
+void SystemMetricsSampler::Start()
+{
+    if (_thread.joinable())
+        return;
+
+    _stopping = false;
+    _lastSampleTime = std::chrono::steady_clock::now();
+
+    DetectCgroup();
+
+    // Prime the deltas so the first HTTP request already sees data
+    Sample();
+
+    _thread = std::thread([this]()
+    {
+#ifndef _WIN32
+        pthread_setname_np(pthread_self(), "gsapi-sampler");
+#endif
+        RegisterCurrentThread("api");
+        Run();
+    });
+}
+
+void SystemMetricsSampler::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_stopMutex);
+        _stopping = true;
+    }
+    _stopCondition.notify_all();
+
+    if (_thread.joinable())
+        _thread.join();
+}
+
+ProcessMetrics SystemMetricsSampler::GetProcessMetrics() const
+{
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    return _process;
+}
+
+CgroupMetrics SystemMetricsSampler::GetCgroupMetrics() const
+{
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    return _cgroup;
+}
+
+HostCpuMetrics SystemMetricsSampler::GetHostCpuMetrics() const
+{
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    return _hostCpu;
+}
+
+ProcessThreadMetrics SystemMetricsSampler::GetThreadMetrics() const
+{
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    return _threads;
+}
+
+HostIoMetrics SystemMetricsSampler::GetHostIoMetrics() const
+{
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    return _hostIo;
+}
+
+PressureMetrics SystemMetricsSampler::GetPressureMetrics() const
+{
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    return _pressure;
+}
+
+std::vector<PressureTrigger> SystemMetricsSampler::GetPressureTriggers() const
+{
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    return _pressureTriggers;
+}
+
+std::vector<PressureEvent> SystemMetricsSampler::GetPressureEvents() const
+{
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    return std::vector<PressureEvent>(_pressureEvents.begin(), _pressureEvents.end());
+}
+
+uint64 SystemMetricsSampler::GetPressureEventCount() const
+{
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    return _pressureEventCount;
+}
+
+std::vector<AllocatorSample> SystemMetricsSampler::GetAllocatorHistory() const
+{
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    return std::vector<AllocatorSample>(_allocatorHistory.begin(), _allocatorHistory.end());
+}
+
+std::vector<CpuSeriesSample> SystemMetricsSampler::GetCpuHistory(uint32 maxSamples) const
+{
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    size_t count = std::min<size_t>(maxSamples, _cpuHistory.size());
+    return std::vector<CpuSeriesSample>(_cpuHistory.end() - count, _cpuHistory.end());
+}
+
+void SystemMetricsSampler::Run()
+{
+    LOG_INFO("module.gamestate_api", "Metrics sampler started ({} ms interval)", _intervalMs);
+
+    std::unique_lock<std::mutex> lock(_stopMutex);
+    while (!_stopCondition.wait_for(lock, std::chrono::milliseconds(_intervalMs), [this] { return _stopping; }))
+    {
+        lock.unlock();
+        try
+        {
+            Sample();
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR("module.gamestate_api", "Metrics sampler error: {}", e.what());
+        }
+        lock.lock();
+    }
+}
+
+void SystemMetricsSampler::Sample()
+{
+    auto now = std::chrono::steady_clock::now();
+    double elapsedSeconds = std::chrono::duration<double>(now - _lastSampleTime).count();
+    _lastSampleTime = now;
+
+    SampleProcess(elapsedSeconds);
+    SampleCgroup(elapsedSeconds);
+    SampleHostCpu();
+    SampleThreads(elapsedSeconds);
+    SampleHostIo(elapsedSeconds);
+    SamplePressure();
+    SampleAllocator();
+
+    ++_sampleCount;
+}
+
+void SystemMetricsSampler::SampleProcess(double elapsedSeconds)
+{
+    ProcessMetrics metrics;
+    metrics.Timestamp = std::time(nullptr);
+
+    uint32 cpuCount = std::max(1u, std::thread::hardware_concurrency());
+
+#ifdef _WIN32
+    HANDLE process = GetCurrentProcess();
+
+    PROCESS_MEMORY_COUNTERS_EX memCounters;
+    if (GetProcessMemoryInfo(process, reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&memCounters), sizeof(memCounters)))
+    {
+        metrics.RssBytes = memCounters.WorkingSetSize;
+        metrics.PssBytes = memCounters.PrivateUsage;
+        metrics.VirtualBytes = memCounters.PagefileUsage;
+        metrics.MinorFaults = memCounters.PageFaultCount;
+    }
+
+    DWORD handleCount = 0;
+    if (GetProcessHandleCount(process, &handleCount))
+        metrics.OpenFds = handleCount;
+
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (GetProcessTimes(process, &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+        // FILETIME is in 100ns units
+        metrics.UserSeconds = ((((ULONGLONG)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime)) / 1e7;
+        metrics.SystemSeconds = ((((ULONGLONG)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime)) / 1e7;
+    }
+#else
+    // /proc/self/stat: the command name may contain spaces, parse after the ')'
+    {
+        std::ifstream statFile("/proc/self/stat");
+        std::string stat;
+        std::getline(statFile, stat);
+
+        std::string::size_type commEnd = stat.rfind(')');
+        if (commEnd != std::string::npos)
+        {
+            unsigned long minflt = 0, majflt = 0, utime = 0, stime = 0, vsize = 0;
+            long threads = 0, rssPages = 0;
+
+            // Fields 3..24 of proc(5)
+            if (sscanf(stat.c_str() + commEnd + 1,
+                       " %*c %*d %*d %*d %*d %*d %*u %lu %*u %lu %*u %lu %lu %*d %*d %*d %*d %ld %*d %*u %lu %ld",
+                       &minflt, &majflt, &utime, &stime, &threads, &vsize, &rssPages) == 7)
+            {
+                static long const ticksPerSecond = sysconf(_SC_CLK_TCK);
+                static long const pageSize = sysconf(_SC_PAGESIZE);
+
+                metrics.MinorFaults = minflt;
+                metrics.MajorFaults = majflt;
+                metrics.UserSeconds = double(utime) / ticksPerSecond;
+                metrics.SystemSeconds = double(stime) / ticksPerSecond;
+                metrics.Threads = static_cast<uint32>(threads);
+                metrics.VirtualBytes = vsize;
+                metrics.RssBytes = uint64(rssPages) * pageSize;
+            }
+        }
+    }
+
+    {
+        std::ifstream statusFile("/proc/self/status");
+        std::string line;
+        while (std::getline(statusFile, line))
+        {
+            unsigned long long value;
+            if (sscanf(line.c_str(), "voluntary_ctxt_switches: %llu", &value) == 1)
+                metrics.VoluntaryCtxSwitches = value;
+            else if (sscanf(line.c_str(), "nonvoluntary_ctxt_switches: %llu", &value) == 1)
+                metrics.InvoluntaryCtxSwitches = value;
+        }
+    }
+
+    metrics.OpenFds = CountOpenFds();
+
+    bool refreshPss = _sampleCount % PSS_SAMPLE_EVERY == 0;
+    if (refreshPss)
+        metrics.PssBytes = ReadPssBytes();
+#endif
+
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+
+#ifndef _WIN32
+    if (!refreshPss)
+        metrics.PssBytes = _process.PssBytes;
+#endif
+
+    double previousCpuSeconds = _process.UserSeconds + _process.SystemSeconds;
+    double cpuSeconds = metrics.UserSeconds + metrics.SystemSeconds;
+    if (_sampleCount > 0 && elapsedSeconds > 0.0 && cpuSeconds >= previousCpuSeconds)
+    {
+        metrics.CpuPercent = std::round((cpuSeconds - previousCpuSeconds) / elapsedSeconds * 10000.0) / 100.0;
+        metrics.CpuPercentOfHost = std::round(metrics.CpuPercent / cpuCount * 100.0) / 100.0;
+    }
+
+    _process = metrics;
+}
+
+void SystemMetricsSampler::DetectCgroup()
+{
+    _cgroupDir.clear();
+
+#ifndef _WIN32
+    // cgroup v2 has a single "0::<path>" entry; hybrid and v1 setups are ignored
+    std::ifstream cgroupFile("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(cgroupFile, line))
+    {
+        if (line.compare(0, 3, "0::") != 0)
+            continue;
+
+        std::string dir = "/sys/fs/cgroup" + line.substr(3);
+        if (!dir.empty() && dir.back() == '/')
+            dir.pop_back();
+
+        // The root cgroup has no memory.current, so we are not limited by one
+        std::string probe;
+        if (ReadFirstLine(dir + "/memory.current", probe))
+        {
+            _cgroupDir = dir;
+            LOG_INFO("module.gamestate_api", "Detected cgroup v2 at {}", _cgroupDir);
+        }
+        break;
+    }
+#endif
+}
+
+void SystemMetricsSampler::SampleCgroup(double elapsedSeconds)
+{
+    if (_cgroupDir.empty())
+        return;
+
+#ifndef _WIN32
+    CgroupMetrics metrics;
+    metrics.Available = true;
+    metrics.Path = _cgroupDir;
+
+    metrics.MemoryCurrent = ReadCgroupValue(_cgroupDir + "/memory.current");
+    metrics.MemoryMax = ReadCgroupValue(_cgroupDir + "/memory.max");
+    metrics.MemoryPressure = ReadPressure(_cgroupDir + "/memory.pressure");
+
+    {
+        std::ifstream memStat(_cgroupDir + "/memory.stat");
+        std::string line;
+        while (std::getline(memStat, line))
+        {
+            unsigned long long value;
+            if (sscanf(line.c_str(), "inactive_file %llu", &value) == 1)
+            {
+                metrics.MemoryInactiveFile = value;
+                break;
+            }
+        }
+    }
+
+    {
+        std::ifstream cpuStat(_cgroupDir + "/cpu.stat");
+        std::string line;
+        while (std::getline(cpuStat, line))
+        {
+            unsigned long long value;
+            if (sscanf(line.c_str(), "usage_usec %llu", &value) == 1)
+                metrics.CpuUsageUsec = value;
+            else if (sscanf(line.c_str(), "user_usec %llu", &value) == 1)
+                metrics.CpuUserUsec = value;
+            else if (sscanf(line.c_str(), "system_usec %llu", &value) == 1)
+                metrics.CpuSystemUsec = value;
+            else if (sscanf(line.c_str(), "nr_periods %llu", &value) == 1)
+                metrics.NrPeriods = value;
+            else if (sscanf(line.c_str(), "nr_throttled %llu", &value) == 1)
+                metrics.NrThrottled = value;
+            else if (sscanf(line.c_str(), "throttled_usec %llu", &value) == 1)
+                metrics.ThrottledUsec = value;
+        }
+    }
+
+    // cpu.max is "<quota> <period>" or "max <period>"
+    std::string cpuMax;
+    if (ReadFirstLine(_cgroupDir + "/cpu.max", cpuMax))
+    {
+        unsigned long long quota = 0, period = 0;
+        if (sscanf(cpuMax.c_str(), "%llu %llu", &quota, &period) == 2 && period > 0)
+            metrics.CpuQuota = double(quota) / double(period);
+    }
+
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+
+    if (_cgroup.Available && elapsedSeconds > 0.0)
+    {
+        double capacity = metrics.HasCpuLimit() ? metrics.CpuQuota : std::max(1u, std::thread::hardware_concurrency());
+        if (metrics.CpuUsageUsec >= _cgroup.CpuUsageUsec)
+        {
+            double usedSeconds = (metrics.CpuUsageUsec - _cgroup.CpuUsageUsec) / 1e6;
+            metrics.CpuPercent = std::round(usedSeconds / (elapsedSeconds * capacity) * 10000.0) / 100.0;
+        }
+
+        if (metrics.NrPeriods > _cgroup.NrPeriods && metrics.NrThrottled >= _cgroup.NrThrottled)
+        {
+            double periods = double(metrics.NrPeriods - _cgroup.NrPeriods);
+            metrics.ThrottledPercent = std::round((metrics.NrThrottled - _cgroup.NrThrottled) / periods * 10000.0) / 100.0;
+        }
+    }
+
+    _cgroup = metrics;
+#else
+    (void)elapsedSeconds;
+#endif
+}
+
+CpuUtilization SystemMetricsSampler::ComputeUtilization(CpuTimes const& previous, CpuTimes const& current)
+{
+    CpuUtilization util;
+    if (!previous.Present || current.Sum() <= previous.Sum())
+        return util;
+
+    double total = double(current.Sum() - previous.Sum());
+    auto percent = [total](uint64 now, uint64 before)
+    {
+        return now >= before ? std::round((now - before) / total * 10000.0) / 100.0 : 0.0;
+    };
+
+    util.User = percent(current.User, previous.User);
+    util.Nice = percent(current.Nice, previous.Nice);
+    util.System = percent(current.System, previous.System);
+    util.Idle = percent(current.Idle, previous.Idle);
+    util.Iowait = percent(current.Iowait, previous.Iowait);
+    util.Irq = percent(current.Irq, previous.Irq);
+    util.Softirq = percent(current.Softirq, previous.Softirq);
+    util.Steal = percent(current.Steal, previous.Steal);
+    util.Busy = std::max(0.0, std::round((100.0 - util.Idle - util.Iowait) * 100.0) / 100.0);
+    return util;
+}
+
+void SystemMetricsSampler::SampleHostCpu()
+{
+#ifndef _WIN32
+    std::ifstream statFile("/proc/stat");
+    if (!statFile.is_open())
+        return;
+
+    CpuTimes total;
+    std::vector<CpuTimes> cores;
+
+    std::string line;
+    while (std::getline(statFile, line))
+    {
+        // cpu lines come first, stop at the first other line
+        if (line.compare(0, 3, "cpu") != 0)
+            break;
+
+        CpuTimes times;
+        unsigned long long user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+        char const* values = line.c_str() + line.find(' ');
+        if (sscanf(values, " %llu %llu %llu %llu %llu %llu %llu %llu",
+                   &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal) < 4)
+            continue;
+
+        times.Present = true;
+        times.User = user;
+        times.Nice = nice;
+        times.System = system;
+        times.Idle = idle;
+        times.Iowait = iowait;
+        times.Irq = irq;
+        times.Softirq = softirq;
+        times.Steal = steal;
+
+        if (line[3] == ' ')
+        {
+            total = times;
+        }
+        else
+        {
+            uint32 id = static_cast<uint32>(std::strtoul(line.c_str() + 3, nullptr, 10));
+            if (id >= cores.size())
+                cores.resize(id + 1);
+            cores[id] = times;
+        }
+    }
+
+    HostCpuMetrics metrics;
+    metrics.Available = total.Present;
+    metrics.Timestamp = std::time(nullptr);
+    metrics.Total = ComputeUtilization(_prevCpuTotal, total);
+
+    CpuSeriesSample point;
+    point.Timestamp = metrics.Timestamp;
+    point.TotalBusy = static_cast<float>(metrics.Total.Busy);
+    point.TotalSteal = static_cast<float>(metrics.Total.Steal);
+    point.TotalIowait = static_cast<float>(metrics.Total.Iowait);
+
+    for (uint32 id = 0; id < cores.size(); ++id)
+    {
+        // Offline CPUs have no line
+        if (!cores[id].Present)
+            continue;
+
+        CpuUtilization util = id < _prevCpuCores.size() ? ComputeUtilization(_prevCpuCores[id], cores[id]) : CpuUtilization();
+        metrics.CoreIds.push_back(id);
+        metrics.Cores.push_back(util);
+        point.Busy.push_back(static_cast<float>(util.Busy));
+        point.Steal.push_back(static_cast<float>(util.Steal));
+        point.Iowait.push_back(static_cast<float>(util.Iowait));
+    }
+
+    bool hadPrevious = _prevCpuTotal.Present;
+    _prevCpuTotal = total;
+    _prevCpuCores = std::move(cores);
+
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    _hostCpu = std::move(metrics);
+
+    // The first sample has nothing to diff against
+    if (hadPrevious)
+    {
+        _cpuHistory.push_back(std::move(point));
+        while (_cpuHistory.size() > _historySize)
+            _cpuHistory.pop_front();
+    }
+#endif
+}
+
+void SystemMetricsSampler::SampleThreads(double elapsedSeconds)
+{
+#ifndef _WIN32
+    DIR* taskDir = opendir("/proc/self/task");
+    if (!taskDir)
+        return;
+
+    std::vector<uint32> tids;
+    while (struct dirent* entry = readdir(taskDir))
+    {
+        if (entry->d_name[0] != '.')
+            tids.push_back(static_cast<uint32>(std::strtoul(entry->d_name, nullptr, 10)));
+    }
+    closedir(taskDir);
+
+    std::unordered_map<uint32, std::string> roles;
+    {
+        std::lock_guard<std::mutex> lock(_threadRolesMutex);
+
+        // Forget registrations of threads that have exited
+        for (auto itr = _threadRoles.begin(); itr != _threadRoles.end();)
+        {
+            if (std::find(tids.begin(), tids.end(), itr->first) == tids.end())
+                itr = _threadRoles.erase(itr);
+            else
+                ++itr;
+        }
+        roles = _threadRoles;
+    }
+
+    static long const ticksPerSecond = sysconf(_SC_CLK_TCK);
+    uint32 const pid = static_cast<uint32>(getpid());
+
+    ProcessThreadMetrics metrics;
+    metrics.Available = true;
+    metrics.Timestamp = std::time(nullptr);
+
+    std::unordered_map<uint32, ThreadCounters> counters;
+    std::unordered_map<std::string, ThreadRoleMetrics> roleTotals;
+
+    for (uint32 tid : tids)
+    {
+        std::string const taskPath = "/proc/self/task/" + std::to_string(tid);
+
+        std::string stat;
+        if (!ReadFirstLine(taskPath + "/stat", stat))
+            continue; // exited since readdir
+
+        std::string::size_type commStart = stat.find('(');
+        std::string::size_type commEnd = stat.rfind(')');
+        if (commStart == std::string::npos || commEnd == std::string::npos)
+            continue;
+
+        unsigned long utime = 0, stime = 0;
+        if (sscanf(stat.c_str() + commEnd + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2)
+            continue;
+
+        ThreadCounters current;
+        current.CpuTicks = utime + stime;
+
+        std::ifstream statusFile(taskPath + "/status");
+        std::string line;
+        while (std::getline(statusFile, line))
+        {
+            unsigned long long value;
+            if (sscanf(line.c_str(), "voluntary_ctxt_switches: %llu", &value) == 1)
+                current.VoluntaryCtxSwitches = value;
+            else if (sscanf(line.c_str(), "nonvoluntary_ctxt_switches: %llu", &value) == 1)
+                current.InvoluntaryCtxSwitches = value;
+        }
+
+        ThreadMetrics thread;
+        thread.Tid = tid;
+        thread.Name = stat.substr(commStart + 1, commEnd - commStart - 1);
+        thread.UserSeconds = double(utime) / ticksPerSecond;
+        thread.SystemSeconds = double(stime) / ticksPerSecond;
+
+        auto roleItr = roles.find(tid);
+        if (roleItr != roles.end())
+            thread.Role = roleItr->second;
+        else if (tid == pid)
+            thread.Role = "main";
+        else
+            thread.Role = GuessThreadRole(thread.Name);
+
+        auto prevItr = _prevThreads.find(tid);
+        if (prevItr != _prevThreads.end() && elapsedSeconds > 0.0)
+        {
+            ThreadCounters const& previous = prevItr->second;
+            if (current.CpuTicks >= previous.CpuTicks)
+                thread.CpuPercent = std::round((current.CpuTicks - previous.CpuTicks) / double(ticksPerSecond) / elapsedSeconds * 10000.0) / 100.0;
+            if (current.VoluntaryCtxSwitches >= previous.VoluntaryCtxSwitches)
+                thread.VoluntaryCtxSwitchesPerSec = std::round((current.VoluntaryCtxSwitches - previous.VoluntaryCtxSwitches) / elapsedSeconds * 10.0) / 10.0;
+            if (current.InvoluntaryCtxSwitches >= previous.InvoluntaryCtxSwitches)
+                thread.InvoluntaryCtxSwitchesPerSec = std::round((current.InvoluntaryCtxSwitches - previous.InvoluntaryCtxSwitches) / elapsedSeconds * 10.0) / 10.0;
+        }
+
+        ThreadRoleMetrics& role = roleTotals[thread.Role];
+        role.Role = thread.Role;
+        role.Threads++;
+        role.CpuPercent += thread.CpuPercent;
+        role.VoluntaryCtxSwitchesPerSec += thread.VoluntaryCtxSwitchesPerSec;
+        role.InvoluntaryCtxSwitchesPerSec += thread.InvoluntaryCtxSwitchesPerSec;
+
+        counters[tid] = current;
+        metrics.Threads.push_back(std::move(thread));
+    }
+
+    _prevThreads = std::move(counters);
+
+    for (auto& [name, role] : roleTotals)
+    {
+        role.CpuPercent = std::round(role.CpuPercent * 100.0) / 100.0;
+        metrics.Roles.push_back(std::move(role));
+    }
+
+    std::sort(metrics.Threads.begin(), metrics.Threads.end(),
+        [](ThreadMetrics const& a, ThreadMetrics const& b) { return a.CpuPercent > b.CpuPercent; });
+    std::sort(metrics.Roles.begin(), metrics.Roles.end(),
+        [](ThreadRoleMetrics const& a, ThreadRoleMetrics const& b) { return a.CpuPercent > b.CpuPercent; });
+
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    _threads = std::move(metrics);
+#else
+    (void)elapsedSeconds;
+#endif
+}
+
+void SystemMetricsSampler::SampleHostIo(double elapsedSeconds)
+{
+#ifndef _WIN32
+    HostIoMetrics metrics;
+    metrics.Available = true;
+    metrics.Timestamp = std::time(nullptr);
+
+    std::unordered_map<std::string, DiskCounters> disks;
+    {
+        std::ifstream diskStats("/proc/diskstats");
+        std::string line;
+        while (std::getline(diskStats, line))
+        {
+            char name[64] = {};
+            unsigned long long reads, readSectors, readMs, writes, writeSectors, writeMs, inFlight, ioTicks;
+            if (sscanf(line.c_str(), " %*u %*u %63s %llu %*u %llu %llu %llu %*u %llu %llu %llu %llu",
+                       name, &reads, &readSectors, &readMs, &writes, &writeSectors, &writeMs, &inFlight, &ioTicks) != 9)
+                continue;
+
+            // Whole disks only (partitions are not in /sys/block), and no loop/ram devices
+            std::string device = name;
+            if (device.compare(0, 4, "loop") == 0 || device.compare(0, 3, "ram") == 0)
+                continue;
+
+            if (access(("/sys/block/" + device).c_str(), F_OK) != 0)
+                continue;
+
+            DiskCounters current;
+            current.Reads = reads;
+            current.ReadSectors = readSectors;
+            current.ReadMs = readMs;
+            current.Writes = writes;
+            current.WriteSectors = writeSectors;
+            current.WriteMs = writeMs;
+            current.IoTicksMs = ioTicks;
+
+            DiskMetrics disk;
+            disk.Device = device;
+            disk.InFlight = inFlight;
+
+            auto prevItr = _prevDisks.find(device);
+            if (prevItr != _prevDisks.end())
+            {
+                DiskCounters const& previous = prevItr->second;
+
+                // diskstats sectors are always 512 bytes
+                disk.ReadIops = Rate(current.Reads, previous.Reads, elapsedSeconds);
+                disk.WriteIops = Rate(current.Writes, previous.Writes, elapsedSeconds);
+                disk.ReadBytesPerSec = Rate(current.ReadSectors * 512, previous.ReadSectors * 512, elapsedSeconds);
+                disk.WriteBytesPerSec = Rate(current.WriteSectors * 512, previous.WriteSectors * 512, elapsedSeconds);
+                disk.UtilizationPercent = std::min(100.0, Rate(current.IoTicksMs, previous.IoTicksMs, elapsedSeconds) / 10.0);
+
+                uint64 ios = (current.Reads + current.Writes) - (previous.Reads + previous.Writes);
+                uint64 ioMs = (current.ReadMs + current.WriteMs) - (previous.ReadMs + previous.WriteMs);
+                if (ios > 0 && current.Reads >= previous.Reads && current.Writes >= previous.Writes)
+                    disk.AwaitMs = std::round(double(ioMs) / ios * 100.0) / 100.0;
+            }
+
+            disks[device] = current;
+            metrics.Disks.push_back(std::move(disk));
+        }
+    }
+
+    std::unordered_map<std::string, NetCounters> interfaces;
+    {
+        std::ifstream netDev("/proc/net/dev");
+        std::string line;
+        while (std::getline(netDev, line))
+        {
+            // Two header lines, then "<iface>: <counters>"
+            std::string::size_type colon = line.find(':');
+            if (colon == std::string::npos)
+                continue;
+
+            std::string name = line.substr(0, colon);
+            name.erase(0, name.find_first_not_of(' '));
+
+            NetCounters current;
+            unsigned long long rxBytes, rxPackets, rxErrors, rxDrops, txBytes, txPackets, txErrors, txDrops;
+            if (sscanf(line.c_str() + colon + 1, " %llu %llu %llu %llu %*u %*u %*u %*u %llu %llu %llu %llu",
+                       &rxBytes, &rxPackets, &rxErrors, &rxDrops, &txBytes, &txPackets, &txErrors, &txDrops) != 8)
+                continue;
+
+            current.RxBytes = rxBytes;
+            current.RxPackets = rxPackets;
+            current.RxErrors = rxErrors;
+            current.RxDrops = rxDrops;
+            current.TxBytes = txBytes;
+            current.TxPackets = txPackets;
+            current.TxErrors = txErrors;
+            current.TxDrops = txDrops;
+
+            NetInterfaceMetrics iface;
+            iface.Interface = name;
+            iface.RxDrops = rxDrops;
+            iface.TxDrops = txDrops;
+            iface.RxErrors = rxErrors;
+            iface.TxErrors = txErrors;
+
+            auto prevItr = _prevInterfaces.find(name);
+            if (prevItr != _prevInterfaces.end())
+            {
+                NetCounters const& previous = prevItr->second;
+                iface.RxBytesPerSec = Rate(current.RxBytes, previous.RxBytes, elapsedSeconds);
+                iface.TxBytesPerSec = Rate(current.TxBytes, previous.TxBytes, elapsedSeconds);
+                iface.RxPacketsPerSec = Rate(current.RxPackets, previous.RxPackets, elapsedSeconds);
+                iface.TxPacketsPerSec = Rate(current.TxPackets, previous.TxPackets, elapsedSeconds);
+                iface.RxDropsPerSec = Rate(current.RxDrops, previous.RxDrops, elapsedSeconds);
+                iface.TxDropsPerSec = Rate(current.TxDrops, previous.TxDrops, elapsedSeconds);
+            }
+
+            interfaces[name] = current;
+            metrics.Interfaces.push_back(std::move(iface));
+        }
+    }
+
+    _prevDisks = std::move(disks);
+    _prevInterfaces = std::move(interfaces);
+
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    _hostIo = std::move(metrics);
+#else
+    (void)elapsedSeconds;
+#endif
+}
+
+void SystemMetricsSampler::SamplePressure()
+{
+    PressureMetrics metrics;
+    metrics.Timestamp = std::time(nullptr);
+    metrics.WorldTickMaxMs = _worldTickMaxMs.exchange(0, std::memory_order_relaxed);
+
+#ifndef _WIN32
+    metrics.HostCpu = ReadPressure("/proc/pressure/cpu");
+    metrics.HostMemory = ReadPressure("/proc/pressure/memory");
+    metrics.HostIo = ReadPressure("/proc/pressure/io");
+
+    if (!_cgroupDir.empty())
+    {
+        metrics.CgroupCpu = ReadPressure(_cgroupDir + "/cpu.pressure");
+        metrics.CgroupMemory = ReadPressure(_cgroupDir + "/memory.pressure");
+        metrics.CgroupIo = ReadPressure(_cgroupDir + "/io.pressure");
+    }
+#endif
+
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    _pressure = metrics;
+
+    for (PressureTrigger& trigger : _pressureTriggers)
+    {
+        PressureStats const* stats = nullptr;
+        switch (trigger.Res)
+        {
+            case PressureTrigger::CPU:
+                stats = trigger.Cgroup ? &metrics.CgroupCpu : &metrics.HostCpu;
+                break;
+            case PressureTrigger::MEMORY:
+                stats = trigger.Cgroup ? &metrics.CgroupMemory : &metrics.HostMemory;
+                break;
+            case PressureTrigger::IO:
+                stats = trigger.Cgroup ? &metrics.CgroupIo : &metrics.HostIo;
+                break;
+        }
+
+        if (!stats->Available)
+            continue;
+
+        PressureLine const& line = trigger.Full ? stats->Full : stats->Some;
+        double value = trigger.Avg == PressureTrigger::AVG10 ? line.Avg10 :
+                       trigger.Avg == PressureTrigger::AVG60 ? line.Avg60 : line.Avg300;
+
+        bool above = value > trigger.Threshold;
+        if (above == trigger.Active)
+            continue;
+
+        PressureEvent event;
+        event.Timestamp = metrics.Timestamp;
+        event.Trigger = trigger.Name;
+        event.Rising = above;
+        event.Value = value;
+        event.Threshold = trigger.Threshold;
+        event.WorldTickMaxMs = metrics.WorldTickMaxMs;
+        if (!above)
+            event.DurationSeconds = static_cast<uint32>(metrics.Timestamp - trigger.ActiveSince);
+
+        trigger.Active = above;
+        trigger.ActiveSince = metrics.Timestamp;
+
+        if (above)
+        {
+            LOG_WARN("module.gamestate_api", "PSI trigger {} fired: {:.2f} (slowest world tick {} ms)",
+                trigger.Name, value, metrics.WorldTickMaxMs);
+        }
+
+        _pressureEvents.push_back(std::move(event));
+        ++_pressureEventCount;
+        while (_pressureEvents.size() > _pressureEventHistorySize)
+            _pressureEvents.pop_front();
+    }
+}
+
+void SystemMetricsSampler::SampleAllocator()
+{
+    if (!_allocatorIntervalSeconds)
+        return;
+
+    auto now = std::chrono::steady_clock::now();
+    if (_sampleCount > 0 && now - _lastAllocatorSample < std::chrono::seconds(_allocatorIntervalSeconds))
+        return;
+
+    _lastAllocatorSample = now;
+
+    AllocatorMetrics metrics = AllocatorStats::Collect();
+    if (!metrics.Available)
+        return;
+
+    AllocatorSample sample;
+    sample.Timestamp = metrics.Timestamp;
+    sample.InUseBytes = metrics.InUseBytes;
+    sample.FreeBytes = metrics.FreeBytes;
+    sample.ArenaBytes = metrics.ArenaBytes;
+    sample.MmapBytes = metrics.MmapBytes;
+
+    std::lock_guard<std::mutex> lock(_metricsMutex);
+    _allocatorHistory.push_back(sample);
+    while (_allocatorHistory.size() > _historySize)
+        _allocatorHistory.pop_front();
+}
@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE-AGPL3
+ */
+
+#ifndef GAMESTATEAPI_SYSTEMMETRICS_H
+#define GAMESTATEAPI_SYSTEMMETRICS_H
+
+#include "Define.h"
+#include "LatencyHistogram.h"
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// One line of a PSI file ("some" or "full")
+struct PressureLine
+{
+    double Avg10 = 0.0;
+    double Avg60 = 0.0;
+    double Avg300 = 0.0;
+    uint64 TotalUsec = 0;
+};
+
+// Contents of a Linux pressure-stall file (/proc/pressure/* or <cgroup>/*.pressure)
+struct PressureStats
+{
+    bool Available = false;
+    PressureLine Some;
+    PressureLine Full;
+};
+
+// Resource usage of the worldserver process itself
+struct ProcessMetrics
+{
+    time_t Timestamp = 0;
+    uint64 RssBytes = 0;
+    uint64 PssBytes = 0;
+    uint64 VirtualBytes = 0;
+    uint32 Threads = 0;
+    uint32 OpenFds = 0;
+    uint64 VoluntaryCtxSwitches = 0;
+    uint64 InvoluntaryCtxSwitches = 0;
+    uint64 MinorFaults = 0;
+    uint64 MajorFaults = 0;
+    double UserSeconds = 0.0;
+    double SystemSeconds = 0.0;
+    double CpuPercent = 0.0;        // 100 = one core fully busy
+    double CpuPercentOfHost = 0.0;  // 100 = every core fully busy
+};
+
+// Pressure of the host (/proc/pressure/*) and of our cgroup (<cgroup>/*.pressure)
+struct PressureMetrics
+{
+    time_t Timestamp = 0;
+    PressureStats HostCpu;
+    PressureStats HostMemory;
+    PressureStats HostIo;
+    PressureStats CgroupCpu;
+    PressureStats CgroupMemory;
+    PressureStats CgroupIo;
+    uint32 WorldTickMaxMs = 0;  // slowest world tick during the last interval
+};
+
+// Threshold on one PSI average, parsed from e.g. "cgroup.memory.full.avg10>5"
+struct PressureTrigger
+{
+    enum Resource : uint8 { CPU, MEMORY, IO };
+    enum Window : uint8 { AVG10, AVG60, AVG300 };
+
+    std::string Name;
+    bool Cgroup = false;
+    Resource Res = CPU;
+    bool Full = false;
+    Window Avg = AVG10;
+    double Threshold = 0.0;
+
+    bool Active = false;
+    time_t ActiveSince = 0;
+};
+
+// Recorded whenever a trigger crosses its threshold in either direction
+struct PressureEvent
+{
+    time_t Timestamp = 0;
+    std::string Trigger;
+    bool Rising = true;
+    double Value = 0.0;
+    double Threshold = 0.0;
+    uint32 WorldTickMaxMs = 0;
+    uint32 DurationSeconds = 0; // how long the trigger was active, on falling events
+};
+
+// One point of the allocator history, see AllocatorStats
+struct AllocatorSample
+{
+    time_t Timestamp = 0;
+    uint64 InUseBytes = 0;
+    uint64 FreeBytes = 0;
+    uint64 ArenaBytes = 0;
+    uint64 MmapBytes = 0;
+};
+
+// Share of one CPU (or of all CPUs for the aggregate) spent in each state
+// over the last sample interval, in percent
+struct CpuUtilization
+{
+    double Busy = 0.0;      // everything except idle and iowait
+    double User = 0.0;
+    double Nice = 0.0;
+    double System = 0.0;
+    double Idle = 0.0;
+    double Iowait = 0.0;
+    double Irq = 0.0;
+    double Softirq = 0.0;
+    double Steal = 0.0;
+};
+
+// Host CPU breakdown from /proc/stat, aggregate plus one entry per cpuN line
+struct HostCpuMetrics
+{
+    bool Available = false;
+    time_t Timestamp = 0;
+    CpuUtilization Total;
+    std::vector<uint32> CoreIds;
+    std::vector<CpuUtilization> Cores;
+};
+
+// One point of the per-core history kept by the sampler
+struct CpuSeriesSample
+{
+    time_t Timestamp = 0;
+    float TotalBusy = 0.0f;
+    float TotalSteal = 0.0f;
+    float TotalIowait = 0.0f;
+    std::vector<float> Busy;
+    std::vector<float> Steal;
+    std::vector<float> Iowait;
+};
+
+// CPU and scheduling activity of one worldserver thread over the last interval
+struct ThreadMetrics
+{
+    uint32 Tid = 0;
+    std::string Name;
+    std::string Role;
+    double CpuPercent = 0.0;        // 100 = one core fully busy
+    double UserSeconds = 0.0;
+    double SystemSeconds = 0.0;
+    double VoluntaryCtxSwitchesPerSec = 0.0;
+    double InvoluntaryCtxSwitchesPerSec = 0.0;
+};
+
+// ThreadMetrics summed over every thread sharing a role
+struct ThreadRoleMetrics
+{
+    std::string Role;
+    uint32 Threads = 0;
+    double CpuPercent = 0.0;
+    double VoluntaryCtxSwitchesPerSec = 0.0;
+    double InvoluntaryCtxSwitchesPerSec = 0.0;
+};
+
+struct ProcessThreadMetrics
+{
+    bool Available = false;
+    time_t Timestamp = 0;
+    std::vector<ThreadMetrics> Threads;     // busiest first
+    std::vector<ThreadRoleMetrics> Roles;   // busiest first
+};
+
+// Throughput of one block device over the last interval (/proc/diskstats)
+struct DiskMetrics
+{
+    std::string Device;
+    double ReadIops = 0.0;
+    double WriteIops = 0.0;
+    double ReadBytesPerSec = 0.0;
+    double WriteBytesPerSec = 0.0;
+    double AwaitMs = 0.0;               // average time per completed I/O
+    double UtilizationPercent = 0.0;    // share of the interval with I/O in flight
+    uint64 InFlight = 0;
+};
+
+// Throughput of one network interface over the last interval (/proc/net/dev)
+struct NetInterfaceMetrics
+{
+    std::string Interface;
+    double RxBytesPerSec = 0.0;
+    double TxBytesPerSec = 0.0;
+    double RxPacketsPerSec = 0.0;
+    double TxPacketsPerSec = 0.0;
+    double RxDropsPerSec = 0.0;
+    double TxDropsPerSec = 0.0;
+    uint64 RxDrops = 0;
+    uint64 TxDrops = 0;
+    uint64 RxErrors = 0;
+    uint64 TxErrors = 0;
+};
+
+struct HostIoMetrics
+{
+    bool Available = false;
+    time_t Timestamp = 0;
+    std::vector<DiskMetrics> Disks;
+    std::vector<NetInterfaceMetrics> Interfaces;
+};
+
+// Limits and usage of the cgroup v2 the worldserver runs in
+struct CgroupMetrics
+{
+    bool Available = false;
+    std::string Path;
+
+    uint64 MemoryCurrent = 0;
+    uint64 MemoryMax = 0;           // 0 = unlimited
+    uint64 MemoryInactiveFile = 0;
+    PressureStats MemoryPressure;
+
+    uint64 CpuUsageUsec = 0;
+    uint64 CpuUserUsec = 0;
+    uint64 CpuSystemUsec = 0;
+    uint64 NrPeriods = 0;
+    uint64 NrThrottled = 0;
+    uint64 ThrottledUsec = 0;
+    double CpuQuota = 0.0;          // effective CPUs from cpu.max, 0 = unlimited
+    double CpuPercent = 0.0;        // 100 = the whole quota (or every core when unlimited)
+    double ThrottledPercent = 0.0;  // share of periods throttled during the last interval
+
+    bool HasMemoryLimit() const { return MemoryMax > 0; }
+    bool HasCpuLimit() const { return CpuQuota > 0.0; }
+    uint64 WorkingSet() const { return MemoryCurrent > MemoryInactiveFile ? MemoryCurrent - MemoryInactiveFile : 0; }
+};
+
+// Background thread that periodically samples /proc (or the Win32 equivalents)
+// so HTTP handlers only ever read the last sample under a lock.
+class SystemMetricsSampler
+{
+public:
+    SystemMetricsSampler(uint32 intervalMs, uint32 historySize);
+    ~SystemMetricsSampler();
+
+    void Start();
+    void Stop();
+
+    // Tag the calling thread with a role ("world", "api", ...) for /api/process/threads.
+    // Cheap after the first call on a given thread.
+    static void RegisterCurrentThread(char const* role);
+
+    // Called from the world thread every tick, correlated with pressure events
+    static void RecordWorldTick(uint32 diffMs);
+
+    // World update diffs since startup
+    static LatencyHistogram GetWorldTickHistogram();
+
+    // Comma separated trigger specs, see PressureTrigger. Call before Start().
+    void SetPressureTriggers(std::string const& specs, uint32 eventHistorySize);
+
+    // Record allocator statistics every `intervalSeconds` (0 = never). Call before Start().
+    void SetAllocatorSampling(uint32 intervalSeconds);
+
+    uint32 GetIntervalMs() const { return _intervalMs; }
+    ProcessMetrics GetProcessMetrics() const;
+    CgroupMetrics GetCgroupMetrics() const;
+    HostCpuMetrics GetHostCpuMetrics() const;
+    ProcessThreadMetrics GetThreadMetrics() const;
+    HostIoMetrics GetHostIoMetrics() const;
+    PressureMetrics GetPressureMetrics() const;
+    std::vector<PressureTrigger> GetPressureTriggers() const;
+    std::vector<PressureEvent> GetPressureEvents() const;
+    uint64 GetPressureEventCount() const;
+    std::vector<AllocatorSample> GetAllocatorHistory() const;
+    uint32 GetAllocatorIntervalSeconds() const { return _allocatorIntervalSeconds; }
+
+    // Up to `maxSamples` most recent per-core samples, oldest first
+    std::vector<CpuSeriesSample> GetCpuHistory(uint32 maxSamples) const;
+
+private:
+    void Run();
+    void Sample();
+    void SampleProcess(double elapsedSeconds);
+    void DetectCgroup();
+    void SampleCgroup(double elapsedSeconds);
+    void SampleHostCpu();
+    void SampleThreads(double elapsedSeconds);
+    void SampleHostIo(double elapsedSeconds);
+    void SamplePressure();
+    void SampleAllocator();
+
+    // Cumulative counters of one thread at the previous sample
+    struct ThreadCounters
+    {
+        uint64 CpuTicks = 0;
+        uint64 VoluntaryCtxSwitches = 0;
+        uint64 InvoluntaryCtxSwitches = 0;
+    };
+
+    struct DiskCounters
+    {
+        uint64 Reads = 0, ReadSectors = 0, ReadMs = 0;
+        uint64 Writes = 0, WriteSectors = 0, WriteMs = 0;
+        uint64 IoTicksMs = 0;
+    };
+
+    struct NetCounters
+    {
+        uint64 RxBytes = 0, RxPackets = 0, RxErrors = 0, RxDrops = 0;
+        uint64 TxBytes = 0, TxPackets = 0, TxErrors = 0, TxDrops = 0;
+    };
+
+    // Raw jiffies of one /proc/stat cpu line
+    struct CpuTimes
+    {
+        bool Present = false;
+        uint64 User = 0, Nice = 0, System = 0, Idle = 0, Iowait = 0, Irq = 0, Softirq = 0, Steal = 0;
+
+        uint64 Sum() const { return User + Nice + System + Idle + Iowait + Irq + Softirq + Steal; }
+    };
+
+    static CpuUtilization ComputeUtilization(CpuTimes const& previous, CpuTimes const& current);
+
+    uint32 _intervalMs;
+    uint32 _historySize;
+    uint32 _sampleCount;
+    std::chrono::steady_clock::time_point _lastSampleTime;
+
+    std::thread _thread;
+    std::mutex _stopMutex;
+    std::condition_variable _stopCondition;
+    bool _stopping;
+
+    std::string _cgroupDir;
+    CpuTimes _prevCpuTotal;
+    std::vector<CpuTimes> _prevCpuCores;  // indexed by cpu id
+    std::unordered_map<uint32, ThreadCounters> _prevThreads;
+    std::unordered_map<std::string, DiskCounters> _prevDisks;
+    std::unordered_map<std::string, NetCounters> _prevInterfaces;
+
+    mutable std::mutex _metricsMutex;
+    ProcessMetrics _process;
+    CgroupMetrics _cgroup;
+    HostCpuMetrics _hostCpu;
+    ProcessThreadMetrics _threads;
+    HostIoMetrics _hostIo;
+    PressureMetrics _pressure;
+    std::vector<PressureTrigger> _pressureTriggers;
+    std::deque<PressureEvent> _pressureEvents;
+    uint32 _pressureEventHistorySize;
+    uint64 _pressureEventCount;
+    uint32 _allocatorIntervalSeconds;
+    std::chrono::steady_clock::time_point _lastAllocatorSample;
+    std::deque<AllocatorSample> _allocatorHistory;
+    std::deque<CpuSeriesSample> _cpuHistory;
+};
+
+#endif // GAMESTATEAPI_SYSTEMMETRICS_H
@@ -4,6 +4,7 @@
 
 // From our module
 void AddGameStateAPIScripts();
+void AddGameStateEventScripts();
 
 // Add all
 // cf. the naming convention https://github.com/azerothcore/azerothcore-wotlk/blob/master/doc/changelog/master.md#how-to-upgrade-4
@@ -11,5 +12,6 @@ void AddGameStateAPIScripts();
 void Addmod_game_state_apiScripts()
 {
     AddGameStateAPIScripts();
+    AddGameStateEventScripts();
 }
 